@@ -184,6 +184,7 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_DTYPE_MAT2 = 31
         DVZ_DTYPE_MAT3 = 32
         DVZ_DTYPE_MAT4 = 33
+        DVZ_DTYPE_DVEC3_HILO = 34
 
     ctypedef enum DvzArrayCopyType:
         DVZ_ARRAY_COPY_NONE = 0
@@ -533,6 +534,7 @@ cdef extern from "<datoviz/datoviz.h>":
     ctypedef enum DvzGraphicsFlags:
         DVZ_GRAPHICS_FLAGS_DEPTH_TEST_DISABLE = 0x0000
         DVZ_GRAPHICS_FLAGS_DEPTH_TEST_ENABLE = 0x0100
+        DVZ_GRAPHICS_FLAGS_DOUBLE_POS = 0x0200
 
     ctypedef enum DvzMarkerType:
         DVZ_MARKER_DISC = 0
@@ -573,6 +575,13 @@ cdef extern from "<datoviz/datoviz.h>":
         DVZ_PATH_OPEN = 0
         DVZ_PATH_CLOSED = 1
 
+    ctypedef enum DvzSpecializationConstant:
+        DVZ_SPECIALIZATION_CLIP = 0
+        DVZ_SPECIALIZATION_INTERACT_AXIS = 1
+        DVZ_SPECIALIZATION_MARKER_TYPE = 2
+        DVZ_SPECIALIZATION_CAP_TYPE = 3
+        DVZ_SPECIALIZATION_ROUND_JOIN = 4
+
     # from file: keycode.h
 
     ctypedef enum DvzKeyCode:
@@ -23,7 +23,10 @@
 static TestCase TEST_CASES[] = {
 
     // common tests
-    CASE_FIXTURE_NONE(test_container),
+    CASE_FIXTURE_NONE(test_container),         //
+    CASE_FIXTURE_NONE(test_container_collect), //
+    CASE_FIXTURE_NONE(test_png),               //
+    CASE_FIXTURE_NONE(test_png_bench),         //
 
     // vklite2
     CASE_FIXTURE_NONE(test_vklite_app),            //
@@ -44,6 +47,7 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_basic_canvas_1),        //
     CASE_FIXTURE_NONE(test_basic_canvas_triangle), //
     CASE_FIXTURE_NONE(test_shader_compile),        //
+    CASE_FIXTURE_NONE(test_shader_cache),          //
 
     // context
     CASE_FIXTURE_NONE(test_fifo_1),      //
@@ -66,8 +70,15 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_canvas_append),           //
     CASE_FIXTURE_NONE(test_canvas_particles),        //
     CASE_FIXTURE_NONE(test_canvas_offscreen),        //
+    CASE_FIXTURE_NONE(test_canvas_batch),            //
+    CASE_FIXTURE_NONE(test_canvas_pipeline_cache),   //
+    CASE_FIXTURE_NONE(test_canvas_prewarm),          //
     CASE_FIXTURE_NONE(test_canvas_gui_1),            //
     CASE_FIXTURE_NONE(test_canvas_screencast),       //
+    CASE_FIXTURE_NONE(test_canvas_screencast_yuv),   //
+    CASE_FIXTURE_NONE(test_canvas_screenshot),       //
+    CASE_FIXTURE_NONE(test_canvas_video_convert),    //
+    CASE_FIXTURE_NONE(test_canvas_video_encoder),    //
 
     // graphics
     CASE_FIXTURE_NONE(test_graphics_dynamic), //
@@ -84,7 +95,8 @@ static TestCase TEST_CASES[] = {
 #if !OS_MACOS
     CASE_FIXTURE_NONE(test_graphics_triangle_fan), //
 #endif
-    CASE_FIXTURE_NONE(test_graphics_marker_1), //
+    CASE_FIXTURE_NONE(test_graphics_marker_1),       //
+    CASE_FIXTURE_NONE(test_graphics_marker_variant), //
 
     // generate marker screenshots:
     CASE_FIXTURE_NONE(test_graphics_marker_screenshots), //
@@ -92,6 +104,7 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_graphics_segment),    //
     CASE_FIXTURE_NONE(test_graphics_path),       //
     CASE_FIXTURE_NONE(test_graphics_text),       //
+    CASE_FIXTURE_NONE(test_graphics_font_sdf),   //
     CASE_FIXTURE_NONE(test_graphics_image_1),    //
     CASE_FIXTURE_NONE(test_graphics_image_cmap), //
 
@@ -105,6 +118,8 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_transforms_3), //
     CASE_FIXTURE_NONE(test_transforms_4), //
     CASE_FIXTURE_NONE(test_transforms_5), //
+    CASE_FIXTURE_NONE(test_transforms_6), //
+    CASE_FIXTURE_NONE(test_transforms_7), //
 
     // array
     CASE_FIXTURE_NONE(test_array_1),    //
@@ -119,11 +134,14 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_array_3D),   //
 
     // visuals
-    CASE_FIXTURE_NONE(test_visuals_1), //
-    CASE_FIXTURE_NONE(test_visuals_2), //
-    CASE_FIXTURE_NONE(test_visuals_3), //
-    CASE_FIXTURE_NONE(test_visuals_4), //
-    CASE_FIXTURE_NONE(test_visuals_5), //
+    CASE_FIXTURE_NONE(test_visuals_1),      //
+    CASE_FIXTURE_NONE(test_visuals_2),      //
+    CASE_FIXTURE_NONE(test_visuals_3),      //
+    CASE_FIXTURE_NONE(test_visuals_4),      //
+    CASE_FIXTURE_NONE(test_visuals_5),      //
+    CASE_FIXTURE_NONE(test_visuals_bounds), //
+    CASE_FIXTURE_NONE(test_visuals_lookup), //
+    CASE_FIXTURE_NONE(test_visuals_cull),   //
 
     // interact
     CASE_FIXTURE_NONE(test_interact_1),       //
@@ -138,6 +156,7 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_visuals_point),          //
     CASE_FIXTURE_NONE(test_visuals_line),           //
     CASE_FIXTURE_NONE(test_visuals_line_strip),     //
+    CASE_FIXTURE_NONE(test_visuals_line_stream),    //
     CASE_FIXTURE_NONE(test_visuals_triangle),       //
     CASE_FIXTURE_NONE(test_visuals_triangle_strip), //
 #if !OS_MACOS
@@ -151,19 +170,26 @@ static TestCase TEST_CASES[] = {
     CASE_FIXTURE_NONE(test_visuals_image_cmap),     //
     CASE_FIXTURE_NONE(test_visuals_axes_2D_1),      //
     CASE_FIXTURE_NONE(test_visuals_axes_2D_update), //
+    CASE_FIXTURE_NONE(test_visuals_text),           //
+    CASE_FIXTURE_NONE(test_visuals_text_empty),     //
 
     CASE_FIXTURE_NONE(test_visuals_mesh),         //
     CASE_FIXTURE_NONE(test_visuals_volume_1),     //
     CASE_FIXTURE_NONE(test_visuals_volume_slice), //
 
     // axes
-    CASE_FIXTURE_NONE(test_axes_1), //
-    CASE_FIXTURE_NONE(test_axes_2), //
-    CASE_FIXTURE_NONE(test_axes_3), //
+    CASE_FIXTURE_NONE(test_axes_1),      //
+    CASE_FIXTURE_NONE(test_axes_2),      //
+    CASE_FIXTURE_NONE(test_axes_3),      //
+    CASE_FIXTURE_NONE(test_axes_bench),  //
+    CASE_FIXTURE_NONE(test_axes_labels), //
+    CASE_FIXTURE_NONE(test_axes_worker), //
 
     // scene
     CASE_FIXTURE_NONE(test_scene_0),        //
     CASE_FIXTURE_NONE(test_scene_1),        //
+    CASE_FIXTURE_NONE(test_scene_indirect), //
+    CASE_FIXTURE_NONE(test_scene_coalesce), //
     CASE_FIXTURE_NONE(test_scene_mesh),     //
     CASE_FIXTURE_NONE(test_scene_axes),     //
     CASE_FIXTURE_NONE(test_scene_logistic), //
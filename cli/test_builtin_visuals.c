@@ -256,6 +256,93 @@ int test_visuals_line_strip(TestContext* context)
 
 
 
+static void _line_stream_frame(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    DvzVisual* visual = ev.user_data;
+    ASSERT(visual != NULL);
+
+    // Write a few new samples at every frame.
+    const uint32_t n = 8;
+    float values[8] = {0};
+    double t = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        t = (ev.u.f.idx * n + i) / 100.0;
+        values[i] = .5 * sin(M_2PI * t) + .1 * dvz_rand_normal();
+    }
+    dvz_visual_data_ring(visual, DVZ_PROP_VALUE, 0, n, values);
+    dvz_visual_update(visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+
+    // The color is not streamed, the new samples must be drawn with the default color.
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    uint32_t capacity = visual->ring.capacity;
+    DvzGraphicsLineStreamVertex* vertex =
+        dvz_array_item(&source->arr, (visual->ring.head + capacity - 1) % capacity);
+    ASSERT(vertex->y == values[n - 1]);
+    ASSERT(vertex->color[0] == 200 && vertex->color[3] == 255);
+}
+
+int test_visuals_line_stream(TestContext* context)
+{
+    INIT;
+
+    DvzVisual visual = dvz_visual(canvas);
+    dvz_visual_builtin(&visual, DVZ_VISUAL_LINE_STREAM, 0);
+
+    const uint32_t N = 1000;
+    dvz_visual_ring(&visual, N);
+    AT(visual.ring.capacity == N);
+
+    // Write more samples than the capacity: only the last ones are kept.
+    float* values = calloc(N + 10, sizeof(float));
+    for (uint32_t i = 0; i < N + 10; i++)
+        values[i] = i;
+    dvz_visual_data_ring(&visual, DVZ_PROP_VALUE, 0, N + 10, values);
+    AT(visual.ring.pending == N);
+
+    DvzProp* prop = dvz_prop_get(&visual, DVZ_PROP_VALUE, 0);
+    AT(((float*)prop->arr_orig.data)[0] == 10);
+    AT(((float*)prop->arr_orig.data)[N - 1] == N + 9);
+
+    vec2 yrange = {0, N + 10};
+    dvz_visual_data(&visual, DVZ_PROP_RANGE, 0, 1, yrange);
+
+    // First update: the whole ring buffer is baked and uploaded.
+    _common_data(&visual);
+    AT(visual.ring.head == 0);
+    AT(visual.ring.count == N);
+
+    // The samples are baked with the default color.
+    DvzGraphicsLineStreamVertex* vertices =
+        dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0)->arr.data;
+    AT(vertices[0].color[0] == 200 && vertices[0].color[3] == 255);
+    AT(vertices[N - 1].color[0] == 200 && vertices[N - 1].color[3] == 255);
+
+    // Wrap around the ring.
+    dvz_visual_data_ring(&visual, DVZ_PROP_VALUE, 0, 3, values);
+    AT(((float*)prop->arr_orig.data)[2] == 2);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(visual.ring.head == 3);
+    AT(visual.ring.count == N);
+
+    // The vertex count is constant and equal to the capacity.
+    AT(dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0)->arr.item_count == N);
+
+    yrange[0] = -1;
+    yrange[1] = +1;
+    dvz_visual_data(&visual, DVZ_PROP_RANGE, 0, 1, yrange);
+
+    dvz_event_callback(
+        canvas, DVZ_EVENT_FRAME, 0, DVZ_EVENT_MODE_SYNC, _line_stream_frame, &visual);
+    dvz_event_callback(canvas, DVZ_EVENT_REFILL, 0, DVZ_EVENT_MODE_SYNC, _resize, NULL);
+    dvz_app_run(app, N_FRAMES);
+    FREE(values);
+    END;
+}
+
+
+
 int test_visuals_triangle(TestContext* context)
 {
     INIT;
@@ -394,6 +481,10 @@ int test_visuals_axes_2D_1(TestContext* context)
     DvzVisual visual = dvz_visual(canvas);
     dvz_visual_builtin(&visual, DVZ_VISUAL_AXES_2D, DVZ_AXES_COORD_X);
 
+    // Outside of the axes controller, the clip mode is taken from the viewport.
+    AT(visual.graphics[0]->specialization.count == 0);
+    AT(visual.graphics[1]->specialization.count == 0);
+
     // Font atlas texture.
     dvz_visual_texture(&visual, DVZ_SOURCE_TYPE_FONT_ATLAS, 0, atlas->texture);
 
@@ -546,6 +637,116 @@ int test_visuals_axes_2D_update(TestContext* context)
 
 
 
+/*************************************************************************************************/
+/*  Text visual tests                                                                            */
+/*************************************************************************************************/
+
+int test_visuals_text(TestContext* context)
+{
+    INIT;
+    dvz_canvas_clear_color(canvas, 1, 1, 1);
+
+    DvzVisual visual = dvz_visual(canvas);
+    dvz_visual_builtin(&visual, DVZ_VISUAL_TEXT, 0);
+
+    // One label per point, on a spiral.
+    const uint32_t N = 1000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    float* size = calloc(N, sizeof(float));
+    char** text = calloc(N, sizeof(char*));
+    char* buf = calloc(N, 8);
+    double t = 0;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        t = i / (double)N;
+        pos[i][0] = .9 * t * cos(8 * M_2PI * t);
+        pos[i][1] = .9 * t * sin(8 * M_2PI * t);
+        dvz_colormap_scale(DVZ_CMAP_VIRIDIS, t, 0, 1, color[i]);
+        size[i] = 8 + 8 * t;
+        snprintf(&buf[8 * i], 8, "%d", i);
+        text[i] = &buf[8 * i];
+    }
+
+    // Set visual data.
+    dvz_visual_data(&visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(&visual, DVZ_PROP_COLOR, 0, N, color);
+    dvz_visual_data(&visual, DVZ_PROP_TEXT_SIZE, 0, N, size);
+    dvz_visual_data(&visual, DVZ_PROP_TEXT, 0, N, text);
+    vec2 anchor = {-1, 0};
+    dvz_visual_data(&visual, DVZ_PROP_ANCHOR, 0, 1, anchor);
+
+    _common_data(&visual);
+    DvzSource* source = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    uint32_t vertex_count = source->arr.item_count;
+    AT(vertex_count > 4 * N);
+    AT(!source->partial);
+
+    // Changing a label without changing its number of glyphs only lays out that label.
+    text[N - 1] = "abc";
+    dvz_visual_data(&visual, DVZ_PROP_TEXT, 0, N, text);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(source->partial);
+    AT(source->arr.item_count == vertex_count);
+
+    // Otherwise, all labels are laid out again.
+    text[0] = "first";
+    dvz_visual_data(&visual, DVZ_PROP_TEXT, 0, N, text);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(!source->partial);
+    AT(source->arr.item_count == vertex_count + 4 * 4);
+
+    dvz_event_callback(canvas, DVZ_EVENT_REFILL, 0, DVZ_EVENT_MODE_SYNC, _resize, NULL);
+    dvz_app_run(app, N_FRAMES);
+    SCREENSHOT("text")
+    FREE(pos);
+    FREE(color);
+    FREE(size);
+    FREE(text);
+    FREE(buf);
+    END;
+}
+
+
+
+int test_visuals_text_empty(TestContext* context)
+{
+    INIT;
+
+    DvzVisual visual = dvz_visual(canvas);
+    dvz_visual_builtin(&visual, DVZ_VISUAL_TEXT, 0);
+
+    const uint32_t N = 3;
+    dvec3 pos[3] = {{-.5, 0, 0}, {0, 0, 0}, {+.5, 0, 0}};
+    char* text[3] = {"a", "bc", "def"};
+    dvz_visual_data(&visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(&visual, DVZ_PROP_TEXT, 0, N, text);
+
+    _common_data(&visual);
+    DvzSource* source = dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(source->arr.item_count == 4 * 6);
+
+    // Clearing all labels removes the glyphs that were shown.
+    for (uint32_t i = 0; i < N; i++)
+        text[i] = "";
+    dvz_visual_data(&visual, DVZ_PROP_TEXT, 0, N, text);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(source->arr.item_count == 0);
+    AT(visual.text_labels == NULL);
+
+    // The labels can be set again afterwards.
+    text[1] = "xyz";
+    dvz_visual_data(&visual, DVZ_PROP_TEXT, 0, N, text);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(source->arr.item_count == 4 * 3);
+
+    dvz_event_callback(canvas, DVZ_EVENT_REFILL, 0, DVZ_EVENT_MODE_SYNC, _resize, NULL);
+    dvz_app_run(app, N_FRAMES);
+    END;
+}
+
+
+
 /*************************************************************************************************/
 /* Path visual tests                                                                            */
 /*************************************************************************************************/
@@ -20,6 +20,7 @@
 int test_visuals_point(TestContext* context);
 int test_visuals_line(TestContext* context);
 int test_visuals_line_strip(TestContext* context);
+int test_visuals_line_stream(TestContext* context);
 int test_visuals_triangle(TestContext* context);
 int test_visuals_triangle_strip(TestContext* context);
 int test_visuals_triangle_fan(TestContext* context);
@@ -28,6 +29,8 @@ int test_visuals_triangle_fan(TestContext* context);
 int test_visuals_marker(TestContext* context);
 int test_visuals_axes_2D_1(TestContext* context);
 int test_visuals_axes_2D_update(TestContext* context);
+int test_visuals_text(TestContext* context);
+int test_visuals_text_empty(TestContext* context);
 int test_visuals_path(TestContext* context);
 int test_visuals_polygon(TestContext* context);
 int test_visuals_image_1(TestContext* context);
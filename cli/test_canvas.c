@@ -2,6 +2,7 @@
 #include "../include/datoviz/canvas.h"
 #include "../include/datoviz/context.h"
 #include "../include/datoviz/controls.h"
+#include "../external/video.h"
 #include "../src/vklite_utils.h"
 #include "utils.h"
 
@@ -1165,6 +1166,169 @@ int test_canvas_offscreen(TestContext* context)
 
 
 
+static uint32_t _batch_count;
+
+static void _batch_callback(DvzCanvas* canvas, uint32_t idx, void* user_data)
+{
+    ASSERT(canvas != NULL);
+    _batch_count++;
+    // Red figures on the first canvas, blue figures on the second one.
+    if (canvas->frame_idx == 0)
+        dvz_canvas_clear_color(canvas, idx % 2 == 0 ? 1 : 0, 0, idx % 2 == 0 ? 0 : 1);
+}
+
+int test_canvas_batch(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+
+    // Remove the figures of a previous run.
+    char path[1024] = {0};
+    for (uint32_t i = 0; i < 12; i++)
+    {
+        snprintf(path, sizeof(path), "%s/batch_%02d.png", ARTIFACTS_DIR, i);
+        remove(path);
+    }
+
+    char format[1024] = {0};
+    snprintf(format, sizeof(format), "%s/batch_%%02d.png", ARTIFACTS_DIR);
+    DvzBatchStats stats = dvz_app_batch(app, 12, _batch_callback, NULL, format, 2);
+    AT(_batch_count == 12);
+    AT(stats.figure_count == 12);
+    AT(stats.canvas_count == 2);
+    AT(stats.fps > 0);
+
+    // All figures have been written once the batch returns, with the clear color of their
+    // canvas: the figures are distributed in turn to the two canvases.
+    int w = 0, h = 0, n = 0;
+    uint8_t* rgb = NULL;
+    for (uint32_t i = 0; i < 12; i++)
+    {
+        snprintf(path, sizeof(path), "%s/batch_%02d.png", ARTIFACTS_DIR, i);
+        AT(file_exists(path));
+        if (i % 5 != 0)
+            continue;
+        rgb = stbi_load(path, &w, &h, &n, 3);
+        AT(rgb != NULL);
+        AT(w > 0 && h > 0);
+        AT(rgb[0] == (i % 2 == 0 ? 255 : 0));
+        AT(rgb[1] == 0);
+        AT(rgb[2] == (i % 2 == 0 ? 0 : 255));
+        stbi_image_free(rgb);
+    }
+
+    TEST_END
+}
+
+
+
+// Time to create an offscreen canvas with all builtin graphics pipelines.
+static double _canvas_startup(bool cold)
+{
+    DvzClock clock = {0};
+    _clock_init(&clock);
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+
+    // Remove the cache file before the GPU is created.
+    char path[1024] = {0};
+    if (cold && pipeline_cache_path(gpu, path, sizeof(path)) == 0)
+        remove(path);
+
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    const DvzGraphicsType types[] = {
+        DVZ_GRAPHICS_POINT,        DVZ_GRAPHICS_LINE,         DVZ_GRAPHICS_LINE_STRIP,
+        DVZ_GRAPHICS_TRIANGLE,     DVZ_GRAPHICS_MARKER,       DVZ_GRAPHICS_SEGMENT,
+        DVZ_GRAPHICS_PATH,         DVZ_GRAPHICS_TEXT,         DVZ_GRAPHICS_IMAGE,
+        DVZ_GRAPHICS_IMAGE_CMAP,   DVZ_GRAPHICS_VOLUME_SLICE, DVZ_GRAPHICS_VOLUME,
+        DVZ_GRAPHICS_MESH,         DVZ_GRAPHICS_LINE_STREAM};
+    for (uint32_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+        dvz_graphics_builtin(canvas, types[i], 0);
+    double elapsed = _clock_get(&clock);
+
+    // The cache file is loaded at the warm start, and saved at the cold start.
+    bool ok = cold ? gpu->pipeline_cache_size == 0 : gpu->pipeline_cache_size > 0;
+    dvz_app_destroy(app);
+    return ok ? elapsed : -1;
+}
+
+int test_canvas_pipeline_cache(TestContext* context)
+{
+    char dir[1024] = {0};
+    snprintf(dir, sizeof(dir), "%s/cache", ARTIFACTS_DIR);
+    setenv("DVZ_CACHE_DIR", dir, 1);
+
+    double cold = _canvas_startup(true);
+    double warm = _canvas_startup(false);
+    log_info("canvas startup: cold %.1f ms, warm %.1f ms", cold * 1000, warm * 1000);
+    AT(cold > 0);
+    AT(warm > 0);
+
+    unsetenv("DVZ_CACHE_DIR");
+    return 0;
+}
+
+static double _canvas_prewarm(bool prewarm)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+
+    const DvzGraphicsType types[] = {
+        DVZ_GRAPHICS_POINT,        DVZ_GRAPHICS_LINE,         DVZ_GRAPHICS_LINE_STRIP,
+        DVZ_GRAPHICS_TRIANGLE,     DVZ_GRAPHICS_MARKER,       DVZ_GRAPHICS_SEGMENT,
+        DVZ_GRAPHICS_PATH,         DVZ_GRAPHICS_TEXT,         DVZ_GRAPHICS_IMAGE,
+        DVZ_GRAPHICS_IMAGE_CMAP,   DVZ_GRAPHICS_VOLUME_SLICE, DVZ_GRAPHICS_VOLUME,
+        DVZ_GRAPHICS_MESH,         DVZ_GRAPHICS_LINE_STREAM,  DVZ_GRAPHICS_MARKER};
+    const uint32_t n = sizeof(types) / sizeof(types[0]);
+    int flags[sizeof(types) / sizeof(types[0])] = {0};
+    flags[n - 1] = DVZ_GRAPHICS_FLAGS_DEPTH_TEST_ENABLE;
+
+    DvzClock clock = {0};
+    _clock_init(&clock);
+    if (prewarm)
+        dvz_graphics_prewarm(canvas, n, types, flags, 0);
+    DvzGraphics* graphics = NULL;
+    bool ok = true;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        graphics = dvz_graphics_builtin(canvas, types[i], flags[i]);
+        ok &= dvz_obj_is_created(&graphics->obj);
+    }
+    double elapsed = _clock_get(&clock);
+
+    // The prewarmed graphics are reused, and no graphics is created twice.
+    uint32_t count = 0;
+    DvzContainerIterator iter = dvz_container_iterator(&canvas->graphics);
+    while (iter.item != NULL)
+    {
+        count++;
+        dvz_container_iter(&iter);
+    }
+    ok &= count == n;
+    dvz_app_destroy(app);
+    return ok ? elapsed : -1;
+}
+
+int test_canvas_prewarm(TestContext* context)
+{
+    // Disable the persistent pipeline cache so that both runs compile all pipelines.
+    setenv("DVZ_PIPELINE_CACHE", "0", 1);
+
+    double serial = _canvas_prewarm(false);
+    double prewarm = _canvas_prewarm(true);
+    log_info("canvas pipelines: serial %.1f ms, prewarm %.1f ms", serial * 1000, prewarm * 1000);
+    AT(serial > 0);
+    AT(prewarm > 0);
+
+    unsetenv("DVZ_PIPELINE_CACHE");
+    return 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  Canvas GUI                                                                                   */
 /*************************************************************************************************/
@@ -1227,13 +1391,19 @@ int test_canvas_gui_1(TestContext* context)
 /*  Canvas screencast                                                                            */
 /*************************************************************************************************/
 
+static uint64_t _screencast_count;
+static bool _screencast_ordered = true;
+
 static void _screencast_callback(DvzCanvas* canvas, DvzEvent ev)
 {
+    // The frames are read back in order, even with several copies in flight.
+    _screencast_ordered &= ev.u.sc.idx == _screencast_count++;
+
     char path[1024];
     snprintf(path, sizeof(path), "%s/screencast_%02d.ppm", ARTIFACTS_DIR, (int)ev.u.sc.idx);
     log_info("screencast frame #%d %d %s", ev.u.sc.idx, ev.u.sc.rgba[0], path);
     dvz_write_ppm(path, ev.u.sc.width, ev.u.sc.height, ev.u.sc.rgba);
-    FREE(ev.u.sc.rgba);
+    dvz_screencast_release(canvas, ev.u.sc.rgba);
 }
 
 int test_canvas_screencast(TestContext* context)
@@ -1250,5 +1420,217 @@ int test_canvas_screencast(TestContext* context)
     dvz_screencast(canvas, 1. / 30, false);
 
     dvz_app_run(app, N_FRAMES);
+    AT(_screencast_count > 0);
+    AT(_screencast_ordered);
+
+    // All frame buffers have been released to the pool.
+    for (uint32_t i = 0; i < DVZ_SCREENCAST_POOL_SIZE; i++)
+        AT(!atomic_load(&canvas->screencast->frames[i].in_use));
+    TEST_END
+}
+
+
+
+int test_canvas_video_convert(TestContext* context)
+{
+    // Odd size: the last row and column of chroma samples only cover one pixel.
+    const int w = 7, h = 5;
+    const int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    uint8_t rgba[7 * 5 * 4] = {0};
+    for (int i = 0; i < w * h; i++)
+    {
+        // Red on the left, white in the middle, black on the right.
+        rgba[4 * i + 0] = (i % w) < 4 ? 255 : 0;
+        rgba[4 * i + 1] = (i % w) >= 2 && (i % w) < 4 ? 255 : 0;
+        rgba[4 * i + 2] = (i % w) >= 2 && (i % w) < 4 ? 255 : 0;
+        rgba[4 * i + 3] = 255;
+    }
+
+    uint8_t y[7 * 5] = {0}, u[4 * 3] = {0}, v[4 * 3] = {0};
+    const int linesizes[3] = {w, cw, cw};
+    uint8_t* planes[3] = {y, u, v};
+    rgba_to_yuv420p(rgba, w, h, planes, linesizes);
+
+    // BT.601 limited range values of red, white, and black.
+    AT(y[0] == 82 && u[0] == 90 && v[0] == 240);
+    AT(y[2] == 235 && u[1] == 128 && v[1] == 128);
+    AT(y[6] == 16 && u[3] == 128 && v[3] == 128);
+    AT(y[(h - 1) * w + 6] == 16 && u[(ch - 1) * cw + 3] == 128);
+    return 0;
+}
+
+
+
+// Release the frames of a video encoder whose queue was marked as full by the test.
+static void* _video_unblock(void* user_data)
+{
+    DvzVideoEncoder* encoder = (DvzVideoEncoder*)user_data;
+    ASSERT(encoder != NULL);
+    dvz_sleep(100);
+    pthread_mutex_lock(&encoder->lock);
+    encoder->stats.queue_depth = 0;
+    pthread_cond_broadcast(&encoder->cond);
+    pthread_mutex_unlock(&encoder->lock);
+    return NULL;
+}
+
+// Wait until the video encoder thread has encoded all frames of the queue.
+static DvzVideoStats _video_wait(DvzCanvas* canvas)
+{
+    DvzVideoStats stats = dvz_canvas_video_stats(canvas);
+    for (uint32_t i = 0; i < 1000 && stats.queue_depth > 0; i++)
+    {
+        dvz_sleep(1);
+        stats = dvz_canvas_video_stats(canvas);
+    }
+    return stats;
+}
+
+int test_canvas_video_encoder(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    dvz_canvas_clear_color(canvas, 1, 0, 0);
+
+    char path[1024] = {0};
+    snprintf(path, sizeof(path), "%s/video.mp4", ARTIFACTS_DIR);
+    dvz_canvas_video(canvas, 1000, 10000000, path, true);
+    if (canvas->screencast == NULL || canvas->screencast->user_data == NULL)
+    {
+        log_warn("skip the video encoder test, datoviz was not compiled with ffmpeg support");
+        TEST_END
+    }
+    DvzVideoEncoder* encoder = (DvzVideoEncoder*)canvas->screencast->user_data;
+
+    // DROP: all frames are dropped while the queue is full.
+    dvz_canvas_video_backpressure(canvas, DVZ_VIDEO_BACKPRESSURE_DROP);
+    pthread_mutex_lock(&encoder->lock);
+    encoder->stats.queue_depth = DVZ_VIDEO_QUEUE_SIZE;
+    pthread_mutex_unlock(&encoder->lock);
+    dvz_app_run(app, 20);
+    DvzVideoStats stats = dvz_canvas_video_stats(canvas);
+    AT(stats.frames_encoded == 0);
+    AT(stats.frames_dropped > 0);
+    AT(stats.queue_depth == DVZ_VIDEO_QUEUE_SIZE);
+    uint64_t dropped = encoder->stats.frames_dropped;
+    AT(dropped > 0);
+
+    // BLOCK: the producer waits for the encoder, no frame is dropped by the backpressure.
+    dvz_canvas_video_backpressure(canvas, DVZ_VIDEO_BACKPRESSURE_BLOCK);
+    DvzThread thread = dvz_thread(_video_unblock, encoder);
+    dvz_app_run(app, 20);
+    dvz_thread_join(&thread);
+    stats = _video_wait(canvas);
+    AT(stats.queue_depth == 0);
+    AT(stats.frames_encoded > 0);
+    AT(encoder->stats.frames_dropped == dropped);
+
+    // The latencies are measured for every encoded frame.
+    AT(stats.latency_last > 0);
+    AT(stats.latency_mean > 0);
+    AT(stats.latency_max >= stats.latency_mean);
+
+    dvz_canvas_stop(canvas);
+    AT(dvz_canvas_video_stats(canvas).frames_encoded == 0);
+    TEST_END
+}
+
+
+
+static uint64_t _screencast_yuv_count;
+static bool _screencast_yuv_ok = true;
+
+static void _screencast_yuv_callback(DvzCanvas* canvas, DvzEvent ev)
+{
+    DvzScreencastEvent sc = ev.u.sc;
+    uint32_t ch = (sc.height + 1) / 2;
+    uint8_t* y = sc.rgba;
+    uint8_t* u = y + sc.linesizes[0] * sc.height;
+    uint8_t* v = u + sc.linesizes[1] * ch;
+
+    // The canvas is cleared in red: first and last pixels of each plane.
+    _screencast_yuv_ok &= sc.yuv;
+    _screencast_yuv_ok &= sc.linesizes[0] >= sc.width && sc.linesizes[1] >= (sc.width + 1) / 2;
+    _screencast_yuv_ok &= y[0] == 82 && u[0] == 90 && v[0] == 240;
+    _screencast_yuv_ok &= y[(sc.height - 1) * sc.linesizes[0] + sc.width - 1] == 82;
+    _screencast_yuv_ok &= v[(ch - 1) * sc.linesizes[2] + (sc.width + 1) / 2 - 1] == 240;
+    _screencast_yuv_count++;
+    dvz_screencast_release(canvas, sc.rgba);
+}
+
+int test_canvas_screencast_yuv(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    dvz_canvas_clear_color(canvas, 1, 0, 0);
+
+    dvz_event_callback(
+        canvas, DVZ_EVENT_SCREENCAST, 0, DVZ_EVENT_MODE_SYNC, _screencast_yuv_callback, NULL);
+
+    dvz_screencast(canvas, 1. / 30, false);
+    dvz_screencast_yuv(canvas, true);
+
+    dvz_app_run(app, N_FRAMES);
+    AT(_screencast_yuv_count > 0);
+    AT(_screencast_yuv_ok);
+    TEST_END
+}
+
+
+
+/*************************************************************************************************/
+/*  Canvas screenshot                                                                            */
+/*************************************************************************************************/
+
+static uint32_t _screenshot_count;
+
+static void _screenshot_callback(
+    DvzCanvas* canvas, uint8_t* rgb, uint32_t width, uint32_t height, void* user_data)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(rgb != NULL);
+    bool* ok = (bool*)user_data;
+    DvzImages* images = canvas->swapchain.images;
+
+    // The canvas is cleared in red.
+    *ok &= width == images->width && height == images->height;
+    *ok &= rgb[0] == 255 && rgb[1] == 0 && rgb[2] == 0;
+    *ok &= rgb[3 * (width * height - 1)] == 255;
+    _screenshot_count++;
+
+    // Request the next screenshot from the callback.
+    if (_screenshot_count < 3)
+        dvz_screenshot_async(canvas, false, _screenshot_callback, user_data);
+}
+
+int test_canvas_screenshot(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    dvz_canvas_clear_color(canvas, 1, 0, 0);
+
+    // Asynchronous screenshots while the app is running.
+    bool ok = true;
+    AT(dvz_screenshot_async(canvas, false, _screenshot_callback, &ok));
+    AT(!dvz_screenshot_async(canvas, false, _screenshot_callback, &ok));
+    dvz_app_run(app, N_FRAMES);
+    AT(_screenshot_count == 3);
+    AT(ok);
+
+    // Synchronous screenshots reuse the staging image.
+    uint8_t* rgb = dvz_screenshot(canvas, false);
+    AT(rgb != NULL);
+    AT(rgb[0] == 255 && rgb[1] == 0 && rgb[2] == 0);
+    VkImage staging = canvas->screenshot->staging.images[0];
+    FREE(rgb);
+    rgb = dvz_screenshot(canvas, true);
+    AT(rgb != NULL);
+    AT(rgb[3] == 255);
+    AT(canvas->screenshot->staging.images[0] == staging);
+    FREE(rgb);
+
     TEST_END
 }
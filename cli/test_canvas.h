@@ -24,8 +24,15 @@ int test_canvas_depth(TestContext* context);
 int test_canvas_append(TestContext* context);
 int test_canvas_particles(TestContext* context);
 int test_canvas_offscreen(TestContext* context);
+int test_canvas_batch(TestContext* context);
+int test_canvas_pipeline_cache(TestContext* context);
+int test_canvas_prewarm(TestContext* context);
 int test_canvas_gui_1(TestContext* context);
 int test_canvas_screencast(TestContext* context);
+int test_canvas_screencast_yuv(TestContext* context);
+int test_canvas_screenshot(TestContext* context);
+int test_canvas_video_convert(TestContext* context);
+int test_canvas_video_encoder(TestContext* context);
 
 
 
@@ -106,6 +106,68 @@ int test_container(TestContext* context)
 
 
 
+int test_container_collect(TestContext* context)
+{
+    DvzContainer container = dvz_container(4, sizeof(TestObject), 0);
+    TestObject* objects[16] = {0};
+
+    // Allocate enough objects to grow the container twice.
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        objects[i] = dvz_container_alloc(&container);
+        objects[i]->x = i;
+        dvz_obj_created(&objects[i]->obj);
+    }
+    AT(container.capacity == 16);
+    AT(container.count == 16);
+
+    // Item pointers are not invalidated by the reallocations.
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        AT(container.items[i] == objects[i]);
+        AT(objects[i]->x == i);
+    }
+
+    // Destroy the odd objects: they are skipped by the iteration but not freed yet.
+    for (uint32_t i = 1; i < 16; i += 2)
+        dvz_obj_destroyed(&objects[i]->obj);
+    DvzContainerIterator iter = dvz_container_iterator(&container);
+    uint32_t n = 0;
+    while (iter.item != NULL)
+    {
+        AT(((TestObject*)iter.item)->x == 2 * n);
+        n++;
+        dvz_container_iter(&iter);
+    }
+    AT(n == 8);
+    AT(container.count == 16);
+
+    // Free them all at once.
+    AT(dvz_container_collect(&container) == 8);
+    AT(container.count == 8);
+    AT(container.items[1] == NULL);
+    AT(container.items[15] == NULL);
+    AT(dvz_container_collect(&container) == 0);
+
+    // New objects reuse the lowest free slots, without growing the container.
+    TestObject* a = dvz_container_alloc(&container);
+    AT(container.items[1] == a);
+    TestObject* b = dvz_container_alloc(&container);
+    AT(container.items[3] == b);
+    AT(container.capacity == 16);
+    AT(container.count == 10);
+
+    // Destroy all objects.
+    dvz_obj_destroyed(&a->obj);
+    dvz_obj_destroyed(&b->obj);
+    for (uint32_t i = 0; i < 16; i += 2)
+        dvz_obj_destroyed(&objects[i]->obj);
+    dvz_container_destroy(&container);
+    return 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  FIFO queue                                                                                   */
 /*************************************************************************************************/
@@ -232,3 +294,113 @@ int test_fifo_3(TestContext* context)
     dvz_fifo_destroy(&fifo);
     return 0;
 }
+
+
+
+/*************************************************************************************************/
+/*  PNG                                                                                          */
+/*************************************************************************************************/
+
+// Gradients with a checkerboard and some noise.
+static uint8_t* _png_image(uint32_t width, uint32_t height, uint32_t bpp)
+{
+    uint8_t* image = calloc(width * height, bpp);
+    uint8_t* pixel = NULL;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            pixel = &image[bpp * (y * width + x)];
+            pixel[0] = (uint8_t)(x * 255 / width);
+            pixel[1] = (uint8_t)(y * 255 / height);
+            pixel[2] = (uint8_t)(((x / 64 + y / 64) % 2) * 200 + dvz_rand_byte() % 4);
+            if (bpp == 4)
+                pixel[3] = (uint8_t)(255 - x % 256);
+        }
+    }
+    return image;
+}
+
+int test_png(TestContext* context)
+{
+    char path[1024] = {0};
+    snprintf(path, sizeof(path), "%s/test.png", ARTIFACTS_DIR);
+
+    const uint32_t width = 37, height = 101;
+    DvzPngOptions options = dvz_png_options();
+    int w = 0, h = 0, n = 0;
+    uint8_t* decoded = NULL;
+    for (uint32_t bpp = 3; bpp <= 4; bpp++)
+    {
+        uint8_t* image = _png_image(width, height, bpp);
+        options.has_alpha = bpp == 4;
+
+        // All filters, with several levels and bands, decode to the same image.
+        for (uint32_t filter = 0; filter <= DVZ_PNG_FILTER_ADAPTIVE; filter++)
+        {
+            for (uint32_t threads = 1; threads <= 4; threads += 3)
+            {
+                options.filter = (DvzPngFilter)filter;
+                options.compression = threads == 1 ? 9 : 1;
+                options.thread_count = threads;
+                AT(dvz_write_png_options(path, width, height, image, options) == 0);
+
+                decoded = stbi_load(path, &w, &h, &n, 0);
+                AT(decoded != NULL);
+                AT(w == (int)width && h == (int)height && n == (int)bpp);
+                AT(memcmp(decoded, image, width * height * bpp) == 0);
+                stbi_image_free(decoded);
+            }
+        }
+        FREE(image);
+    }
+    return 0;
+}
+
+
+
+int test_png_bench(TestContext* context)
+{
+    char path[1024] = {0};
+    // NOTE: a small image, so that the benchmark runs quickly along with the other tests. The
+    // throughput is only indicative.
+    const uint32_t width = 960, height = 540;
+    uint8_t* image = _png_image(width, height, 3);
+    double size = width * height * 3 / (1024. * 1024.);
+    DvzClock clock = {0};
+
+    snprintf(path, sizeof(path), "%s/bench.ppm", ARTIFACTS_DIR);
+    _clock_init(&clock);
+    AT(dvz_write_ppm(path, width, height, image) == 0);
+    log_info("ppm: %.1f MB/s", size / _clock_get(&clock));
+
+    // Default settings with 1 thread, as libpng, then in parallel, then the fast settings.
+    snprintf(path, sizeof(path), "%s/bench.png", ARTIFACTS_DIR);
+    DvzPngOptions options = dvz_png_options();
+    const int compression[] = {DVZ_PNG_COMPRESSION, DVZ_PNG_COMPRESSION, 1, 0};
+    const DvzPngFilter filter[] = {
+        DVZ_PNG_FILTER_ADAPTIVE, DVZ_PNG_FILTER_ADAPTIVE, DVZ_PNG_FILTER_UP, DVZ_PNG_FILTER_NONE};
+    const uint32_t threads[] = {1, DVZ_PNG_THREADS, DVZ_PNG_THREADS, DVZ_PNG_THREADS};
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        options.compression = compression[i];
+        options.filter = filter[i];
+        options.thread_count = threads[i];
+        _clock_init(&clock);
+        AT(dvz_write_png_options(path, width, height, image, options) == 0);
+        log_info(
+            "png level %d, filter %d, %d thread(s): %.1f MB/s", compression[i], filter[i],
+            threads[i], size / _clock_get(&clock));
+    }
+
+    // The last file written with the fast settings must decode to the image.
+    int w = 0, h = 0, n = 0;
+    uint8_t* decoded = stbi_load(path, &w, &h, &n, 0);
+    AT(decoded != NULL);
+    AT(w == (int)width && h == (int)height && n == 3);
+    AT(memcmp(decoded, image, width * height * 3) == 0);
+    stbi_image_free(decoded);
+
+    FREE(image);
+    return 0;
+}
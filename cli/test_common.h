@@ -11,6 +11,7 @@
 /*************************************************************************************************/
 
 int test_container(TestContext* context);
+int test_container_collect(TestContext* context);
 
 
 
@@ -24,4 +25,13 @@ int test_fifo_3(TestContext* context);
 
 
 
+/*************************************************************************************************/
+/*  PNG                                                                                          */
+/*************************************************************************************************/
+
+int test_png(TestContext* context);
+int test_png_bench(TestContext* context);
+
+
+
 #endif
@@ -1,4 +1,5 @@
 #include "test_graphics.h"
+#include "../include/datoviz/atlas.h"
 #include "../include/datoviz/colormaps.h"
 #include "../include/datoviz/graphics.h"
 #include "../include/datoviz/mesh.h"
@@ -570,6 +571,64 @@ int test_graphics_marker_1(TestContext* context)
 
 
 
+int test_graphics_marker_variant(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+
+    // Marker graphics specialized for a single marker type.
+    DvzSpecialization spec = {0};
+    int32_t marker = DVZ_MARKER_SQUARE;
+    dvz_specialization_constant(&spec, DVZ_SPECIALIZATION_MARKER_TYPE, sizeof(marker), &marker);
+    DvzGraphics* graphics = dvz_graphics_variant(canvas, DVZ_GRAPHICS_MARKER, 0, &spec);
+    AT(dvz_obj_is_created(&graphics->obj));
+
+    // The variants are cached, and distinct from the generic graphics.
+    AT(dvz_graphics_variant(canvas, DVZ_GRAPHICS_MARKER, 0, &spec) == graphics);
+    AT(dvz_graphics_builtin(canvas, DVZ_GRAPHICS_MARKER, 0) != graphics);
+    marker = DVZ_MARKER_DISC;
+    dvz_specialization_constant(&spec, DVZ_SPECIALIZATION_MARKER_TYPE, sizeof(marker), &marker);
+    AT(dvz_graphics_variant(canvas, DVZ_GRAPHICS_MARKER, 0, &spec) != graphics);
+
+    // A single red marker at the center of the canvas.
+    BEGIN_DATA(DvzGraphicsMarkerVertex, 1, NULL)
+    vertices[0].color[0] = 255;
+    vertices[0].color[3] = 255;
+    vertices[0].size = 60;
+    // NOTE: the marker type of the vertices is ignored by the specialized shader.
+    vertices[0].marker = DVZ_MARKER_DISC;
+    END_DATA
+
+    tg.br_params =
+        dvz_ctx_buffers(gpu->context, DVZ_BUFFER_TYPE_UNIFORM, 1, sizeof(DvzGraphicsMarkerParams));
+    BINDINGS_PARAMS
+
+    DvzGraphicsMarkerParams params = {0};
+    params.edge_color[3] = 1;
+    params.edge_width = 1;
+    dvz_upload_buffers(canvas, tg.br_params, 0, sizeof(DvzGraphicsMarkerParams), &params);
+
+    RUN;
+
+    // The pixel near the corner of the marker is in the square, but not in the disc.
+    if (N_FRAMES != 0)
+    {
+        uint8_t* rgb = dvz_screenshot(canvas, false);
+        AT(rgb != NULL);
+        uint32_t width = canvas->swapchain.images->width;
+        uint32_t height = canvas->swapchain.images->height;
+        uint8_t* center = &rgb[3 * (width * (height / 2) + width / 2)];
+        uint8_t* corner = &rgb[3 * (width * (height / 2 + 25) + width / 2 + 25)];
+        AT(center[0] > 250 && center[1] < 5 && center[2] < 5);
+        AT(corner[0] > 250 && corner[1] < 5 && corner[2] < 5);
+        FREE(rgb);
+    }
+    TEST_END
+}
+
+
+
 #define SAVE_MARKER(MARKER, NAME)                                                                 \
     ((DvzGraphicsMarkerVertex*)tg.vertices.data)[0].marker = (MARKER);                            \
     dvz_upload_buffers(                                                                           \
@@ -819,6 +878,64 @@ int test_graphics_text(TestContext* context)
 
 
 
+int test_graphics_font_sdf(TestContext* context)
+{
+    // UTF-8 decoding.
+    const char str[] = "a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80";
+    AT(_utf8_length(str) == 4);
+    uint32_t codepoint = 0;
+    const char* s = str;
+    s += _utf8_decode(s, &codepoint);
+    AT(codepoint == 'a');
+    s += _utf8_decode(s, &codepoint);
+    AT(codepoint == 0xE9);
+    s += _utf8_decode(s, &codepoint);
+    AT(codepoint == 0x20AC);
+    s += _utf8_decode(s, &codepoint);
+    AT(codepoint == 0x1F600);
+    AT(*s == 0);
+
+    // Invalid bytes are decoded as the replacement character.
+    AT(_utf8_decode("\xff", &codepoint) == 1);
+    AT(codepoint == 0xFFFD);
+
+    // Signed distance field of a disk.
+    const uint32_t f = DVZ_FONT_ATLAS_SDF_FACTOR;
+    const uint32_t n = 32;
+    const uint32_t w = f * n;
+    uint8_t* coverage = calloc(w * w, sizeof(uint8_t));
+    float r = w / 4.0, dx = 0, dy = 0;
+    for (uint32_t i = 0; i < w; i++)
+    {
+        for (uint32_t j = 0; j < w; j++)
+        {
+            dx = i + .5 - w / 2.0;
+            dy = j + .5 - w / 2.0;
+            coverage[i * w + j] = dx * dx + dy * dy <= r * r ? 255 : 0;
+        }
+    }
+    uint8_t* sdf = calloc(n * n, 4);
+    _font_sdf(coverage, w, w, f, sdf, 4 * n);
+
+    // Inside, outside, across the edge, and decreasing along a radius.
+    uint8_t* row = &sdf[(n / 2) * 4 * n];
+    uint32_t e = n / 2 + n / 4;
+    AT(row[4 * (n / 2)] == 255);
+    AT(row[0] == 0);
+    AIN(row[4 * (e - 1)], 128, 192);
+    AIN(row[4 * e], 64, 128);
+    for (uint32_t j = n / 2; j < n - 1; j++)
+        AT(row[4 * j] >= row[4 * (j + 1)]);
+    // The distance is copied in the 4 channels.
+    AT(row[4 * e] == row[4 * e + 3]);
+
+    FREE(coverage);
+    FREE(sdf);
+    return 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  Image tests                                                                                  */
 /*************************************************************************************************/
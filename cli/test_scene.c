@@ -2,6 +2,7 @@
 #include "../external/video.h"
 #include "../include/datoviz/builtin_visuals.h"
 #include "../include/datoviz/scene.h"
+#include "../src/axes.h"
 #include "../src/ticks.h"
 #include "utils.h"
 
@@ -108,6 +109,204 @@ int test_axes_3(TestContext* context)
 
 
 
+// Zoom sweep: zoom in and out again around a point, with a small jitter mimicking panzoom.
+static void _axes_sweep(uint32_t i, uint32_t n, double* x0, double* x1)
+{
+    uint32_t k = i < n ? i : 2 * n - 1 - i;
+    double w = 100 * pow(1.07, -(double)k);
+    double jitter = 1e-6 * w * (i % 3);
+    *x0 = 3.3 - .7 * w + jitter;
+    *x1 = 3.3 + 1.3 * w + jitter;
+}
+
+
+
+int test_axes_bench(TestContext* context)
+{
+    DvzAxesContext ctx = {0};
+    ctx.coord = DVZ_AXES_COORD_X;
+    ctx.size_viewport = 1000;
+    ctx.size_glyph = 10;
+    ctx.extensions = 1;
+
+    const uint32_t n = 200;
+    double x0 = 0, x1 = 0;
+    DvzAxesTicks ticks = {0}, cached = {0};
+    DvzTicksCache* cache = calloc(1, sizeof(DvzTicksCache));
+    DvzClock clock = {0};
+
+    // Without cache.
+    _clock_init(&clock);
+    for (uint32_t i = 0; i < 2 * n; i++)
+    {
+        _axes_sweep(i, n, &x0, &x1);
+        ticks = dvz_ticks(x0, x1, ctx);
+        dvz_ticks_destroy(&ticks);
+    }
+    double dt = _clock_get(&clock);
+    log_info("ticks without cache: %.0f ticks/s", 2 * n / dt);
+
+    // With cache: the zoom out sweep hits the cache.
+    _clock_init(&clock);
+    for (uint32_t i = 0; i < 2 * n; i++)
+    {
+        _axes_sweep(i, n, &x0, &x1);
+        ticks = dvz_ticks_cached(cache, x0, x1, ctx);
+        dvz_ticks_destroy(&ticks);
+    }
+    dt = _clock_get(&clock);
+    log_info(
+        "ticks with cache: %.0f ticks/s, %d hits, %d misses", 2 * n / dt, cache->hits,
+        cache->misses);
+    AT(cache->hits > 0);
+    AT(cache->hits + cache->misses == 2 * n);
+
+    // The cached ticks are the same as the computed ones.
+    _axes_sweep(n - 1, n, &x0, &x1);
+    ticks = dvz_ticks(x0, x1, ctx);
+    cached = dvz_ticks_cached(cache, x0, x1, ctx);
+    AT(ticks.value_count == cached.value_count);
+    AT(ticks.lstep == cached.lstep);
+    AT(memcmp(ticks.labels, cached.labels, ticks.value_count * MAX_GLYPHS_PER_TICK) == 0);
+    dvz_ticks_destroy(&ticks);
+    dvz_ticks_destroy(&cached);
+
+    dvz_ticks_cache_destroy(cache);
+    FREE(cache);
+    return 0;
+}
+
+
+
+int test_axes_labels(TestContext* context)
+{
+    DvzAxesContext ctx = {0};
+    ctx.coord = DVZ_AXES_COORD_X;
+    ctx.size_viewport = 1000;
+    ctx.size_glyph = 10;
+    ctx.extensions = 1;
+
+    DvzTickLabelsCache* labels = calloc(1, sizeof(DvzTickLabelsCache));
+    DvzAxesContext ctx_cached = ctx;
+    ctx_cached.labels = labels;
+
+    // Pan sweep: the same tick values come back with the same formats.
+    double x0 = 0, x1 = 0;
+    DvzAxesTicks ticks = {0}, cached = {0};
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        x0 = -1.234 + .01 * i;
+        x1 = x0 + 2.5;
+        ticks = dvz_ticks(x0, x1, ctx);
+        cached = dvz_ticks(x0, x1, ctx_cached);
+
+        // The labels copied from the cache are the same as the formatted ones.
+        AT(ticks.value_count == cached.value_count);
+        AT(ticks.format == cached.format);
+        AT(ticks.precision == cached.precision);
+        AT(memcmp(ticks.labels, cached.labels, ticks.value_count * MAX_GLYPHS_PER_TICK) == 0);
+
+        dvz_ticks_destroy(&ticks);
+        dvz_ticks_destroy(&cached);
+    }
+    log_info("tick labels cache: %d hits, %d misses", labels->hits, labels->misses);
+    AT(labels->hits > labels->misses);
+
+    FREE(labels);
+    return 0;
+}
+
+
+
+// Wait until the axes worker has published the ticks of an axis.
+static bool _axes_worker_wait(DvzAxesWorker* worker, uint32_t coord)
+{
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        if (atomic_load(&worker->pending[coord]) != NULL)
+            return true;
+        dvz_sleep(1);
+    }
+    return false;
+}
+
+// Whether the ticks of an axis are those of a given range.
+static bool _axes_ticks_eq(DvzAxes2D* axes, uint32_t coord, double vmin, double vmax)
+{
+    DvzAxesTicks* ticks = &axes->ticks[coord];
+    DvzAxesTicks expected = dvz_ticks(vmin, vmax, axes->ctx[coord]);
+    bool eq = ticks->value_count == expected.value_count && ticks->lstep == expected.lstep &&
+              memcmp(ticks->values, expected.values, expected.value_count * sizeof(double)) == 0;
+    dvz_ticks_destroy(&expected);
+    return eq;
+}
+
+int test_axes_worker(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_AXES_2D, 0);
+    DvzController* controller = panel->controller;
+    DvzAxes2D* axes = &controller->u.axes_2D;
+    AT(axes->worker == NULL);
+
+    // The axes graphics are specialized on the clip mode of each pipeline.
+    AT(controller->visual_count == 2);
+    DvzVisual* visual = controller->visuals[1];
+    AT(visual->graphics[0]->specialization.data[0] == DVZ_VIEWPORT_OUTER);
+    AT(visual->graphics[1]->specialization.data[0] == DVZ_VIEWPORT_OUTER_LEFT);
+
+    // Post several ranges on the x axis while the first one is being computed.
+    bool update[2] = {true, false};
+    dvec2 range[2] = {{0, 1}, {0, 1}};
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        range[0][0] = i;
+        range[0][1] = i + 10;
+        _axes_worker_post(controller, update, range, false);
+        update[0] = true;
+    }
+    DvzAxesWorker* worker = axes->worker;
+    AT(worker != NULL);
+    AT(worker->in_flight[0]);
+    AT(!worker->in_flight[1]);
+    AT(worker->deferred[0]);
+    AT(worker->deferred_range[0][0] == 9);
+
+    // The first range is swapped in, then the last one is sent.
+    AT(_axes_worker_wait(worker, 0));
+    _axes_worker_swap(controller);
+    _axes_worker_deferred(controller);
+    AT(_axes_ticks_eq(axes, 0, 0, 10));
+    AT(worker->in_flight[0]);
+    AT(!worker->deferred[0]);
+
+    // The final ticks match the last range.
+    AT(_axes_worker_wait(worker, 0));
+    _axes_worker_swap(controller);
+    _axes_worker_deferred(controller);
+    AT(!worker->in_flight[0]);
+    AT(_axes_ticks_eq(axes, 0, 9, 19));
+
+    // The ticks requested before a reset are obsolete and dropped.
+    double* values = axes->ticks[0].values;
+    range[0][0] = 100;
+    range[0][1] = 200;
+    _axes_worker_post(controller, update, range, false);
+    _axes_worker_reset(worker);
+    AT(!worker->in_flight[0]);
+    _axes_worker_wait(worker, 0);
+    _axes_worker_swap(controller);
+    AT(axes->ticks[0].values == values);
+
+    dvz_scene_destroy(scene);
+    TEST_END
+}
+
+
+
 /*************************************************************************************************/
 /*  Scene tests                                                                                  */
 /*************************************************************************************************/
@@ -291,6 +490,125 @@ int test_scene_1(TestContext* context)
 
 
 
+int test_scene_indirect(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+    DvzContext* ctx = gpu->context;
+    ASSERT(ctx != NULL);
+
+    DvzScene* scene = dvz_scene(canvas, 2, 2);
+
+    // Visual data.
+    const uint32_t N = 1000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    float param = 5.0f;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        RANDN_POS(pos[i])
+        RAND_COLOR(color[i])
+    }
+
+    // One point visual per panel.
+    DvzPanel* panel = NULL;
+    DvzVisual* visuals[4] = {0};
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        panel = dvz_scene_panel(scene, i / 2, i % 2, DVZ_CONTROLLER_PANZOOM, 0);
+        visuals[i] = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+        dvz_visual_data(visuals[i], DVZ_PROP_POS, 0, N - 200 * i, pos);
+        dvz_visual_data(visuals[i], DVZ_PROP_COLOR, 0, N - 200 * i, color);
+        dvz_visual_data(visuals[i], DVZ_PROP_MARKER_SIZE, 0, 1, &param);
+    }
+    dvz_app_run(app, N_FRAMES);
+
+    // The indirect draw arguments reflect the number of vertices of each visual.
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        AT(visuals[i]->indirect[0].buffer != NULL);
+        AT(visuals[i]->indirect_args[0].vertexCount == N - 200 * i);
+        AT(visuals[i]->indirect_args[0].instanceCount == 1);
+    }
+
+    // Each visual has recorded its own secondary command buffers.
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        AT(visuals[i]->cmds.count == canvas->cmds_render.count);
+        AT(visuals[i]->cmds_recorded[0]);
+    }
+
+    // Only the command buffers of the changed visual need to be re-recorded.
+    dvz_visual_to_refill(visuals[0]);
+    AT(!visuals[0]->cmds_recorded[0]);
+    AT(visuals[1]->cmds_recorded[0]);
+
+    // The indirect draw regions of the destroyed visuals are released to the context.
+    dvz_scene_destroy(scene);
+    AT(ctx->indirect_pool_count == 4);
+    FREE(pos);
+    FREE(color);
+    TEST_END
+}
+
+
+
+static uint32_t _bake_count;
+static DvzVisualDataCallback _bake_orig;
+
+static void _count_bake(DvzVisual* visual, DvzVisualDataEvent ev)
+{
+    _bake_count++;
+    _bake_orig(visual, ev);
+}
+
+int test_scene_coalesce(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, CANVAS_FLAGS);
+
+    DvzScene* scene = dvz_scene(canvas, 1, 1);
+    DvzPanel* panel = dvz_scene_panel(scene, 0, 0, DVZ_CONTROLLER_PANZOOM, 0);
+    DvzVisual* visual = dvz_scene_visual(panel, DVZ_VISUAL_POINT, 0);
+    _bake_orig = visual->callback_bake;
+    visual->callback_bake = _count_bake;
+
+    const uint32_t N = 1000;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    cvec4* color = calloc(N, sizeof(cvec4));
+    float param = 5.0f;
+    for (uint32_t i = 0; i < N; i++)
+    {
+        RANDN_POS(pos[i])
+        RAND_COLOR(color[i])
+    }
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(visual, DVZ_PROP_COLOR, 0, N, color);
+    dvz_app_run(app, 5);
+
+    // Setting several props, with a box change, bakes the visual only once.
+    _bake_count = 0;
+    for (uint32_t i = 0; i < N; i++)
+        pos[i][0] *= 10;
+    dvz_visual_data(visual, DVZ_PROP_POS, 0, N, pos);
+    dvz_visual_data(visual, DVZ_PROP_COLOR, 0, N, color);
+    dvz_visual_data(visual, DVZ_PROP_MARKER_SIZE, 0, 1, &param);
+    dvz_app_run(app, 5);
+    AT(_bake_count == 1);
+    AT(visual->dirty == 0);
+    AT(panel->dirty == 0);
+
+    dvz_visual_destroy(visual);
+    dvz_scene_destroy(scene);
+    FREE(pos);
+    FREE(color);
+    TEST_END
+}
+
+
+
 static void _rotate(DvzCanvas* canvas, DvzEvent ev)
 {
     DvzPanel* panel = (DvzPanel*)ev.user_data;
@@ -335,7 +653,7 @@ static void _screencast_callback(DvzCanvas* canvas, DvzEvent ev)
     ASSERT(canvas != NULL);
     log_debug("screencast frame #%d", ev.u.sc.idx);
     add_frame((Video*)ev.user_data, ev.u.sc.rgba);
-    FREE(ev.u.sc.rgba);
+    dvz_screencast_release(canvas, ev.u.sc.rgba);
 }
 
 int test_scene_axes(TestContext* context)
@@ -12,9 +12,14 @@
 int test_axes_1(TestContext* context);
 int test_axes_2(TestContext* context);
 int test_axes_3(TestContext* context);
+int test_axes_bench(TestContext* context);
+int test_axes_labels(TestContext* context);
+int test_axes_worker(TestContext* context);
 
 int test_scene_0(TestContext* context);
 int test_scene_1(TestContext* context);
+int test_scene_indirect(TestContext* context);
+int test_scene_coalesce(TestContext* context);
 int test_scene_mesh(TestContext* context);
 int test_scene_axes(TestContext* context);
 int test_scene_logistic(TestContext* context);
@@ -215,3 +215,106 @@ int test_transforms_5(TestContext* context)
 
     TEST_END
 }
+
+
+
+int test_transforms_6(TestContext* context)
+{
+    const uint32_t n = 1000;
+
+    // Data with a large offset and a small range.
+    DvzArray pos_in = dvz_array(n, DVZ_DTYPE_DVEC3);
+    double* positions = (double*)pos_in.data;
+    for (uint32_t i = 0; i < 3 * n; i++)
+        positions[i] = 1e6 + dvz_rand_float();
+
+    DvzDataCoords coords = {0};
+    coords.transform = DVZ_TRANSFORM_CARTESIAN;
+    coords.box = _box_bounding(&pos_in);
+    for (uint32_t i = 0; i < 3; i++)
+        coords.origin[i] = .5 * (coords.box.p0[i] + coords.box.p1[i]);
+    coords.has_origin = true;
+
+    // Reference: CPU normalization in double precision.
+    DvzArray pos_ref = dvz_array(n, DVZ_DTYPE_DVEC3);
+    dvz_transform_pos(coords, &pos_in, &pos_ref, false);
+
+    // GPU normalization, emulated in single precision.
+    DvzArray pos_rel = dvz_array(n, DVZ_DTYPE_DVEC3);
+    dvz_transform_pos_origin(coords, &pos_in, &pos_rel);
+    vec4 scale = {0}, offset = {0};
+    dvz_transform_normalization(coords, scale, offset);
+    AT(scale[3] == 1);
+
+    double* ref = (double*)pos_ref.data;
+    double* rel = (double*)pos_rel.data;
+    float x = 0;
+    for (uint32_t i = 0; i < 3 * n; i++)
+    {
+        x = (float)rel[i] * scale[i % 3] + offset[i % 3];
+        AT(-1 <= ref[i] && ref[i] <= +1);
+        AC(x, ref[i], 1e-5);
+    }
+
+    dvz_array_destroy(&pos_in);
+    dvz_array_destroy(&pos_ref);
+    dvz_array_destroy(&pos_rel);
+    return 0;
+}
+
+
+
+int test_transforms_7(TestContext* context)
+{
+    const uint32_t n = 1000;
+
+    // Timestamps in seconds, zoomed in to a one second range.
+    DvzArray pos_in = dvz_array(n, DVZ_DTYPE_DVEC3);
+    double* positions = (double*)pos_in.data;
+    for (uint32_t i = 0; i < 3 * n; i++)
+        positions[i] = 1.7e9 + dvz_rand_float();
+
+    DvzDataCoords coords = {0};
+    coords.transform = DVZ_TRANSFORM_CARTESIAN;
+    coords.box = _box_bounding(&pos_in);
+    for (uint32_t i = 0; i < 3; i++)
+        coords.origin[i] = .5 * (coords.box.p0[i] + coords.box.p1[i]);
+    coords.has_origin = true;
+
+    // Reference: CPU normalization in double precision.
+    DvzArray pos_ref = dvz_array(n, DVZ_DTYPE_DVEC3);
+    dvz_transform_pos(coords, &pos_in, &pos_ref, false);
+
+    // Absolute positions cast into hi + lo floats, as in the vertex buffer.
+    DvzArray pos_hilo = dvz_array_struct(n, _get_dtype_size(DVZ_DTYPE_DVEC3_HILO));
+    dvz_array_column(
+        &pos_hilo, 0, sizeof(dvec3), 0, n, n, pos_in.data, DVZ_DTYPE_DVEC3, DVZ_DTYPE_DVEC3_HILO,
+        DVZ_ARRAY_COPY_SINGLE, 1);
+
+    // GPU normalization, emulated in single precision.
+    vec4 scale = {0}, offset = {0}, origin_hi = {0}, origin_lo = {0};
+    dvz_transform_normalization(coords, scale, offset);
+    dvz_transform_origin_hilo(coords, origin_hi, origin_lo);
+
+    double* ref = (double*)pos_ref.data;
+    vec3* hilo = NULL;
+    float x = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        hilo = (vec3*)dvz_array_item(&pos_hilo, i);
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            // The hi + lo pair reconstructs the original double.
+            AC((double)hilo[0][j] + (double)hilo[1][j], positions[3 * i + j], 1e-5);
+
+            x = (hilo[0][j] - origin_hi[j]) + (hilo[1][j] - origin_lo[j]);
+            x = x * scale[j] + offset[j];
+            AC(x, ref[3 * i + j], 1e-4);
+        }
+    }
+
+    dvz_array_destroy(&pos_in);
+    dvz_array_destroy(&pos_ref);
+    dvz_array_destroy(&pos_hilo);
+    return 0;
+}
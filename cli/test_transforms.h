@@ -15,6 +15,8 @@ int test_transforms_2(TestContext* context);
 int test_transforms_3(TestContext* context);
 int test_transforms_4(TestContext* context);
 int test_transforms_5(TestContext* context);
+int test_transforms_6(TestContext* context);
+int test_transforms_7(TestContext* context);
 
 
 
@@ -366,3 +366,204 @@ int test_visuals_5(TestContext* context)
     dvz_visual_destroy(&visual);
     TEST_END
 }
+
+
+
+int test_visuals_bounds(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    DvzVisual visual = dvz_visual(canvas);
+    _marker_visual(&visual);
+
+    const uint32_t N = 1001;
+    dvec3* pos = calloc(N, sizeof(dvec3));
+    for (uint32_t i = 0; i < N; i++)
+        for (uint32_t j = 0; j < 3; j++)
+            pos[i][j] = -1 + 2 * dvz_rand_float();
+    pos[10][0] = -2;
+    pos[20][0] = +2;
+
+    DvzBox box = {0};
+    dvz_visual_data(&visual, DVZ_PROP_POS, 0, N, pos);
+    AT(dvz_visual_bounds(&visual, &box));
+    AT(box.p0[0] == -2);
+    AT(box.p1[0] == +2);
+
+    // Appending extends the bounds without a scan.
+    dvec3 p = {0, 3, 0};
+    dvz_visual_data_append(&visual, DVZ_PROP_POS, 0, 1, &p);
+    AT(dvz_visual_bounds(&visual, &box));
+    AT(box.p1[1] == 3);
+
+    // Overwriting an item inside the bounds keeps them valid.
+    dvec3 q[2] = {{0, 0, 0}, {0, .5, 0}};
+    dvz_visual_data_append(&visual, DVZ_PROP_POS, 0, 1, &q[0]);
+    dvz_visual_data_partial(&visual, DVZ_PROP_POS, 0, N + 1, 1, 1, &q[1]);
+    AT(dvz_visual_bounds(&visual, &box));
+    AT(box.p1[1] == 3);
+
+    // Overwriting an item on the bounds makes them stale.
+    dvz_visual_data_partial(&visual, DVZ_PROP_POS, 0, N, 2, 2, q);
+    AT(!dvz_visual_bounds(&visual, &box));
+
+    // The full scan matches the brute force bounds.
+    DvzProp* prop = dvz_prop_get(&visual, DVZ_PROP_POS, 0);
+    box = _prop_bounds(prop);
+    AT(dvz_visual_bounds(&visual, &box));
+    AT(box.p0[0] == -2);
+    AT(box.p1[0] == +2);
+    AT(box.p1[1] <= 1);
+
+    // Truncating the prop to a few items makes the bounds stale, without checking the removed
+    // items.
+    dvz_visual_data_partial(&visual, DVZ_PROP_POS, 0, 1, 1, 1, &q[1]);
+    AT(!dvz_visual_bounds(&visual, &box));
+    box = _prop_bounds(prop);
+    AT(box.p0[1] == MIN(pos[0][1], .5));
+    AT(box.p1[1] == MAX(pos[0][1], .5));
+    TEST_END
+}
+
+
+
+int test_visuals_lookup(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    DvzVisual visual = dvz_visual(canvas);
+    _marker_visual(&visual);
+
+    // The lookup tables return the same props and sources as a scan of the containers.
+    DvzContainerIterator iter = dvz_container_iterator(&visual.props);
+    DvzProp* prop = NULL;
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        AT(dvz_prop_get(&visual, prop->prop_type, prop->prop_idx) == prop);
+        dvz_container_iter(&iter);
+    }
+    iter = dvz_container_iterator(&visual.sources);
+    DvzSource* source = NULL;
+    while (iter.item != NULL)
+    {
+        source = iter.item;
+        AT(dvz_source_get(&visual, source->source_type, source->source_idx) == source);
+        dvz_container_iter(&iter);
+    }
+    AT(dvz_prop_get(&visual, DVZ_PROP_POS, 1) == NULL);
+    AT(dvz_source_get(&visual, DVZ_SOURCE_TYPE_VERTEX, 1) == NULL);
+
+    // Many props: the lookup table overflows and the lookups fall back to a scan.
+    DvzProp* props[DVZ_MAX_VISUAL_LOOKUP] = {0};
+    for (uint32_t i = 1; i < DVZ_MAX_VISUAL_LOOKUP; i++)
+        props[i] = dvz_visual_prop(
+            &visual, DVZ_PROP_POS, i, DVZ_DTYPE_DVEC3, DVZ_SOURCE_TYPE_VERTEX, 0);
+    AT(visual.prop_lookup.overflow);
+    for (uint32_t i = 1; i < DVZ_MAX_VISUAL_LOOKUP; i++)
+        AT(dvz_prop_get(&visual, DVZ_PROP_POS, i) == props[i]);
+
+    dvz_visual_destroy(&visual);
+    TEST_END
+}
+
+
+
+static uint32_t _drawn_vertices(DvzVisualChunks* chunks)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < DVZ_VISUAL_CULL_DRAWS; i++)
+        count += chunks->draws[i].vertexCount;
+    return count;
+}
+
+
+
+int test_visuals_cull(TestContext* context)
+{
+    DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    DvzCanvas* canvas = dvz_canvas(gpu, TEST_WIDTH, TEST_HEIGHT, 0);
+    DvzContext* ctx = gpu->context;
+    DvzVisual visual = dvz_visual(canvas);
+    _marker_visual(&visual);
+
+    // Points sorted along the x axis.
+    const uint32_t N = 100000;
+    DvzVertex* vertices = calloc(N, sizeof(DvzVertex));
+    for (uint32_t i = 0; i < N; i++)
+        vertices[i].pos[0] = -1 + 2 * i / (float)(N - 1);
+    dvz_visual_data_source(&visual, DVZ_SOURCE_TYPE_VERTEX, 0, 0, N, N, vertices);
+
+    DvzBufferRegions br_mvp = dvz_ctx_buffers(
+        ctx, DVZ_BUFFER_TYPE_UNIFORM_MAPPABLE, canvas->swapchain.img_count, sizeof(DvzMVP));
+    DvzBufferRegions br_viewport = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_UNIFORM, 1, 16);
+    DvzBufferRegions br_params =
+        dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_UNIFORM, 1, sizeof(DvzGraphicsPointParams));
+    dvz_visual_buffer(&visual, DVZ_SOURCE_TYPE_MVP, 0, br_mvp);
+    dvz_visual_buffer(&visual, DVZ_SOURCE_TYPE_VIEWPORT, 0, br_viewport);
+    dvz_visual_buffer(&visual, DVZ_SOURCE_TYPE_PARAM, 0, br_params);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+
+    // The spatial index draws all vertices until the first culling.
+    DvzVisualChunks* chunks = visual.chunks[0];
+    AT(chunks != NULL);
+    AT(chunks->chunk_count > 1);
+    AT(chunks->draws[0].vertexCount == N);
+
+    // Zoom in: only the chunks around the origin are drawn, in a single draw.
+    DvzMVP mvp = {0};
+    glm_mat4_identity(mvp.model);
+    glm_mat4_identity(mvp.view);
+    glm_mat4_identity(mvp.proj);
+    glm_scale(mvp.model, (vec3){10, 10, 1});
+    dvz_visual_cull(&visual, &mvp);
+    uint32_t count = _drawn_vertices(chunks);
+    AT(0 < count && count < N / 4);
+    AT(chunks->draws[0].firstVertex <= N / 2);
+    AT(N / 2 < chunks->draws[0].firstVertex + count);
+
+    // Pan away: nothing is drawn.
+    glm_translate(mvp.view, (vec3){100, 0, 0});
+    dvz_visual_cull(&visual, &mvp);
+    AT(_drawn_vertices(chunks) == 0);
+
+    // Reset: everything is drawn again.
+    glm_mat4_identity(mvp.model);
+    glm_mat4_identity(mvp.view);
+    dvz_visual_cull(&visual, &mvp);
+    AT(chunks->draws[0].vertexCount == N);
+
+    // A pipeline specialized on a fixed axis is not culled, whatever the viewport value.
+    DvzGraphics* graphics = visual.graphics[0];
+    DvzSpecialization spec = {0};
+    int32_t axis = DVZ_INTERACT_FIXED_AXIS_X >> 12;
+    dvz_specialization_constant(&spec, DVZ_SPECIALIZATION_INTERACT_AXIS, sizeof(axis), &axis);
+    visual.graphics[0] = dvz_graphics_variant(canvas, DVZ_GRAPHICS_POINT, 0, &spec);
+    glm_scale(mvp.model, (vec3){10, 10, 1});
+    dvz_visual_cull(&visual, &mvp);
+    AT(chunks->draws[0].vertexCount == N);
+    visual.graphics[0] = graphics;
+
+    // The indirect draw region of the destroyed visual is reused by the next visual.
+    VkDeviceSize offset = visual.indirect[0].offsets[0];
+    dvz_visual_destroy(&visual);
+    AT(visual.chunks[0] == NULL);
+    AT(visual.indirect[0].buffer == NULL);
+    AT(ctx->indirect_pool_count == 1);
+    visual = dvz_visual(canvas);
+    _marker_visual(&visual);
+    dvz_visual_data_source(&visual, DVZ_SOURCE_TYPE_VERTEX, 0, 0, N, N, vertices);
+    dvz_visual_buffer(&visual, DVZ_SOURCE_TYPE_MVP, 0, br_mvp);
+    dvz_visual_buffer(&visual, DVZ_SOURCE_TYPE_VIEWPORT, 0, br_viewport);
+    dvz_visual_buffer(&visual, DVZ_SOURCE_TYPE_PARAM, 0, br_params);
+    dvz_visual_update(&visual, canvas->viewport, (DvzDataCoords){0}, NULL);
+    AT(ctx->indirect_pool_count == 0);
+    AT(visual.indirect[0].offsets[0] == offset);
+
+    dvz_visual_destroy(&visual);
+    FREE(vertices);
+    TEST_END
+}
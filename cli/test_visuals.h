@@ -109,6 +109,9 @@ int test_visuals_2(TestContext* context);
 int test_visuals_3(TestContext* context);
 int test_visuals_4(TestContext* context);
 int test_visuals_5(TestContext* context);
+int test_visuals_bounds(TestContext* context);
+int test_visuals_lookup(TestContext* context);
+int test_visuals_cull(TestContext* context);
 
 
 
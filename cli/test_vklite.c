@@ -676,6 +676,59 @@ int test_shader_compile(TestContext* context)
 
 
 
+int test_shader_cache(TestContext* context)
+{
+#if !HAS_GLSLANG
+    log_warn("skip the shader cache test, Datoviz was not built with glslang support");
+    return 0;
+#endif
+
+    char dir[1024] = {0};
+    snprintf(dir, sizeof(dir), "%s/cache", ARTIFACTS_DIR);
+    setenv("DVZ_CACHE_DIR", dir, 1);
+
+    DvzApp* app = dvz_app(DVZ_BACKEND_OFFSCREEN);
+    DvzGpu* gpu = dvz_gpu(app, 0);
+    dvz_gpu_queue(gpu, 0, DVZ_QUEUE_RENDER);
+    dvz_gpu_create(gpu, VK_NULL_HANDLE);
+
+    const char* code = "#version 450\n"
+                       "layout (local_size_x = 1) in;\n"
+                       "layout (std430, binding = 0) buffer Data { float data[]; };\n"
+                       "void main() { data[gl_GlobalInvocationID.x] *= 2.0; }\n";
+
+    uint64_t hits = 0, loads = 0, misses = 0;
+    VkShaderModule modules[3] = {0};
+    dvz_shader_cache_clear();
+
+    // Compiled the first time, or loaded from the cache file of a previous run.
+    modules[0] = dvz_shader_compile(gpu, code, VK_SHADER_STAGE_COMPUTE_BIT);
+    dvz_shader_cache_stats(&hits, &loads, &misses);
+    AT(modules[0] != VK_NULL_HANDLE);
+    AT(hits == 0 && loads + misses == 1);
+
+    // Found in memory the second time.
+    modules[1] = dvz_shader_compile(gpu, code, VK_SHADER_STAGE_COMPUTE_BIT);
+    dvz_shader_cache_stats(&hits, &loads, &misses);
+    AT(modules[1] != VK_NULL_HANDLE);
+    AT(hits == 1 && loads + misses == 1);
+
+    // Loaded from the cache file, as if the process had been restarted.
+    dvz_shader_cache_clear();
+    modules[2] = dvz_shader_compile(gpu, code, VK_SHADER_STAGE_COMPUTE_BIT);
+    dvz_shader_cache_stats(&hits, &loads, &misses);
+    AT(modules[2] != VK_NULL_HANDLE);
+    AT(hits == 0 && loads == 1 && misses == 0);
+
+    for (uint32_t i = 0; i < 3; i++)
+        vkDestroyShaderModule(gpu->device, modules[i], NULL);
+    unsetenv("DVZ_CACHE_DIR");
+
+    TEST_END
+}
+
+
+
 int test_default_app(TestContext* context)
 {
     DvzApp* app = dvz_app(DVZ_BACKEND_GLFW);
@@ -29,6 +29,7 @@ int test_vklite_graphics(TestContext* context);
 int test_basic_canvas_1(TestContext* context);
 int test_basic_canvas_triangle(TestContext* context);
 int test_shader_compile(TestContext* context);
+int test_shader_cache(TestContext* context);
 
 
 
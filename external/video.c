@@ -26,6 +26,51 @@
 
 #define NUM_THREADS 8
 
+// RGBA to YUV420P conversion.
+
+#define RGB_Y(r, g, b) (uint8_t)(((66 * (r) + 129 * (g) + 25 * (b) + 128) >> 8) + 16)
+// NOTE: the chroma values are computed from the sums of 2x2 pixels.
+#define RGB_U(r, g, b) (uint8_t)(((-38 * (r) - 74 * (g) + 112 * (b) + 512) >> 10) + 128)
+#define RGB_V(r, g, b) (uint8_t)(((112 * (r) - 94 * (g) - 18 * (b) + 512) >> 10) + 128)
+
+// NOTE: the conversion runs in the encoder thread, the frames are converted one after the other
+// while the GPU renders the next ones, and the encoder has its own threads.
+void rgba_to_yuv420p(
+    const uint8_t* rgba, int width, int height, uint8_t* planes[3], const int linesizes[3])
+{
+    ASSERT(rgba != NULL);
+    ASSERT(width > 0 && height > 0);
+    int w = width, h = height;
+    const uint8_t *p0 = NULL, *p1 = NULL;
+    uint8_t *y0 = NULL, *y1 = NULL, *u = NULL, *v = NULL;
+    int x1 = 0, r = 0, g = 0, b = 0;
+    for (int y = 0; y < h; y += 2)
+    {
+        // The last row is repeated if the height is odd.
+        p0 = rgba + 4 * (int64_t)w * y;
+        p1 = y + 1 < h ? p0 + 4 * w : p0;
+        y0 = planes[0] + (int64_t)linesizes[0] * y;
+        y1 = y + 1 < h ? y0 + linesizes[0] : y0;
+        u = planes[1] + (int64_t)linesizes[1] * (y / 2);
+        v = planes[2] + (int64_t)linesizes[2] * (y / 2);
+
+        for (int x = 0; x < w; x++)
+        {
+            y0[x] = RGB_Y(p0[4 * x], p0[4 * x + 1], p0[4 * x + 2]);
+            y1[x] = RGB_Y(p1[4 * x], p1[4 * x + 1], p1[4 * x + 2]);
+        }
+        for (int x = 0; x < w; x += 2)
+        {
+            x1 = x + 1 < w ? x + 1 : x;
+            r = p0[4 * x + 0] + p0[4 * x1 + 0] + p1[4 * x + 0] + p1[4 * x1 + 0];
+            g = p0[4 * x + 1] + p0[4 * x1 + 1] + p1[4 * x + 1] + p1[4 * x1 + 1];
+            b = p0[4 * x + 2] + p0[4 * x1 + 2] + p1[4 * x + 2] + p1[4 * x1 + 2];
+            u[x / 2] = RGB_U(r, g, b);
+            v[x / 2] = RGB_V(r, g, b);
+        }
+    }
+}
+
 #if HAS_FFMPEG
 
 #include <libavformat/avformat.h>
@@ -306,23 +351,65 @@ void add_frame(Video* video, uint8_t* image)
         fprintf(stderr, "Could not write the frame\n");
     }
 
-    if (!ost->sws_ctx)
+    video->image = ost->frame->data[0];
+    video->linesize = ost->frame->linesize[0];
+    // RGB to YUV420P.
+    if (c->pix_fmt == AV_PIX_FMT_YUV420P)
+    {
+        rgba_to_yuv420p(image, c->width, c->height, ost->frame->data, ost->frame->linesize);
+    }
+    else
     {
-        ost->sws_ctx = sws_getContext(
-            c->width, c->height, AV_PIX_FMT_RGBA, c->width, c->height, c->pix_fmt, SCALE_FLAGS,
-            NULL, NULL, NULL);
         if (!ost->sws_ctx)
         {
-            fprintf(stderr, "Could not initialize the conversion context\n");
+            ost->sws_ctx = sws_getContext(
+                c->width, c->height, AV_PIX_FMT_RGBA, c->width, c->height, c->pix_fmt,
+                SCALE_FLAGS, NULL, NULL, NULL);
+            if (!ost->sws_ctx)
+            {
+                fprintf(stderr, "Could not initialize the conversion context\n");
+            }
         }
+        const uint8_t* inData[1] = {image};
+        int inLinesize[1] = {4 * c->width};
+        sws_scale(
+            ost->sws_ctx, inData, inLinesize, 0, c->height, ost->frame->data,
+            ost->frame->linesize);
+    }
+
+    ost->frame->pts = ost->next_pts++;
+    video->frame = ost->frame;
+
+    write_video_frame(video);
+}
+
+void add_frame_yuv(Video* video, uint8_t* yuv, const int linesizes[3])
+{
+    OutputStream* ost = video->ost;
+    AVCodecContext* c = ost->enc;
+    if (c->pix_fmt != AV_PIX_FMT_YUV420P)
+    {
+        fprintf(stderr, "The encoder does not accept YUV420P frames\n");
+        return;
+    }
+
+    if (av_frame_make_writable(ost->frame) < 0)
+    {
+        fprintf(stderr, "Could not write the frame\n");
+    }
+
+    // Copy the planes, the frame may have different row strides.
+    int widths[3] = {c->width, (c->width + 1) / 2, (c->width + 1) / 2};
+    int heights[3] = {c->height, (c->height + 1) / 2, (c->height + 1) / 2};
+    const uint8_t* src = yuv;
+    for (int k = 0; k < 3; k++)
+    {
+        for (int y = 0; y < heights[k]; y++)
+            memcpy(
+                ost->frame->data[k] + (int64_t)y * ost->frame->linesize[k],
+                src + (int64_t)y * linesizes[k], (size_t)widths[k]);
+        src += (int64_t)linesizes[k] * heights[k];
     }
-    video->image = ost->frame->data[0];
-    video->linesize = ost->frame->linesize[0];
-    // RGB to YUV420P
-    const uint8_t* inData[1] = {image};
-    int inLinesize[1] = {4 * c->width};
-    sws_scale(
-        ost->sws_ctx, inData, inLinesize, 0, c->height, ost->frame->data, ost->frame->linesize);
 
     ost->frame->pts = ost->next_pts++;
     video->frame = ost->frame;
@@ -332,6 +419,12 @@ void add_frame(Video* video, uint8_t* image)
 
 void end_video(Video* video)
 {
+    // The video is only created when the first frame is added.
+    if (video->ost == NULL)
+    {
+        FREE(video);
+        return;
+    }
     AVFormatContext* oc = video->ost->oc;
 
     /* Write the trailer, if any. The trailer must be written before you
@@ -368,6 +461,8 @@ void create_video(Video* video) { return; }
 
 void add_frame(Video* video, uint8_t* image) {}
 
+void add_frame_yuv(Video* video, uint8_t* yuv, const int linesizes[3]) {}
+
 void end_video(Video* video) {}
 
 #endif
@@ -49,6 +49,13 @@ void create_video(Video* video);
 
 void add_frame(Video* video, uint8_t* image);
 
+// Add a YUV420P frame, with the planes Y, U, V one after the other, with the given row strides.
+void add_frame_yuv(Video* video, uint8_t* yuv, const int linesizes[3]);
+
 void end_video(Video* video);
 
+// Convert an RGBA image to YUV420P (BT.601, limited range).
+void rgba_to_yuv420p(
+    const uint8_t* rgba, int width, int height, uint8_t* planes[3], const int linesizes[3]);
+
 #endif
@@ -8,6 +8,10 @@
 
 #include "vklite.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 
 
 /*************************************************************************************************/
@@ -67,6 +71,8 @@ typedef enum
     DVZ_DTYPE_MAT2, // matrices of floats
     DVZ_DTYPE_MAT3,
     DVZ_DTYPE_MAT4,
+
+    DVZ_DTYPE_DVEC3_HILO, // pair of vec3 (high and low float parts of a dvec3), cast target only
 } DvzDataType;
 
 
@@ -165,6 +171,8 @@ static VkDeviceSize _get_dtype_size(DvzDataType dtype)
         return 8 * 3;
     case DVZ_DTYPE_DVEC4:
         return 8 * 4;
+    case DVZ_DTYPE_DVEC3_HILO:
+        return 4 * 3 * 2;
     case DVZ_DTYPE_STR:
         return sizeof(char*);
 
@@ -216,6 +224,7 @@ static uint32_t _get_components(DvzDataType dtype)
     case DVZ_DTYPE_IVEC3:
     case DVZ_DTYPE_VEC3:
     case DVZ_DTYPE_DVEC3:
+    case DVZ_DTYPE_DVEC3_HILO:
         return 3;
 
     case DVZ_DTYPE_CVEC4:
@@ -403,6 +412,7 @@ _repeat_last(uint32_t old_item_count, VkDeviceSize item_size, void* data, uint32
  *
  * * If the new size is equal to the old size, do nothing.
  * * If the new size is smaller than the old size, change the size attribute but do not reallocate
+ *   (the new size may be 0)
  * * If the new size is larger than the old size, reallocate memory and copy over the old values
  *
  * @param array the array to resize
@@ -411,7 +421,6 @@ _repeat_last(uint32_t old_item_count, VkDeviceSize item_size, void* data, uint32
 static void dvz_array_resize(DvzArray* array, uint32_t item_count)
 {
     ASSERT(array != NULL);
-    ASSERT(item_count > 0);
     ASSERT(array->item_size > 0);
 
     uint32_t old_item_count = array->item_count;
@@ -423,6 +432,7 @@ static void dvz_array_resize(DvzArray* array, uint32_t item_count)
     // If the array was not allocated, allocate it with the specified size.
     if (array->data == NULL)
     {
+        ASSERT(item_count > 0);
         array->data = calloc(item_count, array->item_size);
         array->item_count = item_count;
 
@@ -444,7 +454,7 @@ static void dvz_array_resize(DvzArray* array, uint32_t item_count)
     // Only reallocate if the existing buffer is not large enough for the new item_count.
     if (new_size > old_size)
     {
-        uint32_t new_item_count = 2 * old_item_count;
+        uint32_t new_item_count = MAX(1, 2 * old_item_count);
         while (new_item_count < item_count)
             new_item_count *= 2;
         ASSERT(new_item_count >= item_count);
@@ -694,6 +704,17 @@ static inline void* dvz_array_item(DvzArray* array, uint32_t idx)
 
 
 
+// Split a double into two floats, such that hi + lo approximates x with ~48 bits of mantissa.
+static inline void _double_split(double x, float* hi, float* lo)
+{
+    ASSERT(hi != NULL);
+    ASSERT(lo != NULL);
+    *hi = (float)x;
+    *lo = (float)(x - (double)*hi);
+}
+
+
+
 // Cast a vector.
 static inline void _cast(DvzDataType target_dtype, void* dst, DvzDataType source_dtype, void* src)
 {
@@ -712,6 +733,12 @@ static inline void _cast(DvzDataType target_dtype, void* dst, DvzDataType source
         ((vec3*)dst)[0][1] = ((dvec3*)src)[0][1];
         ((vec3*)dst)[0][2] = ((dvec3*)src)[0][2];
     }
+    else if (source_dtype == DVZ_DTYPE_DVEC3 && target_dtype == DVZ_DTYPE_DVEC3_HILO)
+    {
+        // The high parts come first, followed by the low parts.
+        for (uint32_t i = 0; i < 3; i++)
+            _double_split(((dvec3*)src)[0][i], &((vec3*)dst)[0][i], &((vec3*)dst)[1][i]);
+    }
     else
         log_error("unknown casting dtypes %d %d", source_dtype, target_dtype);
 }
@@ -812,6 +839,81 @@ static void dvz_array_column(
 
 
 
+/**
+ * Extend the bounds of a dvec3 array with a range of items.
+ *
+ * This is the min/max kernel used for the bounding boxes of the POS props. Two dvec3 (six
+ * doubles) are processed at once with SSE2 when available.
+ *
+ * @param array the array, with dtype DVZ_DTYPE_DVEC3
+ * @param first_item the first item to scan
+ * @param item_count the number of items to scan
+ * @param[out] pmin the minimum on each axis, to be extended
+ * @param[out] pmax the maximum on each axis, to be extended
+ */
+static void dvz_array_bounds(
+    DvzArray* array, uint32_t first_item, uint32_t item_count, dvec3 pmin, dvec3 pmax)
+{
+    ASSERT(array != NULL);
+    ASSERT(array->dtype == DVZ_DTYPE_DVEC3);
+    ASSERT(first_item + item_count <= array->item_count);
+    if (item_count == 0)
+        return;
+
+    const double* x = (const double*)array->data + 3 * (uint64_t)first_item;
+    uint32_t i = 0;
+
+#if defined(__SSE2__)
+    if (item_count >= 2)
+    {
+        // Two points are three registers: (x0, y0), (z0, x1), (y1, z1).
+        __m128d min0 = _mm_loadu_pd(x), max0 = min0;
+        __m128d min1 = _mm_loadu_pd(x + 2), max1 = min1;
+        __m128d min2 = _mm_loadu_pd(x + 4), max2 = min2;
+        __m128d v = min0;
+        for (i = 2; i + 2 <= item_count; i += 2)
+        {
+            v = _mm_loadu_pd(x + 3 * i);
+            min0 = _mm_min_pd(min0, v);
+            max0 = _mm_max_pd(max0, v);
+            v = _mm_loadu_pd(x + 3 * i + 2);
+            min1 = _mm_min_pd(min1, v);
+            max1 = _mm_max_pd(max1, v);
+            v = _mm_loadu_pd(x + 3 * i + 4);
+            min2 = _mm_min_pd(min2, v);
+            max2 = _mm_max_pd(max2, v);
+        }
+
+        // Reduce the lanes to the three axes.
+        double m0[2], m1[2], m2[2], M0[2], M1[2], M2[2];
+        _mm_storeu_pd(m0, min0);
+        _mm_storeu_pd(m1, min1);
+        _mm_storeu_pd(m2, min2);
+        _mm_storeu_pd(M0, max0);
+        _mm_storeu_pd(M1, max1);
+        _mm_storeu_pd(M2, max2);
+        pmin[0] = MIN(pmin[0], MIN(m0[0], m1[1]));
+        pmin[1] = MIN(pmin[1], MIN(m0[1], m2[0]));
+        pmin[2] = MIN(pmin[2], MIN(m1[0], m2[1]));
+        pmax[0] = MAX(pmax[0], MAX(M0[0], M1[1]));
+        pmax[1] = MAX(pmax[1], MAX(M0[1], M2[0]));
+        pmax[2] = MAX(pmax[2], MAX(M1[0], M2[1]));
+    }
+#endif
+
+    // Scalar loop, for the remaining item or without SSE2.
+    for (; i < item_count; i++)
+    {
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            pmin[j] = MIN(pmin[j], x[3 * i + j]);
+            pmax[j] = MAX(pmax[j], x[3 * i + j]);
+        }
+    }
+}
+
+
+
 static void dvz_array_print(DvzArray* array)
 {
     ASSERT(array != NULL);
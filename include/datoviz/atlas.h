@@ -16,32 +16,215 @@ END_INCL_NO_WARN
 
 
 /*************************************************************************************************/
-/*  Font atlas                                                                                   */
+/*  Constants                                                                                    */
 /*************************************************************************************************/
 
-static const char DVZ_FONT_ATLAS_STRING[] =
-    " !\"#$%&'()*+,-./"
-    "0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~\x7f";
+#define DVZ_FONT_ATLAS_SDF_COLS   32
+#define DVZ_FONT_ATLAS_SDF_ROWS   16
+#define DVZ_FONT_ATLAS_SDF_HEIGHT 48 // height of a glyph cell, in pixels
+#define DVZ_FONT_ATLAS_SDF_RANGE  4  // distance range, in pixels, as expected by the text shader
+#define DVZ_FONT_ATLAS_SDF_FACTOR 4  // glyphs are rasterized at a higher resolution
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 
 
-static size_t _font_atlas_glyph(DvzFontAtlas* atlas, const char* str, uint32_t idx)
+/*************************************************************************************************/
+/*  UTF-8                                                                                        */
+/*************************************************************************************************/
+
+// Decode the UTF-8 character at the start of a string, and return its number of bytes.
+// Invalid bytes are decoded as U+FFFD.
+static uint32_t _utf8_decode(const char* str, uint32_t* codepoint)
 {
-    ASSERT(atlas != NULL);
-    ASSERT(atlas->rows > 0);
-    ASSERT(atlas->cols > 0);
     ASSERT(str != NULL);
-    ASSERT(strlen(str) > 0);
-    ASSERT(idx < strlen(str));
-    ASSERT(atlas->font_str != NULL);
-    ASSERT(strlen(atlas->font_str) > 0);
+    ASSERT(codepoint != NULL);
+    const uint8_t* s = (const uint8_t*)str;
+    uint32_t n = 0;
+    if (s[0] < 0x80)
+    {
+        *codepoint = s[0];
+        return 1;
+    }
+    else if ((s[0] & 0xE0) == 0xC0)
+        n = 2;
+    else if ((s[0] & 0xF0) == 0xE0)
+        n = 3;
+    else if ((s[0] & 0xF8) == 0xF0)
+        n = 4;
+    else
+    {
+        *codepoint = 0xFFFD;
+        return 1;
+    }
+
+    *codepoint = s[0] & (0x7F >> n);
+    for (uint32_t i = 1; i < n; i++)
+    {
+        if ((s[i] & 0xC0) != 0x80)
+        {
+            *codepoint = 0xFFFD;
+            return i;
+        }
+        *codepoint = (*codepoint << 6) | (s[i] & 0x3F);
+    }
+    return n;
+}
+
+
+
+// Number of characters of a UTF-8 string.
+static uint32_t _utf8_length(const char* str)
+{
+    ASSERT(str != NULL);
+    uint32_t n = 0;
+    uint32_t codepoint = 0;
+    while (*str != 0)
+    {
+        str += _utf8_decode(str, &codepoint);
+        n++;
+    }
+    return n;
+}
+
+
+
+/*************************************************************************************************/
+/*  Signed distance field                                                                        */
+/*************************************************************************************************/
+
+// Propagate the offset to the nearest seed of a neighbor pixel (8SSEDT algorithm).
+static inline void _sdf_compare(
+    int32_t* gx, int32_t* gy, int32_t w, int32_t h, int32_t x, int32_t y, int32_t ox, int32_t oy)
+{
+    int32_t nx = x + ox, ny = y + oy;
+    if (nx < 0 || ny < 0 || nx >= w || ny >= h)
+        return;
+    int32_t i = y * w + x, j = ny * w + nx;
+    int32_t cx = gx[j] + ox, cy = gy[j] + oy;
+    if (cx * cx + cy * cy < gx[i] * gx[i] + gy[i] * gy[i])
+    {
+        gx[i] = cx;
+        gy[i] = cy;
+    }
+}
+
+
+
+// Euclidean distance transform: offset from each pixel to the nearest seed pixel.
+static void _sdf_transform(int32_t* gx, int32_t* gy, int32_t w, int32_t h)
+{
+    for (int32_t y = 0; y < h; y++)
+    {
+        for (int32_t x = 0; x < w; x++)
+        {
+            _sdf_compare(gx, gy, w, h, x, y, -1, 0);
+            _sdf_compare(gx, gy, w, h, x, y, 0, -1);
+            _sdf_compare(gx, gy, w, h, x, y, -1, -1);
+            _sdf_compare(gx, gy, w, h, x, y, +1, -1);
+        }
+        for (int32_t x = w - 1; x >= 0; x--)
+            _sdf_compare(gx, gy, w, h, x, y, +1, 0);
+    }
+    for (int32_t y = h - 1; y >= 0; y--)
+    {
+        for (int32_t x = w - 1; x >= 0; x--)
+        {
+            _sdf_compare(gx, gy, w, h, x, y, +1, 0);
+            _sdf_compare(gx, gy, w, h, x, y, 0, +1);
+            _sdf_compare(gx, gy, w, h, x, y, -1, +1);
+            _sdf_compare(gx, gy, w, h, x, y, +1, +1);
+        }
+        for (int32_t x = 0; x < w; x++)
+            _sdf_compare(gx, gy, w, h, x, y, -1, 0);
+    }
+}
+
 
-    char c[2] = {str[idx], 0};
-    return strcspn(atlas->font_str, c);
+
+/**
+ * Compute the signed distance field of a high-resolution coverage bitmap.
+ *
+ * The output follows the convention of the text fragment shader: 0.5 on the glyph edges,
+ * increasing inside the glyph, with a range of DVZ_FONT_ATLAS_SDF_RANGE output pixels. The value
+ * is written in the 4 RGBA components of the output texels.
+ *
+ * @param coverage the coverage bitmap, 1 byte per pixel
+ * @param width the width of the coverage bitmap, a multiple of factor
+ * @param height the height of the coverage bitmap, a multiple of factor
+ * @param factor the resolution ratio between the coverage bitmap and the output
+ * @param out the output RGBA texels
+ * @param out_stride the number of bytes between two rows of the output
+ */
+static void _font_sdf(
+    const uint8_t* coverage, uint32_t width, uint32_t height, uint32_t factor, uint8_t* out,
+    uint32_t out_stride)
+{
+    ASSERT(coverage != NULL);
+    ASSERT(out != NULL);
+    ASSERT(factor > 0);
+    ASSERT(width % factor == 0);
+    ASSERT(height % factor == 0);
+
+    // Offsets to the nearest inside and outside pixels.
+    uint32_t n = width * height;
+    int32_t* in_x = (int32_t*)calloc(4 * n, sizeof(int32_t));
+    int32_t* in_y = &in_x[n];
+    int32_t* out_x = &in_x[2 * n];
+    int32_t* out_y = &in_x[3 * n];
+    const int32_t far = 1 << 12;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        bool inside = coverage[i] >= 128;
+        in_x[i] = in_y[i] = inside ? 0 : far;
+        out_x[i] = out_y[i] = inside ? far : 0;
+    }
+    _sdf_transform(in_x, in_y, (int32_t)width, (int32_t)height);
+    _sdf_transform(out_x, out_y, (int32_t)width, (int32_t)height);
+
+    // Average the signed distance over the pixels covered by each output texel.
+    uint32_t w = width / factor, h = height / factor;
+    uint32_t i = 0;
+    double d = 0;
+    for (uint32_t y = 0; y < h; y++)
+    {
+        for (uint32_t x = 0; x < w; x++)
+        {
+            d = 0;
+            for (uint32_t v = 0; v < factor; v++)
+            {
+                for (uint32_t u = 0; u < factor; u++)
+                {
+                    i = (y * factor + v) * width + x * factor + u;
+                    // NOTE: the edge lies between the inside and outside pixels.
+                    if (coverage[i] >= 128)
+                        d += sqrt(out_x[i] * out_x[i] + out_y[i] * out_y[i]) - .5;
+                    else
+                        d -= sqrt(in_x[i] * in_x[i] + in_y[i] * in_y[i]) - .5;
+                }
+            }
+            d /= factor * factor * factor; // average, in output pixels
+            d = CLIP(.5 + d / DVZ_FONT_ATLAS_SDF_RANGE, 0, 1);
+            memset(&out[y * out_stride + 4 * x], (uint8_t)round(255 * d), 4);
+        }
+    }
+    FREE(in_x);
 }
 
 
 
+/*************************************************************************************************/
+/*  Font atlas                                                                                   */
+/*************************************************************************************************/
+
+static const char DVZ_FONT_ATLAS_STRING[] =
+    " !\"#$%&'()*+,-./"
+    "0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~\x7f";
+
+
+
 static void _font_atlas_glyph_size(DvzFontAtlas* atlas, float size, vec2 glyph_size)
 {
     ASSERT(atlas != NULL);
@@ -104,13 +287,70 @@ static DvzFontAtlas dvz_font_atlas(DvzContext* ctx)
 
 
 
+/**
+ * Create a signed distance field font atlas from a font file.
+ *
+ * The printable ASCII characters are rasterized when the atlas is created, in the order of the
+ * precomputed atlas, and the other characters are rasterized on demand by
+ * `dvz_font_atlas_glyph()`. Falls back to the precomputed atlas if Datoviz was built without
+ * Freetype or if the font file cannot be loaded.
+ *
+ * @param ctx the context
+ * @param font_path the path to a font file supported by Freetype (TTF, OTF...)
+ * @returns the font atlas
+ */
+DVZ_EXPORT DvzFontAtlas dvz_font_atlas_sdf(DvzContext* ctx, const char* font_path);
+
+
+
+/**
+ * Return the glyph cell of a character, rasterizing it if needed.
+ *
+ * The rasterized glyphs are uploaded to the GPU by `dvz_font_atlas_upload()`. Characters missing
+ * in the atlas, or beyond its capacity, are replaced by a question mark.
+ *
+ * @param atlas the font atlas
+ * @param codepoint the Unicode codepoint of the character
+ * @returns the glyph cell index, in row-major order
+ */
+DVZ_EXPORT uint32_t dvz_font_atlas_glyph(DvzFontAtlas* atlas, uint32_t codepoint);
+
+
+
+/**
+ * Upload the rows of the atlas texture with newly rasterized glyphs.
+ *
+ * @param atlas the font atlas
+ */
+DVZ_EXPORT void dvz_font_atlas_upload(DvzFontAtlas* atlas);
+
+
+
+/**
+ * Destroy a signed distance field font atlas.
+ *
+ * @param atlas the font atlas
+ */
+DVZ_EXPORT void dvz_font_atlas_sdf_destroy(DvzFontAtlas* atlas);
+
+
+
 static void dvz_font_atlas_destroy(DvzFontAtlas* atlas)
 {
     ASSERT(atlas != NULL);
+    if (atlas->sdf)
+    {
+        dvz_font_atlas_sdf_destroy(atlas);
+        return;
+    }
     ASSERT(atlas->font_texture != NULL);
     stbi_image_free(atlas->font_texture);
 }
 
 
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
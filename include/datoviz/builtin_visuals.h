@@ -27,6 +27,14 @@
 
 
 
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_DEFAULT_LINE_STREAM_CAPACITY 1024
+
+
+
 /*************************************************************************************************/
 /*  Enums                                                                                        */
 /*************************************************************************************************/
@@ -75,6 +83,8 @@ typedef enum
     DVZ_VISUAL_AXES_3D,
     DVZ_VISUAL_COLORMAP,
 
+    DVZ_VISUAL_LINE_STREAM,
+
     DVZ_VISUAL_COUNT,
 
     DVZ_VISUAL_CUSTOM,
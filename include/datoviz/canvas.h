@@ -42,6 +42,22 @@ extern "C" {
 #define DVZ_DEFAULT_COMMANDS_RENDER   1
 #define DVZ_MAX_FRAMES_IN_FLIGHT      2
 
+// Number of frames being read back by the screencast while the next frames are rendered.
+#define DVZ_SCREENCAST_DEPTH 3
+// Number of recycled frame buffers passed to the SCREENCAST event callbacks.
+#define DVZ_SCREENCAST_POOL_SIZE 8
+// Maximum number of frames waiting to be encoded by the video encoder thread.
+#define DVZ_VIDEO_QUEUE_SIZE 4
+// Number of staging images per canvas in batch rendering: a figure is read back while the next
+// one is rendered.
+#define DVZ_BATCH_DEPTH 2
+// Number of recycled figure buffers waiting to be written by the PNG writer threads.
+#define DVZ_BATCH_POOL_SIZE 8
+// Default and maximum number of PNG writer threads, and maximum number of batch canvases.
+#define DVZ_BATCH_THREADS     4
+#define DVZ_BATCH_MAX_THREADS 16
+#define DVZ_BATCH_MAX_CANVAS  16
+
 
 
 /*************************************************************************************************/
@@ -156,6 +172,15 @@ typedef enum
 
 
 
+// Video backpressure policy, when the encoder is slower than the screencast.
+typedef enum
+{
+    DVZ_VIDEO_BACKPRESSURE_BLOCK, // wait for the encoder, no frame is lost
+    DVZ_VIDEO_BACKPRESSURE_DROP,  // drop the new frames while the queue is full
+} DvzVideoBackpressure;
+
+
+
 /*************************************************************************************************/
 /*  Event system                                                                                 */
 /*************************************************************************************************/
@@ -257,10 +282,23 @@ typedef struct DvzViewport DvzViewport;
 typedef union DvzEventUnion DvzEventUnion;
 
 typedef void (*DvzEventCallback)(DvzCanvas*, DvzEvent);
+typedef void (*DvzScreenshotCallback)(
+    DvzCanvas* canvas, uint8_t* rgb, uint32_t width, uint32_t height, void* user_data);
+typedef void (*DvzBatchCallback)(DvzCanvas* canvas, uint32_t idx, void* user_data);
 typedef struct DvzEventCallbackRegister DvzEventCallbackRegister;
 
 typedef struct DvzScreencast DvzScreencast;
+typedef struct DvzScreencastSlot DvzScreencastSlot;
+typedef struct DvzScreencastFrame DvzScreencastFrame;
+typedef struct DvzScreenshot DvzScreenshot;
+typedef struct DvzVideoEncoder DvzVideoEncoder;
+typedef struct DvzVideoFrame DvzVideoFrame;
+typedef struct DvzVideoStats DvzVideoStats;
 typedef struct DvzPendingRefill DvzPendingRefill;
+typedef struct DvzBatch DvzBatch;
+typedef struct DvzBatchCanvas DvzBatchCanvas;
+typedef struct DvzBatchFigure DvzBatchFigure;
+typedef struct DvzBatchStats DvzBatchStats;
 
 // Forward declarations.
 typedef struct DvzGui DvzGui;
@@ -341,6 +379,16 @@ struct DvzViewport
     // Used to discard transform on one axis
     int32_t interact_axis;
 
+    // Data normalization on the GPU: pos_ndc = pos * data_scale + data_offset, disabled when
+    // data_scale[3] is 0 (see dvz_transform_normalization()).
+    vec4 data_scale;
+    vec4 data_offset;
+
+    // Data origin as high and low float parts, subtracted on the GPU from the emulated double
+    // positions (data_scale[3] is 2, see DVZ_GRAPHICS_FLAGS_DOUBLE_POS).
+    vec4 data_origin_hi;
+    vec4 data_origin_lo;
+
     // TODO: aspect ratio
 };
 
@@ -426,7 +474,12 @@ struct DvzScreencastEvent
     double interval;
     uint32_t width;
     uint32_t height;
+    // NOTE: owned by the screencast, to be released with dvz_screencast_release().
     uint8_t* rgba;
+    // If yuv is true, the frame buffer contains the planes Y, U, V of a YUV420 image, one after
+    // the other, with these row strides in bytes.
+    bool yuv;
+    uint32_t linesizes[3];
 };
 
 
@@ -509,6 +562,34 @@ struct DvzEventCallbackRegister
 /*  Misc structs                                                                                 */
 /*************************************************************************************************/
 
+// Staging image receiving a copy of a swapchain image, read back by the CPU a few frames later.
+struct DvzScreencastSlot
+{
+    DvzImages staging;
+    DvzCommands cmds; // copy commands, one per swapchain image
+    DvzScreencastStatus status;
+    uint64_t frame_idx;
+    double interval;
+
+    // GPU conversion to YUV420: the frame is copied to the source buffer, and converted by a
+    // compute shader into the host-visible planes buffer.
+    DvzBuffer source;
+    DvzBuffer planes;
+    DvzBindings bindings;
+};
+
+
+
+// Frame buffer of the pool, recycled when released by the SCREENCAST event callback.
+struct DvzScreencastFrame
+{
+    uint8_t* rgba;
+    VkDeviceSize size;
+    atomic(bool, in_use);
+};
+
+
+
 struct DvzScreencast
 {
     DvzObject obj;
@@ -516,19 +597,97 @@ struct DvzScreencast
 
     bool has_alpha;
     DvzCanvas* canvas;
-    DvzCommands cmds;
     DvzSemaphores semaphore;
-    DvzFences fence;
-    DvzImages staging;
     DvzSubmit submit;
     uint64_t frame_idx;
     DvzClock clock;
+    DvzScreencastStatus status; // status of the next copy
+    void* user_data;
+
+    bool yuv;              // whether the frames are converted to YUV420 on the GPU
+    DvzCompute* compute;   // YUV420 conversion compute shader
+    uint32_t linesizes[3]; // YUV420 row strides, in bytes
+
+    // Ring of staging images, with one fence each: the copies are sent at head, and read back
+    // from tail once their fence is signaled.
+    DvzScreencastSlot slots[DVZ_SCREENCAST_DEPTH];
+    DvzFences fences;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t pending; // number of copies being transferred
+
+    DvzScreencastFrame frames[DVZ_SCREENCAST_POOL_SIZE];
+    atomic(uint64_t, dropped); // frames dropped as all frame buffers were in use
+};
+
+
+
+struct DvzVideoStats
+{
+    uint64_t frames_encoded;
+    uint64_t frames_dropped; // by the backpressure policy or by the screencast
+    uint32_t queue_depth;    // frames waiting to be encoded, or being encoded
+    // Time between the readback of a frame and the end of its encoding, in seconds.
+    double latency_last;
+    double latency_mean;
+    double latency_max;
+};
+
+
+
+// Staging resources of the screenshots, cached by the canvas and resized with it.
+struct DvzScreenshot
+{
+    DvzImages staging;
+    DvzCommands cmds; // copy commands, recorded for the swapchain image of the screenshot
+    DvzSubmit submit;
+    DvzFences fence;
+    uint8_t* rgb; // CPU buffer passed to the callback
+    VkDeviceSize size;
+
+    // Asynchronous screenshot: the copy is sent with the frame, and the pixels are read back
+    // once the frame fence is signaled.
     DvzScreencastStatus status;
+    uint32_t frame; // frame in flight of the copy
+    bool has_alpha;
+    DvzScreenshotCallback callback;
     void* user_data;
 };
 
 
 
+// Frame waiting to be encoded.
+struct DvzVideoFrame
+{
+    uint8_t* rgba; // frame buffer of the screencast, or NULL to stop the encoder thread
+    bool yuv;
+    int linesizes[3];
+    double time;
+};
+
+
+
+// Encoder thread consuming the frames of the screencast.
+struct DvzVideoEncoder
+{
+    DvzCanvas* canvas;
+    void* video; // Video instance, see external/video.h
+    DvzVideoBackpressure backpressure;
+    DvzClock clock;
+    DvzFifo queue;
+    DvzThread thread;
+    DvzVideoFrame frames[DVZ_SCREENCAST_POOL_SIZE + 1];
+    uint64_t frame_count;
+
+    // Protect the statistics, and signal the frames that have been encoded.
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    DvzVideoStats stats;
+    double latency_sum;
+};
+
+
+
 struct DvzPendingRefill
 {
     bool completed[DVZ_MAX_SWAPCHAIN_IMAGES];
@@ -537,6 +696,60 @@ struct DvzPendingRefill
 
 
 
+struct DvzBatchStats
+{
+    uint32_t figure_count;
+    uint32_t canvas_count;
+    double elapsed; // in seconds, including the writing of the last PNG files
+    double fps;     // figures per second
+};
+
+
+
+// Figure read back by the batch, waiting to be written by a PNG writer thread.
+struct DvzBatchFigure
+{
+    uint32_t idx; // index of the figure, or UINT32_MAX to stop the writer thread
+    uint32_t width;
+    uint32_t height;
+    uint8_t* rgb;
+    VkDeviceSize size;
+};
+
+
+
+// Offscreen canvas of the batch, with its own staging images and copy commands.
+struct DvzBatchCanvas
+{
+    DvzCanvas* canvas;
+    DvzImages staging[DVZ_BATCH_DEPTH];
+    DvzCommands cmds[DVZ_BATCH_DEPTH]; // copy of the offscreen image to each staging image
+    int64_t figures[DVZ_BATCH_DEPTH];  // index of the figure in each staging image, or -1
+    uint32_t head;                     // staging image of the next figure
+};
+
+
+
+struct DvzBatch
+{
+    DvzApp* app;
+    DvzBatchCallback callback;
+    void* user_data;
+    const char* png_format;
+
+    uint32_t canvas_count;
+    DvzBatchCanvas canvases[DVZ_BATCH_MAX_CANVAS];
+
+    // The figures go from the pool to the queue of the PNG writer threads, and back to the pool.
+    DvzBatchFigure figures[DVZ_BATCH_POOL_SIZE + 1];
+    DvzFifo pool;
+    DvzFifo queue;
+    uint32_t thread_count;
+    DvzThread threads[DVZ_BATCH_MAX_THREADS];
+};
+
+
+
 /*************************************************************************************************/
 /*  Canvas struct                                                                                */
 /*************************************************************************************************/
@@ -617,6 +830,7 @@ struct DvzCanvas
     DvzContainer guis;
 
     DvzScreencast* screencast;
+    DvzScreenshot* screenshot;
     DvzPendingRefill refills;
 
     DvzViewport viewport;
@@ -805,11 +1019,13 @@ DVZ_EXPORT void dvz_canvas_to_close(DvzCanvas* canvas);
  * - screenshots,
  * - video records (requires ffmpeg)
  *
- * This command creates a host-coherent GPU image with the same size as the current framebuffer
- * size.
+ * This command creates `DVZ_SCREENCAST_DEPTH` host-coherent GPU images with the same size as the
+ * current framebuffer size. The frames are copied to these images in turn, and read back by the
+ * CPU while the next frames are rendered.
  *
  * If the interval is non-zero, the canvas will raise periodic SCREENCAST events every  `interval`
- * seconds. The event payload will contain a pointer to the grabbed framebuffer image.
+ * seconds. The event payload will contain a pointer to the grabbed framebuffer image, which must
+ * be released with `dvz_screencast_release()`.
  *
  * @param canvas the canvas
  * @param interval screencast events interval
@@ -824,12 +1040,35 @@ DVZ_EXPORT void dvz_screencast(DvzCanvas* canvas, double interval, bool has_alph
  */
 DVZ_EXPORT void dvz_screencast_destroy(DvzCanvas* canvas);
 
+/**
+ * Convert the screencast frames to planar YUV420 on the GPU.
+ *
+ * A compute shader converts the frames after the render pass, so that the CPU reads back 1.5
+ * bytes per pixel instead of 4, and does not need to convert the frames before encoding them.
+ * The SCREENCAST events then contain the Y, U, V planes, see `DvzScreencastEvent`.
+ *
+ * @param canvas the canvas
+ * @param yuv whether the frames are converted to YUV420 or kept as RGBA
+ */
+DVZ_EXPORT void dvz_screencast_yuv(DvzCanvas* canvas, bool yuv);
+
+/**
+ * Release a frame buffer passed to a SCREENCAST event callback.
+ *
+ * The frame buffers are recycled by the screencast, the event callbacks must release them rather
+ * than free them, possibly from another thread. The frames are dropped when all frame buffers are
+ * in use.
+ *
+ * @param canvas the canvas
+ * @param rgba the frame buffer of the SCREENCAST event
+ */
+DVZ_EXPORT void dvz_screencast_release(DvzCanvas* canvas, uint8_t* rgba);
+
 /**
  * Make a screenshot.
  *
- * This function creates a screencast if there isn't one already. It is implemented with hard
- * synchronization commands so this command should *not* be used for creating many successive
- * screenshots. For that, one should register a SCREENCAST event callback.
+ * The staging image is cached by the canvas, and the function only waits for the copy of the
+ * last rendered image. It cannot be used while the app is running, see `dvz_screenshot_async()`.
  *
  * !!! important
  *     The caller MUST free the output pointer.
@@ -839,12 +1078,26 @@ DVZ_EXPORT void dvz_screencast_destroy(DvzCanvas* canvas);
  */
 DVZ_EXPORT uint8_t* dvz_screenshot(DvzCanvas* canvas, bool has_alpha);
 
+/**
+ * Make a screenshot of the next frame, without blocking.
+ *
+ * The copy is sent with the next frame, and the callback is called in the main thread once the
+ * copy has completed, a few frames later. The pixel buffer is owned by the canvas and is only
+ * valid during the callback. There is at most one screenshot at a time.
+ *
+ * @param canvas the canvas
+ * @param has_alpha whether the pixels are RGB or RGBA
+ * @param callback the function called with the pixels
+ * @param user_data a pointer passed to the callback
+ * @returns whether the screenshot was requested, false if another one is pending
+ */
+DVZ_EXPORT bool dvz_screenshot_async(
+    DvzCanvas* canvas, bool has_alpha, DvzScreenshotCallback callback, void* user_data);
+
 /**
  * Make a screenshot and save it to a PNG file.
  *
- * !!! note
- *     This function uses full GPU synchronization methods so it is relatively inefficient. More
- *      efficient methods are not yet implemented.
+ * The screenshot is saved to an uncompressed PPM file instead if the path ends with `.ppm`.
  *
  * @param canvas the canvas
  * @param png_path the path to the PNG file to create
@@ -886,6 +1139,27 @@ DVZ_EXPORT void dvz_canvas_pause(DvzCanvas* canvas, bool record);
  */
 DVZ_EXPORT void dvz_canvas_stop(DvzCanvas* canvas);
 
+/**
+ * Set the backpressure policy of the video encoder.
+ *
+ * The frames are encoded in a background thread, with a queue of at most `DVZ_VIDEO_QUEUE_SIZE`
+ * frames. When the queue is full, the canvas either waits for the encoder (the default), or drops
+ * the new frames.
+ *
+ * @param canvas the canvas
+ * @param backpressure the backpressure policy
+ */
+DVZ_EXPORT void
+dvz_canvas_video_backpressure(DvzCanvas* canvas, DvzVideoBackpressure backpressure);
+
+/**
+ * Return the statistics of the video encoder.
+ *
+ * @param canvas the canvas
+ * @returns the number of encoded and dropped frames, the queue depth, and the encoding latency
+ */
+DVZ_EXPORT DvzVideoStats dvz_canvas_video_stats(DvzCanvas* canvas);
+
 
 
 /*************************************************************************************************/
@@ -1132,6 +1406,28 @@ DVZ_EXPORT void dvz_canvas_frame_submit(DvzCanvas* canvas);
  */
 DVZ_EXPORT void dvz_app_run(DvzApp* app, uint64_t frame_count);
 
+/**
+ * Render figures without a window, and save them to PNG files.
+ *
+ * The figures are distributed in turn to the offscreen canvases of the app, so that a canvas
+ * prepares its next figure while the others are being rendered. The callback is called before
+ * the rendering of each figure, once the previous figure of the canvas has been rendered: it may
+ * update the visuals of the canvas. A figure is read back while the next one is rendered, and the
+ * PNG files are written by background threads.
+ *
+ * @param app the app, with at least one offscreen canvas
+ * @param figure_count number of figures to render
+ * @param callback function preparing a figure on a canvas, may be NULL
+ * @param user_data pointer passed to the callback
+ * @param png_format path of the PNG files, with an integer conversion for the figure index
+ *      (e.g. `figure_%04d.png`), or NULL to skip the writing of the files
+ * @param thread_count number of PNG writer threads (0 for the default)
+ * @returns the rendering statistics
+ */
+DVZ_EXPORT DvzBatchStats dvz_app_batch(
+    DvzApp* app, uint32_t figure_count, DvzBatchCallback callback, void* user_data,
+    const char* png_format, uint32_t thread_count);
+
 
 
 #ifdef __cplusplus
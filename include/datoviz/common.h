@@ -101,6 +101,13 @@ END_INCL_NO_WARN
 
 #define DVZ_MAX_FRAMES_IN_FLIGHT    2
 #define DVZ_CONTAINER_DEFAULT_COUNT 64
+#define DVZ_CONTAINER_MAX_CHUNKS    32
+
+// PNG encoding: the bands of rows are filtered and compressed in parallel.
+#define DVZ_PNG_COMPRESSION 6
+#define DVZ_PNG_THREADS     4
+#define DVZ_PNG_MAX_THREADS 16
+#define DVZ_PNG_MIN_ROWS    32 // minimum number of rows per band
 
 
 /*************************************************************************************************/
@@ -230,6 +237,19 @@ typedef enum
 
 
 
+// PNG row filters.
+typedef enum
+{
+    DVZ_PNG_FILTER_NONE,
+    DVZ_PNG_FILTER_SUB,
+    DVZ_PNG_FILTER_UP,
+    DVZ_PNG_FILTER_AVERAGE,
+    DVZ_PNG_FILTER_PAETH,
+    DVZ_PNG_FILTER_ADAPTIVE, // best filter of each row, as libpng does by default
+} DvzPngFilter;
+
+
+
 /*************************************************************************************************/
 /*  Typedefs                                                                                     */
 /*************************************************************************************************/
@@ -239,6 +259,7 @@ typedef struct DvzObject DvzObject;
 typedef struct DvzContainer DvzContainer;
 typedef struct DvzContainerIterator DvzContainerIterator;
 typedef struct DvzThread DvzThread;
+typedef struct DvzPngOptions DvzPngOptions;
 
 typedef void* (*DvzThreadCallback)(void*);
 
@@ -265,8 +286,21 @@ struct DvzContainer
     uint32_t count;
     uint32_t capacity;
     DvzObjectType type;
-    void** items;
+    void** items; // slot to item pointer, NULL for free slots
     size_t item_size;
+
+    // Stack of free slots, the top slot is used by the next allocation.
+    uint32_t free_count;
+    uint32_t* free_slots;
+
+    // Dense array with the slots of the allocated items (count entries), sorted by slot.
+    uint32_t* live;
+
+    // Slab storage: chunk 0 holds the initial capacity, chunk k>0 holds the slots added by the
+    // k-th doubling. Chunks never move, so item pointers remain valid after a reallocation.
+    uint32_t base_capacity;
+    uint32_t chunk_count;
+    void* chunks[DVZ_CONTAINER_MAX_CHUNKS];
 };
 
 
@@ -275,6 +309,7 @@ struct DvzContainerIterator
 {
     DvzContainer* container;
     uint32_t idx;
+    uint32_t pos; // position of the next candidate in the dense array
     void* item;
 };
 
@@ -290,6 +325,16 @@ struct DvzThread
 
 
 
+struct DvzPngOptions
+{
+    int compression;       // zlib compression level, from 0 (fastest) to 9 (smallest)
+    DvzPngFilter filter;   // row filter
+    bool has_alpha;        // whether the image is RGBA instead of RGB
+    uint32_t thread_count; // number of threads, 0 for the default
+};
+
+
+
 struct DvzMVP
 {
     mat4 model;
@@ -354,9 +399,112 @@ static uint64_t dvz_next_pow2(uint64_t x)
     return p;
 }
 
+// Pointer to the slab memory backing a given slot.
+static void* _container_slab(DvzContainer* container, uint32_t slot)
+{
+    ASSERT(container != NULL);
+    uint32_t lo = 0;
+    uint32_t hi = container->base_capacity;
+    for (uint32_t k = 0; k < container->chunk_count; k++)
+    {
+        if (slot < hi)
+            return (char*)container->chunks[k] + (slot - lo) * container->item_size;
+        lo = hi;
+        hi *= 2;
+    }
+    log_error("slot %d out of the container slab", slot);
+    return NULL;
+}
+
+// Push the slots [first, last) on the free stack, in reverse order so that the lowest slot is
+// popped first.
+static void _container_push_free(DvzContainer* container, uint32_t first, uint32_t last)
+{
+    ASSERT(container != NULL);
+    ASSERT(first <= last);
+    for (uint32_t i = last; i > first; i--)
+    {
+        ASSERT(container->free_count < container->capacity);
+        container->free_slots[container->free_count++] = i - 1;
+    }
+}
+
+// Position in the dense array of the first allocated slot larger or equal than a given slot.
+static uint32_t _container_live_pos(DvzContainer* container, uint32_t slot)
+{
+    ASSERT(container != NULL);
+    uint32_t lo = 0;
+    uint32_t hi = container->count;
+    uint32_t mid = 0;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (container->live[mid] < slot)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Double the capacity of the container, with a new slab chunk for the new slots.
+static void _container_grow(DvzContainer* container)
+{
+    ASSERT(container != NULL);
+    ASSERT(container->chunk_count < DVZ_CONTAINER_MAX_CHUNKS);
+    uint32_t old_capacity = container->capacity;
+    uint32_t new_capacity = 2 * old_capacity;
+    log_trace("reallocate container up to %d items", new_capacity);
+
+    void** items = (void**)realloc(container->items, new_capacity * sizeof(void*));
+    ASSERT(items != NULL);
+    container->items = items;
+    // Initialize newly-allocated pointers to NULL.
+    for (uint32_t i = old_capacity; i < new_capacity; i++)
+    {
+        container->items[i] = NULL;
+    }
+
+    uint32_t* free_slots =
+        (uint32_t*)realloc(container->free_slots, new_capacity * sizeof(uint32_t));
+    ASSERT(free_slots != NULL);
+    container->free_slots = free_slots;
+
+    uint32_t* live = (uint32_t*)realloc(container->live, new_capacity * sizeof(uint32_t));
+    ASSERT(live != NULL);
+    container->live = live;
+
+    // The new chunk backs the slots [old_capacity, new_capacity).
+    container->chunks[container->chunk_count] = calloc(old_capacity, container->item_size);
+    ASSERT(container->chunks[container->chunk_count] != NULL);
+    container->chunk_count++;
+
+    container->capacity = new_capacity;
+    _container_push_free(container, old_capacity, new_capacity);
+}
+
+// Release the slot at a given position in the dense array.
+static void _container_release(DvzContainer* container, uint32_t pos)
+{
+    ASSERT(container != NULL);
+    ASSERT(pos < container->count);
+    uint32_t slot = container->live[pos];
+    ASSERT(container->items[slot] != NULL);
+    container->items[slot] = NULL;
+    container->count--;
+    if (pos < container->count)
+        memmove(
+            &container->live[pos], &container->live[pos + 1],
+            (container->count - pos) * sizeof(uint32_t));
+    _container_push_free(container, slot, slot + 1);
+}
+
 /**
  * Create a container that will contain an arbitrary number of objects of the same type.
  *
+ * The objects are allocated in a few contiguous chunks. Allocation pops a slot from a free
+ * stack, and iteration goes through a dense array of the allocated slots.
+ *
  * @param count initial number of objects in the container
  * @param item_size size of each object, in bytes
  * @param type object type
@@ -380,9 +528,71 @@ static DvzContainer dvz_container(uint32_t count, size_t item_size, DvzObjectTyp
     {
         container.items[i] = NULL;
     }
+
+    container.free_slots = (uint32_t*)calloc(container.capacity, sizeof(uint32_t));
+    container.live = (uint32_t*)calloc(container.capacity, sizeof(uint32_t));
+    ASSERT(container.free_slots != NULL);
+    ASSERT(container.live != NULL);
+
+    container.base_capacity = container.capacity;
+    container.chunks[0] = calloc(container.capacity, item_size);
+    ASSERT(container.chunks[0] != NULL);
+    container.chunk_count = 1;
+
+    _container_push_free(&container, 0, container.capacity);
     return container;
 }
 
+/**
+ * Free all destroyed objects in the container.
+ *
+ * This is a single pass over the allocated objects. It is called when an allocation finds no
+ * free slot, and once per frame by the main loop.
+ *
+ * @param container the container
+ * @returns the number of freed objects
+ */
+static uint32_t dvz_container_collect(DvzContainer* container)
+{
+    ASSERT(container != NULL);
+    if (container->items == NULL || container->count == 0)
+        return 0;
+
+    uint32_t top = container->free_count;
+    uint32_t kept = 0;
+    uint32_t slot = 0;
+    DvzObject* object = NULL;
+    for (uint32_t i = 0; i < container->count; i++)
+    {
+        slot = container->live[i];
+        object = (DvzObject*)container->items[slot];
+        ASSERT(object != NULL);
+        if (object->status == DVZ_OBJECT_STATUS_DESTROYED)
+        {
+            // log_trace("delete container item #%d", slot);
+            container->items[slot] = NULL;
+            container->free_slots[container->free_count++] = slot;
+        }
+        else
+        {
+            container->live[kept++] = slot;
+        }
+    }
+    uint32_t freed = container->count - kept;
+    container->count = kept;
+
+    // The freed slots were pushed in increasing order, reverse them so that the lowest one is
+    // popped first.
+    uint32_t tmp = 0;
+    for (uint32_t i = top, j = container->free_count; i + 1 < j; i++, j--)
+    {
+        tmp = container->free_slots[i];
+        container->free_slots[i] = container->free_slots[j - 1];
+        container->free_slots[j - 1] = tmp;
+    }
+    return freed;
+}
+
 /**
  * Free a given object in the constainer if it was previously destroyed.
  *
@@ -401,17 +611,18 @@ static void dvz_container_delete_if_destroyed(DvzContainer* container, uint32_t
     if (object->status == DVZ_OBJECT_STATUS_DESTROYED)
     {
         // log_trace("delete container item #%d", idx);
-        FREE(container->items[idx]);
-        container->items[idx] = NULL;
-        container->count--;
-        ASSERT(container->count < UINT32_MAX);
+        uint32_t pos = _container_live_pos(container, idx);
+        ASSERT(pos < container->count);
+        ASSERT(container->live[pos] == idx);
+        _container_release(container, pos);
     }
 }
 
 /**
  * Get a pointer to a new object in the container.
  *
- * If the container is full, it will be automatically resized.
+ * If the container is full, destroyed objects are freed first, and the container is resized
+ * if there is still no free slot.
  *
  * @param container the container
  * @returns a pointer to an allocated object
@@ -421,54 +632,41 @@ static void* dvz_container_alloc(DvzContainer* container)
     ASSERT(container != NULL);
     ASSERT(container->capacity > 0);
     ASSERT(container->items != NULL);
-    uint32_t available_slot = UINT32_MAX;
-
-    // Free the memory of destroyed objects and find the first available slot.
-    for (uint32_t i = 0; i < container->capacity; i++)
-    {
-        dvz_container_delete_if_destroyed(container, i);
-        // Find first slot with empty pointer, to use for new allocation.
-        if (container->items[i] == NULL && available_slot == UINT32_MAX)
-            available_slot = i;
-    }
 
+    // Reclaim the slots of destroyed objects only when there is no free slot left.
+    if (container->free_count == 0)
+        dvz_container_collect(container);
     // If no slot, need to reallocate container.
-    if (available_slot == UINT32_MAX)
-    {
-        log_trace("reallocate container up to %d items", 2 * container->capacity);
-        void** _new =
-            (void**)realloc(container->items, 2 * container->capacity * container->item_size);
-        ASSERT(_new != NULL);
-        container->items = _new;
-
-        ASSERT(container->items != NULL);
-        // Initialize newly-allocated pointers to NULL.
-        for (uint32_t i = container->capacity; i < 2 * container->capacity; i++)
-        {
-            container->items[i] = NULL;
-        }
-        ASSERT(container->items[container->capacity] == NULL);
-        ASSERT(container->items[2 * container->capacity - 1] == NULL);
-        // Return the first empty slot of the newly-allocated container.
-        available_slot = container->capacity;
-        // Update the container capacity.
-        container->capacity *= 2;
-    }
-    ASSERT(available_slot < UINT32_MAX);
-    ASSERT(container->items[available_slot] == NULL);
-
-    // Memory allocation on the heap and store the pointer in the container.
-    // log_trace("container allocates new item #%d", available_slot);
-    container->items[available_slot] = calloc(1, container->item_size);
+    if (container->free_count == 0)
+        _container_grow(container);
+    ASSERT(container->free_count > 0);
+
+    uint32_t slot = container->free_slots[--container->free_count];
+    ASSERT(slot < container->capacity);
+    ASSERT(container->items[slot] == NULL);
+
+    // Take the item memory from the slab and store the pointer in the container.
+    // log_trace("container allocates new item #%d", slot);
+    void* item = _container_slab(container, slot);
+    ASSERT(item != NULL);
+    memset(item, 0, container->item_size);
+    container->items[slot] = item;
+
+    // Insert the slot in the dense array, which remains sorted.
+    uint32_t pos = _container_live_pos(container, slot);
+    if (pos < container->count)
+        memmove(
+            &container->live[pos + 1], &container->live[pos],
+            (container->count - pos) * sizeof(uint32_t));
+    container->live[pos] = slot;
     container->count++;
-    ASSERT(container->items[available_slot] != NULL);
 
     // Initialize the DvzObject field.
-    DvzObject* obj = (DvzObject*)container->items[available_slot];
+    DvzObject* obj = (DvzObject*)item;
     obj->status = DVZ_OBJECT_STATUS_ALLOC;
     obj->type = container->type;
 
-    return container->items[available_slot];
+    return item;
 }
 
 /**
@@ -489,6 +687,8 @@ static void* dvz_container_get(DvzContainer* container, uint32_t idx)
 /**
  * Continue an already-started loop iteration on a container.
  *
+ * Destroyed objects are skipped, they are freed by the next collection.
+ *
  * @param container the container
  * @returns a pointer to the next object in the container, or NULL at the end
  */
@@ -497,24 +697,41 @@ static void dvz_container_iter(DvzContainerIterator* iterator)
     ASSERT(iterator != NULL);
     DvzContainer* container = iterator->container;
     ASSERT(container != NULL);
-    if (container->items == NULL || container->capacity == 0 || container->count == 0)
-        return;
-    if (iterator->idx >= container->capacity)
+    if (container->items == NULL || container->capacity == 0 || container->count == 0 ||
+        iterator->idx >= container->capacity)
+    {
+        iterator->idx = 0;
+        iterator->pos = 0;
+        iterator->item = NULL;
         return;
-    ASSERT(iterator->idx <= container->capacity - 1);
-    for (uint32_t i = iterator->idx; i < container->capacity; i++)
+    }
+
+    // Use the position hint if the dense array was not modified since the last step, otherwise
+    // find the first allocated slot after the last visited one.
+    uint32_t pos = iterator->pos;
+    uint32_t* live = container->live;
+    bool valid = pos <= container->count;
+    valid = valid && (pos == container->count || live[pos] >= iterator->idx);
+    valid = valid && (pos == 0 || live[pos - 1] < iterator->idx);
+    if (!valid)
+        pos = _container_live_pos(container, iterator->idx);
+
+    DvzObject* object = NULL;
+    for (; pos < container->count; pos++)
     {
-        dvz_container_delete_if_destroyed(container, i);
-        if (container->items[i] != NULL)
+        object = (DvzObject*)container->items[container->live[pos]];
+        ASSERT(object != NULL);
+        if (object->status != DVZ_OBJECT_STATUS_DESTROYED)
         {
-            iterator->idx = i + 1;
-            // log_info("item %d: %d", i, container->items[i]);
-            iterator->item = container->items[i];
+            iterator->idx = container->live[pos] + 1;
+            iterator->pos = pos + 1;
+            iterator->item = object;
             return;
         }
     }
     // End the outer loop, reset the internal idx.
     iterator->idx = 0;
+    iterator->pos = 0;
     iterator->item = NULL;
 }
 
@@ -553,31 +770,32 @@ static void dvz_container_destroy(DvzContainer* container)
     ASSERT(container->items != NULL);
     // log_trace("container destroy");
     // Check all elements have been destroyed, and free them if necessary.
+    dvz_container_collect(container);
     DvzObject* item = NULL;
-    for (uint32_t i = 0; i < container->capacity; i++)
+    uint32_t slot = 0;
+    for (uint32_t i = 0; i < container->count; i++)
     {
-        if (container->items[i] != NULL)
-        {
-            // log_trace("deleting container item #%d", i);
-            // When destroying the container, ensure that all objects have been destroyed first.
-            // NOTE: only works if every item has a DvzObject as first struct field.
-            item = (DvzObject*)container->items[i];
-            dvz_container_delete_if_destroyed(container, i);
-            // Also deallocate objects allocated/initialized, but not created/destroyed.
-            if (container->items[i] != NULL)
-            {
-                ASSERT(item->status <= DVZ_OBJECT_STATUS_INIT);
-                ASSERT(item->status != DVZ_OBJECT_STATUS_DESTROYED);
-                FREE(container->items[i]);
-                container->items[i] = NULL;
-                container->count--;
-                ASSERT(container->count < UINT32_MAX);
-            }
-            ASSERT(container->items[i] == NULL);
-        }
+        slot = container->live[i];
+        // log_trace("deleting container item #%d", slot);
+        // When destroying the container, ensure that all objects have been destroyed first.
+        // NOTE: only works if every item has a DvzObject as first struct field.
+        item = (DvzObject*)container->items[slot];
+        ASSERT(item != NULL);
+        // Also deallocate objects allocated/initialized, but not created/destroyed.
+        ASSERT(item->status <= DVZ_OBJECT_STATUS_INIT);
+        ASSERT(item->status != DVZ_OBJECT_STATUS_DESTROYED);
+        container->items[slot] = NULL;
     }
-    ASSERT(container->count == 0);
+    container->count = 0;
     // log_trace("free container items");
+    for (uint32_t k = 0; k < container->chunk_count; k++)
+    {
+        FREE(container->chunks[k]);
+    }
+    container->chunk_count = 0;
+    FREE(container->free_slots);
+    FREE(container->live);
+    container->free_count = 0;
     FREE(container->items);
     container->capacity = 0;
 }
@@ -606,11 +824,36 @@ static void dvz_container_destroy(DvzContainer* container)
  * @param filename path to the PNG file to create
  * @param width width of the image
  * @param height height of the image
- * @param image pointer to an array of 32-bit RGBA values
+ * @param image pointer to an array of 24-bit RGB values
  */
 DVZ_EXPORT int
 dvz_write_png(const char* filename, uint32_t width, uint32_t height, const uint8_t* image);
 
+/**
+ * Return the default PNG encoding options.
+ *
+ * @returns the options: default compression level, adaptive filter, RGB, default threads
+ */
+DVZ_EXPORT DvzPngOptions dvz_png_options(void);
+
+/**
+ * Save an image to a PNG file with custom encoding options.
+ *
+ * The image is split into bands of rows, that are filtered and compressed in parallel, and
+ * concatenated into a single zlib stream. The compression level and the filter trade the file
+ * size for the speed: level 1 with the UP filter is several times faster than the default.
+ *
+ * @param filename path to the PNG file to create
+ * @param width width of the image
+ * @param height height of the image
+ * @param image pointer to an array of 24-bit RGB or 32-bit RGBA values
+ * @param options the encoding options
+ * @returns 0 on success
+ */
+DVZ_EXPORT int dvz_write_png_options(
+    const char* filename, uint32_t width, uint32_t height, const uint8_t* image,
+    DvzPngOptions options);
+
 /**
  * Save an image to a PPM file (short ASCII header and flat binary RGBA values).
  *
@@ -650,6 +893,31 @@ DVZ_EXPORT char* dvz_read_npy(const char* filename, size_t* size);
  */
 DVZ_EXPORT uint8_t* dvz_read_ppm(const char* filename, int* width, int* height);
 
+/**
+ * Write a binary file.
+ *
+ * The data is written to a temporary file which is then renamed, so that other processes never
+ * read a partially written file.
+ *
+ * @param filename path of the file to create
+ * @param size size of the data, in bytes
+ * @param data pointer to the data
+ * @returns 0 on success
+ */
+DVZ_EXPORT int dvz_write_file(const char* filename, size_t size, const void* data);
+
+/**
+ * Get the directory of the cache files, and create it if needed.
+ *
+ * The directory is `$DVZ_CACHE_DIR` if set, otherwise `datoviz` in the user cache directory
+ * (`$XDG_CACHE_HOME`, `~/.cache`, or `%LOCALAPPDATA%` on Windows).
+ *
+ * @param[out] path buffer receiving the path of the directory
+ * @param size size of the buffer
+ * @returns 0 on success, 1 if there is no cache directory
+ */
+DVZ_EXPORT int dvz_cache_dir(char* path, size_t size);
+
 // Defined in cmake-generated file build/_shaders.c
 DVZ_EXPORT const unsigned char* dvz_resource_shader(const char* name, unsigned long* size);
 
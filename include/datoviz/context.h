@@ -30,6 +30,9 @@ extern "C" {
 #define DVZ_BUFFER_TYPE_STORAGE_SIZE (16 * 1024 * 1024)
 #define DVZ_BUFFER_TYPE_UNIFORM_SIZE (4 * 1024 * 1024)
 
+// Maximum number of indirect draw regions of destroyed visuals kept for reuse.
+#define DVZ_MAX_INDIRECT_POOL 64
+
 #define DVZ_ZERO_OFFSET                                                                           \
     (uvec3) { 0, 0, 0 }
 
@@ -82,6 +85,18 @@ struct DvzFontAtlas
     float glyph_width, glyph_height;
     const char* font_str;
     DvzTexture* texture;
+
+    // Signed distance field atlas generated at runtime from a font file, the glyphs are
+    // rasterized on demand in the next free cell.
+    bool sdf;
+    void* ft_library;      // FT_Library
+    void* ft_face;         // FT_Face
+    int32_t ft_baseline;   // baseline position in the high-resolution glyph cell, in pixels
+    uint32_t glyph_count;  // number of rasterized glyphs
+    uint32_t* glyph_keys;  // hash table of the rasterized glyphs: codepoint + 1, 0 if empty
+    uint32_t* glyph_cells; // hash table of the rasterized glyphs: glyph cell index
+    uint32_t dirty_first;  // first row of cells to upload to the texture
+    uint32_t dirty_count;  // number of rows of cells to upload to the texture
 };
 
 
@@ -110,6 +125,10 @@ struct DvzContext
     // Font atlas.
     DvzFontAtlas font_atlas;
     DvzColorTexture color_texture;
+
+    // Indirect draw regions released by destroyed visuals, reused by the next visuals.
+    DvzBufferRegions indirect_pool[DVZ_MAX_INDIRECT_POOL];
+    uint32_t indirect_pool_count;
 };
 
 
@@ -255,19 +274,29 @@ static void _copy_texture_from_staging(
     dvz_cmd_reset(cmds, 0);
     dvz_cmd_begin(cmds, 0);
 
+    // A zero shape stands for the whole texture. When only a region of the texture is updated,
+    // the rest of the texture, which must have been uploaded before, is preserved.
+    ASSERT(texture != NULL);
+    ASSERT(texture->image != NULL);
+    DvzImages* img = texture->image;
+    bool whole = shape[0] == 0 || shape[1] == 0 || shape[2] == 0 ||
+                 (shape[0] == img->width && shape[1] == img->height && shape[2] == img->depth);
+
     // Image transition.
     DvzBarrier barrier = dvz_barrier(gpu);
     dvz_barrier_stages(&barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-    ASSERT(texture != NULL);
-    ASSERT(texture->image != NULL);
-    dvz_barrier_images(&barrier, texture->image);
+    dvz_barrier_images(&barrier, img);
     dvz_barrier_images_layout(
-        &barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        &barrier, whole ? VK_IMAGE_LAYOUT_UNDEFINED : img->layout,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
     dvz_barrier_images_access(&barrier, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
     dvz_cmd_barrier(cmds, 0, &barrier);
 
     // Copy to staging buffer
-    dvz_cmd_copy_buffer_to_image(cmds, 0, staging, texture->image);
+    if (whole)
+        dvz_cmd_copy_buffer_to_image(cmds, 0, staging, img);
+    else
+        dvz_cmd_copy_buffer_to_image_region(cmds, 0, staging, img, offset, shape);
 
     // Image transition.
     dvz_barrier_images_layout(
@@ -366,6 +395,17 @@ DVZ_EXPORT DvzContext* dvz_context(DvzGpu* gpu, DvzWindow* window);
  */
 DVZ_EXPORT void dvz_context_reset(DvzContext* context);
 
+/**
+ * Replace the font atlas of a context by a signed distance field atlas generated from a font file.
+ *
+ * Text visuals use the font atlas of the context when they are created: this function should be
+ * called before creating any visual with text.
+ *
+ * @param context the context
+ * @param font_path the path to a font file supported by Freetype (TTF, OTF...)
+ */
+DVZ_EXPORT void dvz_context_font(DvzContext* context, const char* font_path);
+
 
 
 /*************************************************************************************************/
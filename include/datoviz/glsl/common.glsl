@@ -20,10 +20,15 @@
 
 #define USER_BINDING 2
 
+// NOTE: specialization constants, must correspond to DvzSpecializationConstant in graphics.h.
+// The default value -1 means that the value is taken from the viewport at runtime.
+layout (constant_id = 0) const int SPECIALIZATION_CLIP = -1;
+layout (constant_id = 1) const int SPECIALIZATION_INTERACT_AXIS = -1;
+
 // NOTE:needs to be a macro and not a function so that it can be safely included in both
 // vertex and fragment shaders (discard is forbidden in the vertex shader)
 #define CLIP \
-    switch (viewport.clip)                                                                        \
+    switch (SPECIALIZATION_CLIP >= 0 ? SPECIALIZATION_CLIP : viewport.clip)                       \
     {                                                                                             \
         case DVZ_VIEWPORT_NONE:                                                                   \
             break;                                                                                \
@@ -81,6 +86,12 @@ layout (std140, binding = 1) uniform Viewport {
     // Options
     int clip;               // viewport clipping
     int interact_axis;
+
+    // Data normalization
+    vec4 data_scale;        // disabled if w == 0, emulated double positions if w == 2
+    vec4 data_offset;
+    vec4 data_origin_hi;    // data origin, high float part (emulated double positions)
+    vec4 data_origin_lo;    // data origin, low float part
 } viewport;
 
 
@@ -99,13 +110,37 @@ vec4 to_vulkan(vec4 tr) {
 
 
 
+vec3 normalize_pos(vec3 pos) {
+    // Data normalization on the GPU, from the data relative to the origin to NDC.
+    if (viewport.data_scale.w != 1)
+        return pos;
+    return pos * viewport.data_scale.xyz + viewport.data_offset.xyz;
+}
+
+
+
+vec3 normalize_pos(vec3 pos_hi, vec3 pos_lo) {
+    // Data normalization of emulated double positions, from the absolute data to NDC. The
+    // high parts are close to the origin's so their difference is exact in float.
+    if (viewport.data_scale.w != 2)
+        return pos_hi;
+    precise vec3 d_hi = pos_hi - viewport.data_origin_hi.xyz;
+    precise vec3 d_lo = pos_lo - viewport.data_origin_lo.xyz;
+    precise vec3 pos = d_hi + d_lo;
+    return pos * viewport.data_scale.xyz + viewport.data_offset.xyz;
+}
+
+
+
 vec4 transform(vec3 pos, vec2 shift, uint transform_mode) {
     mat4 mvp = mvp.proj * mvp.view * mvp.model;
+    pos = normalize_pos(pos);
     vec4 tr = vec4(pos, 1.0);
 
     // By default, take the viewport transform.
     if (transform_mode == DVZ_INTERACT_FIXED_AXIS_DEFAULT)
-        transform_mode = uint(viewport.interact_axis);
+        transform_mode = SPECIALIZATION_INTERACT_AXIS >= 0 ?
+            uint(SPECIALIZATION_INTERACT_AXIS) : uint(viewport.interact_axis);
     // Default: transform all
     if (transform_mode == DVZ_INTERACT_FIXED_AXIS_DEFAULT)
         transform_mode = DVZ_INTERACT_FIXED_AXIS_NONE;
@@ -21,6 +21,10 @@
 
 #define DVZ_MAX_GLYPHS_PER_TEXT 256
 
+// Number of threads creating the pipelines in dvz_graphics_prewarm()
+#define DVZ_PREWARM_THREADS     4
+#define DVZ_PREWARM_MAX_THREADS 16
+
 
 
 /*************************************************************************************************/
@@ -32,6 +36,7 @@ typedef enum
 {
     DVZ_GRAPHICS_FLAGS_DEPTH_TEST_DISABLE = 0x0000,
     DVZ_GRAPHICS_FLAGS_DEPTH_TEST_ENABLE = 0x0100,
+    DVZ_GRAPHICS_FLAGS_DOUBLE_POS = 0x0200, // emulated double positions (hi + lo floats)
 } DvzGraphicsFlags;
 
 
@@ -96,11 +101,26 @@ typedef enum
 
 
 
+// Specialization constants of the builtin shaders, set with dvz_graphics_variant().
+// NOTE: the IDs need to correspond to the constant_id in common.glsl and in the shaders. When a
+// constant is not specialized, the shader takes the value from the uniform parameters at runtime.
+typedef enum
+{
+    DVZ_SPECIALIZATION_CLIP = 0,          // DvzViewportClip, instead of viewport.clip
+    DVZ_SPECIALIZATION_INTERACT_AXIS = 1, // DvzInteractAxis >> 12, instead of viewport
+    DVZ_SPECIALIZATION_MARKER_TYPE = 2,   // DvzMarkerType, instead of the marker attribute
+    DVZ_SPECIALIZATION_CAP_TYPE = 3,      // DvzCapType, instead of the path cap_type param
+    DVZ_SPECIALIZATION_ROUND_JOIN = 4,    // DvzJoinType, instead of the path round_join param
+} DvzSpecializationConstant;
+
+
+
 /*************************************************************************************************/
 /*  Typedefs                                                                                     */
 /*************************************************************************************************/
 
 typedef struct DvzVertex DvzVertex;
+typedef struct DvzVertexDouble DvzVertexDouble;
 
 typedef struct DvzGraphicsPointParams DvzGraphicsPointParams;
 
@@ -129,11 +149,15 @@ typedef struct DvzGraphicsVolumeParams DvzGraphicsVolumeParams;
 typedef struct DvzGraphicsMeshVertex DvzGraphicsMeshVertex;
 typedef struct DvzGraphicsMeshParams DvzGraphicsMeshParams;
 
+typedef struct DvzGraphicsLineStreamVertex DvzGraphicsLineStreamVertex;
+typedef struct DvzGraphicsLineStreamParams DvzGraphicsLineStreamParams;
+
 typedef struct DvzGraphicsTextParams DvzGraphicsTextParams;
 typedef struct DvzGraphicsTextVertex DvzGraphicsTextVertex;
 typedef struct DvzGraphicsTextItem DvzGraphicsTextItem;
 
 typedef struct DvzGraphicsData DvzGraphicsData;
+typedef struct DvzGraphicsPrewarm DvzGraphicsPrewarm;
 
 
 
@@ -149,6 +173,15 @@ struct DvzVertex
 
 
 
+struct DvzVertexDouble
+{
+    vec3 pos;    /* position, high float part */
+    vec3 pos_lo; /* position, low float part (pos + pos_lo ~ original double) */
+    cvec4 color; /* color */
+};
+
+
+
 struct DvzGraphicsData
 {
     DvzGraphics* graphics;
@@ -162,6 +195,15 @@ struct DvzGraphicsData
 
 
 
+struct DvzGraphicsPrewarm
+{
+    uint32_t count;
+    DvzGraphics** graphics; // graphics set up but not created yet
+    atomic(uint32_t, next); // index of the next graphics to create
+};
+
+
+
 /*************************************************************************************************/
 /*  Graphics point                                                                               */
 /*************************************************************************************************/
@@ -408,6 +450,25 @@ static DvzGraphicsMeshParams default_graphics_mesh_params(vec3 eye)
 
 
 
+/*************************************************************************************************/
+/*  Graphics line stream                                                                         */
+/*************************************************************************************************/
+
+// NOTE: the vertices are fetched from a storage buffer (std430), not as vertex attributes.
+struct DvzGraphicsLineStreamVertex
+{
+    float y;     /* sample value */
+    cvec4 color; /* sample color */
+};
+
+struct DvzGraphicsLineStreamParams
+{
+    uvec4 ring;  /* ring buffer capacity, head, and number of valid samples */
+    vec2 yrange; /* range of the sample values, mapped to [-1, +1] */
+};
+
+
+
 /*************************************************************************************************/
 /*  Functions                                                                                    */
 /*************************************************************************************************/
@@ -463,6 +524,39 @@ DVZ_EXPORT void dvz_graphics_append(DvzGraphicsData* data, const void* item);
  */
 DVZ_EXPORT DvzGraphics* dvz_graphics_builtin(DvzCanvas* canvas, DvzGraphicsType type, int flags);
 
+/**
+ * Get a variant of a builtin graphics pipeline with specialization constants.
+ *
+ * The variants are cached in the canvas and keyed by the type, the flags, and the values of the
+ * specialization constants, so that each variant is only created once.
+ *
+ * @param canvas the canvas holding the graphics pipeline
+ * @param type the graphics type
+ * @param flags the creation flags for the graphics
+ * @param specialization the values of the specialization constants (see
+ * DvzSpecializationConstant), or NULL for the generic graphics
+ * @returns the graphics pipeline
+ */
+DVZ_EXPORT DvzGraphics* dvz_graphics_variant(
+    DvzCanvas* canvas, DvzGraphicsType type, int flags, const DvzSpecialization* specialization);
+
+/**
+ * Create the pipelines of several builtin graphics concurrently, before the first frame.
+ *
+ * The graphics are set up on the calling thread, and their pipelines are created on a pool of
+ * threads. Subsequent calls to `dvz_graphics_builtin()` with the same type and flags return the
+ * prewarmed graphics. Graphics that already exist in the canvas are skipped.
+ *
+ * @param canvas the canvas holding the graphics pipelines
+ * @param count the number of graphics
+ * @param types the graphics types
+ * @param flags the creation flags of each graphics, or NULL for 0
+ * @param thread_count the number of threads, or 0 for the default
+ */
+DVZ_EXPORT void dvz_graphics_prewarm(
+    DvzCanvas* canvas, uint32_t count, const DvzGraphicsType* types, const int* flags,
+    uint32_t thread_count);
+
 
 
 /**
@@ -103,6 +103,8 @@ struct DvzPanel
     DvzController* controller;
     DvzCommands* cmds;
     int prority_max;
+
+    int dirty; // pending scene updates, coalesced within a frame (DvzSceneDirtyFlags)
 };
 
 
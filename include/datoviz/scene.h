@@ -71,6 +71,17 @@ typedef enum
 
 
 
+// Dirty flags of the scene updates coalesced within a frame.
+typedef enum
+{
+    DVZ_SCENE_DIRTY_NONE = 0x00,
+    DVZ_SCENE_DIRTY_COORDS = 0x01, // panel: the data coords have changed
+    DVZ_SCENE_DIRTY_PROP = 0x02,   // visual and prop: the POS data needs to be transformed
+    DVZ_SCENE_DIRTY_BAKE = 0x04,   // visual: the data needs to be baked and uploaded
+} DvzSceneDirtyFlags;
+
+
+
 /*************************************************************************************************/
 /*  Typedefs                                                                                     */
 /*************************************************************************************************/
@@ -80,6 +91,7 @@ typedef struct DvzSceneUpdate DvzSceneUpdate;
 typedef struct DvzController DvzController;
 typedef struct DvzTransformOLD DvzTransformOLD;
 typedef struct DvzAxes2D DvzAxes2D;
+typedef struct DvzAxesWorker DvzAxesWorker;
 typedef union DvzControllerUnion DvzControllerUnion;
 
 typedef void (*DvzControllerCallback)(DvzController* controller, DvzEvent ev);
@@ -109,6 +121,8 @@ struct DvzAxes2D
 {
     DvzAxesContext ctx[2]; // one per dimension
     DvzAxesTicks ticks[2];
+    DvzTicksCache* ticks_cache; // memoized tick computations, for both dimensions
+    DvzAxesWorker* worker;      // background tick computations during interaction
     DvzBox box; // box, in data coordinates, corresponding to the box showed with initial panzoom
     float font_size;
 };
@@ -9,6 +9,17 @@
 
 
 
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+#define DVZ_TICKS_CACHE_SIZE       64
+#define DVZ_TICKS_MAX_GLYPHS       24  // maximum length of a tick label, including the null byte
+#define DVZ_TICK_LABELS_CACHE_SETS 256 // number of sets of the tick label cache
+#define DVZ_TICK_LABELS_CACHE_WAYS 4   // number of entries per set of the tick label cache
+
+
+
 /*************************************************************************************************/
 /*  Enums                                                                                        */
 /*************************************************************************************************/
@@ -29,6 +40,11 @@ typedef enum
 
 typedef struct DvzAxesContext DvzAxesContext;
 typedef struct DvzAxesTicks DvzAxesTicks;
+typedef struct DvzTicksCacheKey DvzTicksCacheKey;
+typedef struct DvzTicksCacheEntry DvzTicksCacheEntry;
+typedef struct DvzTicksCache DvzTicksCache;
+typedef struct DvzTickLabelsEntry DvzTickLabelsEntry;
+typedef struct DvzTickLabelsCache DvzTickLabelsCache;
 typedef struct Q Q;
 
 
@@ -44,6 +60,8 @@ struct DvzAxesContext
     float size_glyph;    // either width or height
     float scale_orig;    // scale
     uint32_t extensions; // number of extensions on each side (typically 1)
+
+    DvzTickLabelsCache* labels; // optional cache of the formatted labels
 };
 
 
@@ -63,4 +81,63 @@ struct DvzAxesTicks
 
 
 
+// Quantized tick computation request.
+struct DvzTicksCacheKey
+{
+    int32_t exponent;   // the range bounds are quantized with a step of 10^exponent
+    int64_t qmin, qmax; // quantized range bounds
+    uint32_t viewport;  // viewport size, in pixels
+    uint32_t glyph;     // glyph size, in 1/16 pixels
+    DvzAxisCoord coord;
+    uint32_t extensions;
+};
+
+
+
+struct DvzTicksCacheEntry
+{
+    bool used;
+    uint64_t last_used; // for least-recently-used eviction
+    DvzTicksCacheKey key;
+    DvzAxesTicks ticks; // owned by the cache
+};
+
+
+
+// Formatted label of a tick value.
+struct DvzTickLabelsEntry
+{
+    double value;
+    uint8_t format;    // DvzTickFormat
+    uint8_t precision; // number of digits after the dot
+    uint8_t length;    // label length, 0 for an unused entry
+    uint32_t last_used;
+    char label[DVZ_TICKS_MAX_GLYPHS];
+};
+
+
+
+// Set-associative cache of the formatted labels, keyed by (value, format, precision), with
+// least-recently-used eviction within each set. The tick search formats the same values with
+// the same formats over and over again, and panning mostly brings back the same values.
+struct DvzTickLabelsCache
+{
+    uint32_t clock;
+    uint64_t hits, misses;
+    DvzTickLabelsEntry entries[DVZ_TICK_LABELS_CACHE_SETS][DVZ_TICK_LABELS_CACHE_WAYS];
+};
+
+
+
+// Memoization of the tick computations, used during panzoom when the same ranges come back.
+struct DvzTicksCache
+{
+    uint64_t clock;
+    uint64_t hits, misses;
+    DvzTicksCacheEntry entries[DVZ_TICKS_CACHE_SIZE];
+    DvzTickLabelsCache labels;
+};
+
+
+
 #endif
@@ -119,6 +119,12 @@ struct DvzDataCoords
     DvzCDSTranspose transpose; // possible transposition of the data coordinate system
     DvzTransformType transform;
     int flags; // come from the panel
+
+    // With the cartesian transform, the data normalization is done on the GPU: the POS data is
+    // uploaded relative to this origin, so that float positions keep their precision, and the
+    // box-to-NDC affine map is stored in the viewport uniform of each visual.
+    dvec3 origin;
+    bool has_origin;
     // TODO: union with transform parameters?
 };
 
@@ -204,6 +210,37 @@ MAKE_TRANSPOSE(vec3)
 DVZ_EXPORT void
 dvz_transform_pos(DvzDataCoords coords, DvzArray* pos_in, DvzArray* pos_out, bool inverse);
 
+/**
+ * Subtract the data origin from position data, before the upload of data that is normalized on
+ * the GPU.
+ *
+ * @param coords the data coordinate system, with its origin
+ * @param pos_in input array of dvec3 values
+ * @param[out] pos_out output array of dvec3 values
+ */
+DVZ_EXPORT void
+dvz_transform_pos_origin(DvzDataCoords coords, DvzArray* pos_in, DvzArray* pos_out);
+
+/**
+ * Compute the affine map from origin-relative data coordinates to NDC.
+ *
+ * The map is `pos_ndc = pos * scale + offset`, with the offset computed in double precision.
+ *
+ * @param coords the data coordinate system, bounds, and origin
+ * @param[out] scale the scaling coefficients
+ * @param[out] offset the translation coefficients
+ */
+DVZ_EXPORT void dvz_transform_normalization(DvzDataCoords coords, vec4 scale, vec4 offset);
+
+/**
+ * Split the data origin into high and low float parts, for emulated double positions.
+ *
+ * @param coords the data coordinate system, bounds, and origin
+ * @param[out] hi the high float parts of the origin
+ * @param[out] lo the low float parts of the origin
+ */
+DVZ_EXPORT void dvz_transform_origin_hilo(DvzDataCoords coords, vec4 hi, vec4 lo);
+
 /**
  * Convert a 3D position from a coordinate system to another.
  *
@@ -21,6 +21,19 @@
 #define DVZ_MAX_VISUAL_GROUPS       1024
 #define DVZ_MAX_VISUAL_PRIORITY     4
 #define DVZ_MAX_UNIFORM_SIZE        65536
+#define DVZ_MAX_VISUAL_LOOKUP       128
+
+// Culling of the vertices outside of the view.
+#define DVZ_MAX_VISUAL_CHUNKS      256
+#define DVZ_VISUAL_CHUNK_MIN_SIZE  6144 // multiple of the number of vertices per primitive
+#define DVZ_VISUAL_CULL_DRAWS      16   // number of indirect draws of a culled pipeline
+#define DVZ_VISUAL_CULL_MARGIN     64   // in pixels, for primitives larger than their vertices
+
+// Size of the indirect draw region of a graphics pipeline: the indexed or non-indexed draw
+// arguments, or the draws of the culled chunks.
+#define DVZ_VISUAL_INDIRECT_SIZE                                                                  \
+    MAX(sizeof(VkDrawIndexedIndirectCommand),                                                     \
+        DVZ_VISUAL_CULL_DRAWS * sizeof(VkDrawIndirectCommand))
 
 
 /*************************************************************************************************/
@@ -75,6 +88,8 @@ typedef enum
     DVZ_PROP_INDEX,
     DVZ_PROP_SCALE,
     DVZ_PROP_TRANSFORM,
+    DVZ_PROP_VALUE,
+    DVZ_PROP_ANCHOR,
 } DvzPropType;
 
 
@@ -131,6 +146,7 @@ typedef enum
 typedef enum
 {
     DVZ_SOURCE_FLAG_MAPPABLE = 0x0001,
+    DVZ_SOURCE_FLAG_STORAGE = 0x0002, // vertex source also bound as a storage buffer at slot_idx
 } DvzSourceFlags;
 
 
@@ -159,6 +175,12 @@ typedef struct DvzProp DvzProp;
 typedef union DvzSourceUnion DvzSourceUnion;
 typedef struct DvzSource DvzSource;
 
+typedef struct DvzVisualRing DvzVisualRing;
+typedef struct DvzVisualLookup DvzVisualLookup;
+typedef struct DvzVisualChunks DvzVisualChunks;
+typedef struct DvzTextPool DvzTextPool;
+typedef struct DvzTextLabels DvzTextLabels;
+
 typedef struct DvzVisualFillEvent DvzVisualFillEvent;
 typedef struct DvzVisualDataEvent DvzVisualDataEvent;
 
@@ -222,6 +244,12 @@ struct DvzSource
     int flags;
     DvzArray arr; // array to be uploaded to that source
 
+    // Partial uploads: when set by the baking function, only the dirty region of the array is
+    // uploaded at the next visual update, unless the GPU buffer needs to be reallocated.
+    bool partial;
+    uint32_t dirty_first;
+    uint32_t dirty_count;
+
     DvzSourceOrigin origin; // whether the underlying GPU object is handled by the user or datoviz
     DvzSourceUnion u;
 };
@@ -252,6 +280,11 @@ struct DvzProp
     DvzDataType target_dtype; // used for casting during the copy to the vertex array
     DvzArrayCopyType copy_type;
     uint32_t reps; // number of repeats when copying
+    int dirty;     // pending scene updates, coalesced within a frame (DvzSceneDirtyFlags)
+
+    // Running bounds of the data of DVEC3 POS props, updated incrementally when writing data.
+    DvzBox bounds;     // raw min and max of arr_orig on each axis
+    bool bounds_valid; // false if values have been overwritten, requiring a full scan
     // bool is_set; // whether the user has set this prop
 };
 
@@ -261,6 +294,52 @@ struct DvzProp
 /*  Visual struct                                                                                */
 /*************************************************************************************************/
 
+// Streaming mode: the VERTEX #0 source is a fixed-capacity ring buffer written circularly.
+struct DvzVisualRing
+{
+    uint32_t capacity; // maximum number of items in the ring buffer, 0 if the ring is disabled
+    uint32_t head;     // index of the next item to be written
+    uint32_t count;    // number of valid items, up to capacity
+    uint32_t pending;  // number of items written since the last bake
+
+    // Region of the source array to upload at the next visual update.
+    uint32_t dirty_first;
+    uint32_t dirty_count;
+};
+
+
+
+// Spatial index of the vertex buffer of a graphics pipeline, split into chunks of contiguous
+// vertices with their bounding boxes. The runs of chunks in the view are drawn with a fixed
+// number of indirect draws, so that culling does not require recording the command buffers.
+struct DvzVisualChunks
+{
+    uint32_t vertex_count; // number of vertices in the vertex buffer
+    uint32_t chunk_size;   // number of vertices per chunk, except the last one
+    uint32_t chunk_count;
+    DvzBox boxes[DVZ_MAX_VISUAL_CHUNKS]; // in the coordinates of the vertex buffer
+
+    // Culling state: the transformation and bounds used for the current draws.
+    // The bounds are the margins transform and the tolerance on each axis (a, b, t for x and y).
+    bool culled;     // false if the draws need to be computed again
+    mat4 mvp;        // including the data normalization, zero if the chunks are not culled
+    float bounds[6]; // in normalized device coordinates
+    VkDrawIndirectCommand draws[DVZ_VISUAL_CULL_DRAWS];
+};
+
+
+
+// Open-addressing hash table mapping a (type, idx) pair to a prop or a source of a visual.
+struct DvzVisualLookup
+{
+    uint32_t count;
+    bool overflow; // if true, some items could not be inserted and lookups scan the container
+    uint32_t keys[DVZ_MAX_VISUAL_LOOKUP];
+    void* items[DVZ_MAX_VISUAL_LOOKUP]; // NULL for empty entries
+};
+
+
+
 struct DvzVisual
 {
     DvzObject obj;
@@ -268,6 +347,7 @@ struct DvzVisual
     int flags;
     int priority;
     void* user_data;
+    int dirty; // pending scene updates, coalesced within a frame (DvzSceneDirtyFlags)
 
     // Graphics.
     uint32_t graphics_count;
@@ -279,6 +359,13 @@ struct DvzVisual
     uint32_t prev_vertex_count[DVZ_MAX_GRAPHICS_PER_VISUAL];
     uint32_t prev_index_count[DVZ_MAX_GRAPHICS_PER_VISUAL];
 
+    // Indirect draw arguments of each graphics pipeline, stored on the GPU so that the recorded
+    // draw commands do not depend on the number of vertices/indices.
+    // The CPU copies must outlive the (possibly deferred) upload transfers.
+    DvzBufferRegions indirect[DVZ_MAX_GRAPHICS_PER_VISUAL];
+    VkDrawIndirectCommand indirect_args[DVZ_MAX_GRAPHICS_PER_VISUAL];
+    VkDrawIndexedIndirectCommand indirect_indexed_args[DVZ_MAX_GRAPHICS_PER_VISUAL];
+
     // Computes.
     uint32_t compute_count;
     DvzCompute* computes[DVZ_MAX_COMPUTES_PER_VISUAL];
@@ -292,14 +379,30 @@ struct DvzVisual
 
     // Sources.
     DvzContainer sources;
+    DvzVisualLookup source_lookup;
 
     // Props.
     DvzContainer props;
+    DvzVisualLookup prop_lookup;
 
     // User data
     uint32_t group_count;
     uint32_t group_sizes[DVZ_MAX_VISUAL_GROUPS];
 
+    // Streaming mode.
+    DvzVisualRing ring;
+
+    // Fixed slots of text labels, used by the baking function of visuals with text labels so
+    // that only the modified labels are laid out and uploaded.
+    DvzTextPool* text_pool;
+
+    // Packed copy of the labels of the text visual at the last bake, used to only lay out the
+    // modified labels.
+    DvzTextLabels* text_labels;
+
+    // Spatial index of the vertex buffer of each graphics pipeline, or NULL if it is not culled.
+    DvzVisualChunks* chunks[DVZ_MAX_GRAPHICS_PER_VISUAL];
+
     // Viewport.
     DvzInteractAxis interact_axis[DVZ_MAX_GRAPHICS_PER_VISUAL];
     DvzViewportClip clip[DVZ_MAX_GRAPHICS_PER_VISUAL];
@@ -308,6 +411,12 @@ struct DvzVisual
     // GPU data
     DvzContainer bindings;
     DvzContainer bindings_comp;
+
+    // Secondary command buffers with the draw commands of the visual, one per swapchain image,
+    // only re-recorded when the visual or its viewport has changed.
+    DvzCommands cmds;
+    bool cmds_recorded[DVZ_MAX_SWAPCHAIN_IMAGES];
+    DvzViewport cmds_viewport[DVZ_MAX_SWAPCHAIN_IMAGES];
 };
 
 
@@ -524,6 +633,34 @@ DVZ_EXPORT void dvz_visual_data_partial(
 DVZ_EXPORT void dvz_visual_data_append(
     DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, const void* data);
 
+/**
+ * Switch a visual to streaming mode, with a fixed-capacity ring buffer for the VERTEX #0 source.
+ *
+ * In streaming mode, the props associated to the VERTEX #0 source are written circularly with
+ * `dvz_visual_data_ring()`. Only the newly-written items are baked and uploaded to the GPU, the
+ * vertex count remains equal to the capacity, so that no command buffer refill is ever required.
+ *
+ * @param visual the visual
+ * @param capacity the maximum number of items kept in the ring buffer
+ */
+DVZ_EXPORT void dvz_visual_ring(DvzVisual* visual, uint32_t capacity);
+
+/**
+ * Write new items at the head of the ring buffer of a visual in streaming mode.
+ *
+ * All props written between two visual updates start at the same ring head, which advances by
+ * the largest number of items written at the next update. If more items than the capacity are
+ * passed, only the last ones are kept.
+ *
+ * @param visual the visual
+ * @param prop_type the prop type
+ * @param prop_idx the prop index
+ * @param count the number of items to write
+ * @param data the data, that should be in the dtype of the prop
+ */
+DVZ_EXPORT void dvz_visual_data_ring(
+    DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, const void* data);
+
 /**
  * Set partial data for a given source.
  *
@@ -599,6 +736,32 @@ DVZ_EXPORT void dvz_visual_fill_event(
     DvzVisual* visual, VkClearColorValue clear_color, DvzCommands* cmds, uint32_t cmd_idx,
     DvzViewport viewport, void* user_data);
 
+/**
+ * Mark the secondary command buffers of a visual as needing to be re-recorded.
+ *
+ * The command buffers are only re-recorded at the next canvas refill.
+ *
+ * @param visual the visual
+ */
+DVZ_EXPORT void dvz_visual_to_refill(DvzVisual* visual);
+
+/**
+ * Return the secondary command buffers of a visual, after recording the one for the given
+ * swapchain image if needed.
+ *
+ * The command buffer is recorded with the visual fill callback, and only if the visual has been
+ * marked with `dvz_visual_to_refill()` or if the viewport has changed since the last recording.
+ * It must be executed within a render pass begun with `dvz_cmd_begin_renderpass_secondary()`.
+ *
+ * @param visual the visual
+ * @param clear_color the clear color
+ * @param img_idx the swapchain image index
+ * @param viewport the viewport
+ * @returns the secondary command buffers
+ */
+DVZ_EXPORT DvzCommands* dvz_visual_fill_secondary(
+    DvzVisual* visual, VkClearColorValue clear_color, uint32_t img_idx, DvzViewport viewport);
+
 /**
  * Begin recording a command buffer and begin the render pass.
  *
@@ -679,6 +842,29 @@ DVZ_EXPORT DvzProp* dvz_prop_get(DvzVisual* visual, DvzPropType prop_type, uint3
 DVZ_EXPORT DvzArray* dvz_prop_array(DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx);
 
 
+/**
+ * Return the cached bounds of a POS prop, without scanning the data.
+ *
+ * The bounds are maintained incrementally when data is set, appended, or streamed. They become
+ * stale when values lying on them are overwritten, until the next full scan done by the scene.
+ *
+ * @param prop the prop
+ * @param[out] box the raw bounds of the data (min and max on each axis)
+ * @returns whether the cached bounds are available and up-to-date
+ */
+DVZ_EXPORT bool dvz_prop_bounds(DvzProp* prop, DvzBox* box);
+
+
+/**
+ * Return the cached bounds of all POS props of a visual, without scanning the data.
+ *
+ * @param visual the visual
+ * @param[out] box the merged raw bounds of the POS props
+ * @returns whether the cached bounds of all non-empty POS props are available and up-to-date
+ */
+DVZ_EXPORT bool dvz_visual_bounds(DvzVisual* visual, DvzBox* box);
+
+
 /**
  * Return the size of a prop array.
  *
@@ -714,6 +900,18 @@ DVZ_EXPORT void* dvz_prop_item(DvzProp* prop, uint32_t prop_idx);
 DVZ_EXPORT void dvz_visual_update(
     DvzVisual* visual, DvzViewport viewport, DvzDataCoords coords, const void* user_data);
 
+/**
+ * Only draw the chunks of the vertex buffers that are in the view of an MVP transformation.
+ *
+ * This only concerns the graphics pipelines with a spatial index, which is built when updating
+ * the visual for large non-indexed vertex buffers of points, lines, or triangles. The indirect
+ * draw commands are only uploaded when they change.
+ *
+ * @param visual the visual
+ * @param mvp the MVP transformation of the panel
+ */
+DVZ_EXPORT void dvz_visual_cull(DvzVisual* visual, DvzMVP* mvp);
+
 
 
 #endif
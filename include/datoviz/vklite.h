@@ -63,6 +63,7 @@ extern "C" {
 #define DVZ_MAX_DEPENDENCIES_PER_RENDERPASS 8
 #define DVZ_MAX_VERTEX_BINDINGS             16
 #define DVZ_MAX_VERTEX_ATTRS                32
+#define DVZ_MAX_SPECIALIZATION_CONSTANTS    16
 
 
 
@@ -84,6 +85,7 @@ typedef struct DvzBindings DvzBindings;
 typedef struct DvzCompute DvzCompute;
 typedef struct DvzVertexBinding DvzVertexBinding;
 typedef struct DvzVertexAttr DvzVertexAttr;
+typedef struct DvzSpecialization DvzSpecialization;
 typedef struct DvzGraphics DvzGraphics;
 typedef struct DvzBarrierBuffer DvzBarrierBuffer;
 typedef struct DvzBarrierImage DvzBarrierImage;
@@ -179,6 +181,8 @@ typedef enum
     DVZ_GRAPHICS_FAKE_SPHERE,
     DVZ_GRAPHICS_VOLUME,
 
+    DVZ_GRAPHICS_LINE_STREAM,
+
     DVZ_GRAPHICS_COUNT,
     DVZ_GRAPHICS_CUSTOM,
 } DvzGraphicsType;
@@ -340,6 +344,9 @@ struct DvzGpu
     VkPhysicalDeviceFeatures requested_features;
     VkDevice device;
 
+    VkPipelineCache pipeline_cache;
+    size_t pipeline_cache_size; // size of the data loaded from the pipeline cache file
+
     DvzContext* context;
 };
 
@@ -545,6 +552,18 @@ struct DvzVertexAttr
 
 
 
+// Values of the specialization constants of a pipeline, sorted by constant ID. Each value is
+// stored in its own 8-byte slot, the unused bytes are zero so that two sets of values can be
+// compared with memcmp().
+struct DvzSpecialization
+{
+    uint32_t count;
+    VkSpecializationMapEntry entries[DVZ_MAX_SPECIALIZATION_CONSTANTS];
+    uint64_t data[DVZ_MAX_SPECIALIZATION_CONSTANTS];
+};
+
+
+
 struct DvzGraphics
 {
     DvzObject obj;
@@ -575,6 +594,7 @@ struct DvzGraphics
     uint32_t shader_count;
     VkShaderStageFlagBits shader_stages[DVZ_MAX_SHADERS_PER_GRAPHICS];
     VkShaderModule shader_modules[DVZ_MAX_SHADERS_PER_GRAPHICS];
+    DvzSpecialization specialization; // applied to all shader stages
 
     DvzGraphicsCallback callback;
 };
@@ -821,6 +841,11 @@ DVZ_EXPORT void dvz_gpu_queue(DvzGpu* gpu, uint32_t idx, DvzQueueType type);
 /**
  * Create a GPU once the features and queues have been set up.
  *
+ * The pipelines of the GPU are created with a pipeline cache, loaded from a file in the cache
+ * directory (see `dvz_cache_dir()`) that is specific to the device and driver version. The file is
+ * updated when the GPU is destroyed. Set the `DVZ_PIPELINE_CACHE` environment variable to 0 to
+ * disable the cache file.
+ *
  * @param gpu the GPU
  * @param surface the surface on which the GPU will need to render
  */
@@ -1031,6 +1056,19 @@ DVZ_EXPORT void dvz_swapchain_destroy(DvzSwapchain* swapchain);
  */
 DVZ_EXPORT DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count);
 
+/**
+ * Create a set of secondary command buffers.
+ *
+ * Secondary command buffers are recorded independently and executed from a primary command
+ * buffer with `dvz_cmd_execute()`, within a render pass.
+ *
+ * @param gpu the GPU
+ * @param queue the queue index within the GPU
+ * @param count the number of command buffers to create
+ * @returns the set of command buffers
+ */
+DVZ_EXPORT DvzCommands dvz_commands_secondary(DvzGpu* gpu, uint32_t queue, uint32_t count);
+
 /**
  * Start recording a command buffer.
  *
@@ -1039,6 +1077,17 @@ DVZ_EXPORT DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count)
  */
 DVZ_EXPORT void dvz_cmd_begin(DvzCommands* cmds, uint32_t idx);
 
+/**
+ * Start recording a secondary command buffer that continues a render pass.
+ *
+ * @param cmds the set of secondary command buffers
+ * @param idx the index of the command buffer to begin recording on
+ * @param renderpass the render pass within which the command buffer will be executed
+ * @param framebuffers the framebuffers
+ */
+DVZ_EXPORT void dvz_cmd_begin_secondary(
+    DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass, DvzFramebuffers* framebuffers);
+
 /**
  * Stop recording a command buffer.
  *
@@ -1547,6 +1596,15 @@ DVZ_EXPORT void dvz_compute_create(DvzCompute* compute);
  */
 DVZ_EXPORT void dvz_compute_code(DvzCompute* compute, const char* code);
 
+/**
+ * Set the SPIRV code directly, for example a shader embedded in the library.
+ *
+ * @param compute the compute pipeline
+ * @param size the size of the SPIRV buffer, in bytes
+ * @param buffer the SPIRV code
+ */
+DVZ_EXPORT void dvz_compute_spirv(DvzCompute* compute, VkDeviceSize size, const uint32_t* buffer);
+
 /**
  * Declare a slot for the compute pipeline.
  *
@@ -1708,6 +1766,31 @@ DVZ_EXPORT void dvz_graphics_cull_mode(DvzGraphics* graphics, VkCullModeFlags cu
  */
 DVZ_EXPORT void dvz_graphics_front_face(DvzGraphics* graphics, VkFrontFace front_face);
 
+/**
+ * Set the value of a specialization constant in a set of specialization constants.
+ *
+ * @param specialization the set of specialization constants, zero-initialized before first use
+ * @param constant_id the ID of the specialization constant (`layout (constant_id = X)`)
+ * @param size the size of the value, in bytes (at most 8)
+ * @param value a pointer to the value
+ */
+DVZ_EXPORT void dvz_specialization_constant(
+    DvzSpecialization* specialization, uint32_t constant_id, VkDeviceSize size, const void* value);
+
+/**
+ * Set the value of a specialization constant of a graphics pipeline.
+ *
+ * The value is used by all shader stages that declare a specialization constant with this ID,
+ * so that the shader compiler can remove the branches that depend on it.
+ *
+ * @param graphics the graphics pipeline
+ * @param constant_id the ID of the specialization constant (`layout (constant_id = X)`)
+ * @param size the size of the value, in bytes (at most 8)
+ * @param value a pointer to the value
+ */
+DVZ_EXPORT void dvz_graphics_specialization(
+    DvzGraphics* graphics, uint32_t constant_id, VkDeviceSize size, const void* value);
+
 /**
  * Create a graphics pipeline after it has been set up.
  *
@@ -2148,6 +2231,26 @@ DVZ_EXPORT void dvz_submit_reset(DvzSubmit* submit);
 DVZ_EXPORT void dvz_cmd_begin_renderpass(
     DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass, DvzFramebuffers* framebuffers);
 
+/**
+ * Begin a render pass whose contents are recorded in secondary command buffers.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param renderpass the render pass
+ * @param framebuffers the framebuffers
+ */
+DVZ_EXPORT void dvz_cmd_begin_renderpass_secondary(
+    DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass, DvzFramebuffers* framebuffers);
+
+/**
+ * Execute a secondary command buffer.
+ *
+ * @param cmds the set of primary command buffers to record
+ * @param idx the index of the command buffer to record, and of the secondary command buffer
+ * @param secondary the set of secondary command buffers
+ */
+DVZ_EXPORT void dvz_cmd_execute(DvzCommands* cmds, uint32_t idx, DvzCommands* secondary);
+
 /**
  * End a render pass.
  *
@@ -2186,6 +2289,22 @@ DVZ_EXPORT void dvz_cmd_barrier(DvzCommands* cmds, uint32_t idx, DvzBarrier* bar
 DVZ_EXPORT void dvz_cmd_copy_buffer_to_image(
     DvzCommands* cmds, uint32_t idx, DvzBuffer* buffer, DvzImages* images);
 
+/**
+ * Copy a GPU buffer to a region of a GPU image.
+ *
+ * The buffer contains the region tightly packed, starting at the beginning of the buffer.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param buffer the buffer
+ * @param images the image
+ * @param offset the offset of the region within the image
+ * @param shape the shape of the region
+ */
+DVZ_EXPORT void dvz_cmd_copy_buffer_to_image_region(
+    DvzCommands* cmds, uint32_t idx, DvzBuffer* buffer, DvzImages* images, uvec3 offset,
+    uvec3 shape);
+
 /**
  * Copy a GPU image to a GPU buffer.
  *
@@ -2218,7 +2337,32 @@ dvz_cmd_copy_image(DvzCommands* cmds, uint32_t idx, DvzImages* src_img, DvzImage
 DVZ_EXPORT void dvz_cmd_viewport(DvzCommands* cmds, uint32_t idx, VkViewport viewport);
 
 /**
- * Bind a graphics pipeline.
+ * Bind a graphics pipeline, without its descriptor sets.
+ *
+ * Several draws sharing the same pipeline can be recorded after a single pipeline bind, each
+ * with its own descriptor sets bound with `dvz_cmd_bind_descriptors()`.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param graphics the graphics pipeline
+ */
+DVZ_EXPORT void dvz_cmd_bind_pipeline(DvzCommands* cmds, uint32_t idx, DvzGraphics* graphics);
+
+/**
+ * Bind the descriptor sets of a graphics pipeline.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param graphics the graphics pipeline
+ * @param bindings the bindings associated to the pipeline
+ * @param dynamic_idx the dynamic uniform buffer index
+ */
+DVZ_EXPORT void dvz_cmd_bind_descriptors(
+    DvzCommands* cmds, uint32_t idx, DvzGraphics* graphics, //
+    DvzBindings* bindings, uint32_t dynamic_idx);
+
+/**
+ * Bind a graphics pipeline and its descriptor sets.
  *
  * @param cmds the set of command buffers to record
  * @param idx the index of the command buffer to record
@@ -2285,6 +2429,20 @@ DVZ_EXPORT void dvz_cmd_draw_indexed(
  */
 DVZ_EXPORT void dvz_cmd_draw_indirect(DvzCommands* cmds, uint32_t idx, DvzBufferRegions indirect);
 
+/**
+ * Several indirect draws, with consecutive draw commands in the indirect buffer.
+ *
+ * This uses a single multi draw if the multiDrawIndirect feature has been requested, otherwise
+ * one draw per command.
+ *
+ * @param cmds the set of command buffers to record
+ * @param idx the index of the command buffer to record
+ * @param indirect buffer regions with the indirect draw commands
+ * @param draw_count the number of draw commands
+ */
+DVZ_EXPORT void dvz_cmd_draw_indirect_multi(
+    DvzCommands* cmds, uint32_t idx, DvzBufferRegions indirect, uint32_t draw_count);
+
 /**
  * Indirect indexed draw.
  *
@@ -0,0 +1,268 @@
+#include "../include/datoviz/atlas.h"
+
+// Optional Freetype support
+#if HAS_FREETYPE
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Utils                                                                                        */
+/*************************************************************************************************/
+
+// Slot of a codepoint in the glyph hash table, or of the empty slot where to insert it.
+static uint32_t _glyph_slot(DvzFontAtlas* atlas, uint32_t codepoint)
+{
+    ASSERT(atlas != NULL);
+    ASSERT(atlas->glyph_keys != NULL);
+    uint32_t capacity = 2 * atlas->cols * atlas->rows;
+    ASSERT((capacity & (capacity - 1)) == 0);
+
+    uint32_t slot = (codepoint * 2654435769u) & (capacity - 1);
+    while (atlas->glyph_keys[slot] != 0 && atlas->glyph_keys[slot] != codepoint + 1)
+        slot = (slot + 1) & (capacity - 1);
+    return slot;
+}
+
+
+
+static void _glyph_insert(DvzFontAtlas* atlas, uint32_t codepoint, uint32_t cell)
+{
+    ASSERT(atlas != NULL);
+    uint32_t slot = _glyph_slot(atlas, codepoint);
+    atlas->glyph_keys[slot] = codepoint + 1;
+    atlas->glyph_cells[slot] = cell;
+}
+
+
+
+// Mark the row of a glyph cell as to be uploaded.
+static void _glyph_dirty(DvzFontAtlas* atlas, uint32_t cell)
+{
+    ASSERT(atlas != NULL);
+    uint32_t row = cell / atlas->cols;
+    if (atlas->dirty_count == 0)
+    {
+        atlas->dirty_first = row;
+        atlas->dirty_count = 1;
+        return;
+    }
+    uint32_t end = MAX(atlas->dirty_first + atlas->dirty_count, row + 1);
+    atlas->dirty_first = MIN(atlas->dirty_first, row);
+    atlas->dirty_count = end - atlas->dirty_first;
+}
+
+
+
+#if HAS_FREETYPE
+// Rasterize a glyph at a high resolution, and write its signed distance field in a glyph cell.
+static bool _glyph_rasterize(DvzFontAtlas* atlas, uint32_t codepoint, uint32_t cell)
+{
+    ASSERT(atlas != NULL);
+    ASSERT(atlas->ft_face != NULL);
+    ASSERT(cell < atlas->cols * atlas->rows);
+    FT_Face face = (FT_Face)atlas->ft_face;
+
+    FT_UInt index = FT_Get_Char_Index(face, codepoint);
+    if (index == 0 || FT_Load_Glyph(face, index, FT_LOAD_RENDER) != 0)
+        return false;
+    FT_GlyphSlot slot = face->glyph;
+    FT_Bitmap* bitmap = &slot->bitmap;
+
+    // Draw the glyph in the high-resolution cell, centered horizontally, on the baseline.
+    uint32_t f = DVZ_FONT_ATLAS_SDF_FACTOR;
+    uint32_t cw = (uint32_t)atlas->glyph_width, ch = (uint32_t)atlas->glyph_height;
+    int32_t w = (int32_t)(f * cw), h = (int32_t)(f * ch);
+    uint8_t* coverage = (uint8_t*)calloc((uint32_t)(w * h), sizeof(uint8_t));
+    int32_t x0 = (w - (int32_t)(slot->advance.x >> 6)) / 2 + slot->bitmap_left;
+    int32_t y0 = atlas->ft_baseline - slot->bitmap_top;
+    int32_t x = 0, y = 0;
+    for (int32_t r = 0; r < (int32_t)bitmap->rows; r++)
+    {
+        for (int32_t c = 0; c < (int32_t)bitmap->width; c++)
+        {
+            x = x0 + c;
+            y = y0 + r;
+            if (x < 0 || y < 0 || x >= w || y >= h)
+                continue;
+            coverage[y * w + x] = bitmap->buffer[r * bitmap->pitch + c];
+        }
+    }
+
+    // Compute the signed distance field directly in the atlas texture.
+    uint32_t row = cell / atlas->cols, col = cell % atlas->cols;
+    uint32_t stride = 4 * atlas->width;
+    _font_sdf(
+        coverage, (uint32_t)w, (uint32_t)h, f,
+        &atlas->font_texture[row * ch * stride + 4 * col * cw], stride);
+
+    FREE(coverage);
+    return true;
+}
+#endif
+
+
+
+/*************************************************************************************************/
+/*  SDF font atlas                                                                               */
+/*************************************************************************************************/
+
+DvzFontAtlas dvz_font_atlas_sdf(DvzContext* ctx, const char* font_path)
+{
+    ASSERT(ctx != NULL);
+    ASSERT(font_path != NULL);
+
+#if HAS_FREETYPE
+    FT_Library library = NULL;
+    FT_Face face = NULL;
+    if (FT_Init_FreeType(&library) != 0)
+    {
+        log_error("unable to initialize Freetype, using the default font atlas");
+        return dvz_font_atlas(ctx);
+    }
+    if (FT_New_Face(library, font_path, 0, &face) != 0 || !FT_IS_SCALABLE(face))
+    {
+        log_error("unable to load font %s, using the default font atlas", font_path);
+        if (face != NULL)
+            FT_Done_Face(face);
+        FT_Done_FreeType(library);
+        return dvz_font_atlas(ctx);
+    }
+
+    // The line height fits in the cell height, with a margin of the distance range.
+    uint32_t f = DVZ_FONT_ATLAS_SDF_FACTOR;
+    uint32_t margin = DVZ_FONT_ATLAS_SDF_RANGE;
+    double line = f * (DVZ_FONT_ATLAS_SDF_HEIGHT - 2 * margin);
+    double line_units = face->ascender - face->descender;
+    ASSERT(line_units > 0);
+    FT_Set_Pixel_Sizes(face, 0, (FT_UInt)floor(line * face->units_per_EM / line_units));
+
+    // NOTE: the text shader lays out the glyphs with a fixed advance, the width of the cells,
+    // which is the advance of the M character.
+    uint32_t advance = (uint32_t)line / 2;
+    if (FT_Load_Char(face, 'M', FT_LOAD_DEFAULT) == 0)
+        advance = (uint32_t)(face->glyph->advance.x >> 6);
+
+    DvzFontAtlas atlas = {0};
+    atlas.sdf = true;
+    atlas.ft_library = library;
+    atlas.ft_face = face;
+    atlas.ft_baseline = (int32_t)(f * margin) + (int32_t)(face->size->metrics.ascender >> 6);
+
+    atlas.font_str = DVZ_FONT_ATLAS_STRING;
+    atlas.cols = DVZ_FONT_ATLAS_SDF_COLS;
+    atlas.rows = DVZ_FONT_ATLAS_SDF_ROWS;
+    atlas.glyph_width = ceil(advance / (double)f);
+    atlas.glyph_height = DVZ_FONT_ATLAS_SDF_HEIGHT;
+    atlas.width = atlas.cols * (uint32_t)atlas.glyph_width;
+    atlas.height = atlas.rows * (uint32_t)atlas.glyph_height;
+    atlas.font_texture = (uint8_t*)calloc(atlas.width * atlas.height, 4);
+
+    uint32_t capacity = 2 * atlas.cols * atlas.rows;
+    atlas.glyph_keys = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+    atlas.glyph_cells = (uint32_t*)calloc(capacity, sizeof(uint32_t));
+
+    // The printable ASCII characters have the same cells as in the precomputed atlas, even if
+    // they are missing in the font.
+    uint32_t n = strlen(DVZ_FONT_ATLAS_STRING);
+    uint32_t codepoint = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        codepoint = (uint8_t)DVZ_FONT_ATLAS_STRING[i];
+        _glyph_rasterize(&atlas, codepoint, i);
+        _glyph_insert(&atlas, codepoint, i);
+    }
+    atlas.glyph_count = n;
+
+    log_debug(
+        "created SDF font atlas %dx%d from %s, glyph cell %.0fx%.0f", atlas.width, atlas.height,
+        font_path, atlas.glyph_width, atlas.glyph_height);
+    atlas.texture = _font_texture(ctx, &atlas);
+    return atlas;
+#else
+    log_error("Datoviz was built without Freetype, using the default font atlas");
+    return dvz_font_atlas(ctx);
+#endif
+}
+
+
+
+uint32_t dvz_font_atlas_glyph(DvzFontAtlas* atlas, uint32_t codepoint)
+{
+    ASSERT(atlas != NULL);
+    ASSERT(atlas->font_str != NULL);
+
+    // Precomputed atlas: printable ASCII characters only.
+    if (!atlas->sdf)
+    {
+        char c[2] = {(char)codepoint, 0};
+        uint32_t n = strlen(atlas->font_str);
+        uint32_t cell = codepoint > 0 && codepoint < 128 ? strcspn(atlas->font_str, c) : n;
+        if (cell >= n)
+            cell = strcspn(atlas->font_str, "?");
+        return cell;
+    }
+
+    uint32_t slot = _glyph_slot(atlas, codepoint);
+    if (atlas->glyph_keys[slot] != 0)
+        return atlas->glyph_cells[slot];
+
+    // Rasterize the glyph in the next free cell.
+    uint32_t cell = atlas->glyph_count;
+    bool ok = cell < atlas->cols * atlas->rows;
+#if HAS_FREETYPE
+    ok = ok && _glyph_rasterize(atlas, codepoint, cell);
+#endif
+    if (!ok)
+    {
+        log_debug("glyph U+%04X missing in the font or font atlas full", codepoint);
+        return dvz_font_atlas_glyph(atlas, '?');
+    }
+    _glyph_insert(atlas, codepoint, cell);
+    _glyph_dirty(atlas, cell);
+    atlas->glyph_count++;
+    return cell;
+}
+
+
+
+void dvz_font_atlas_upload(DvzFontAtlas* atlas)
+{
+    ASSERT(atlas != NULL);
+    if (!atlas->sdf || atlas->dirty_count == 0)
+        return;
+    ASSERT(atlas->texture != NULL);
+    ASSERT(atlas->font_texture != NULL);
+
+    // Only upload the rows of cells with new glyphs.
+    uint32_t ch = (uint32_t)atlas->glyph_height;
+    uint32_t y = atlas->dirty_first * ch;
+    uint32_t h = atlas->dirty_count * ch;
+    ASSERT(y + h <= atlas->height);
+    log_debug("upload rows %d-%d of the font atlas", y, y + h);
+    dvz_texture_upload(
+        atlas->texture, (uvec3){0, y, 0}, (uvec3){atlas->width, h, 1}, atlas->width * h * 4,
+        &atlas->font_texture[y * atlas->width * 4]);
+    atlas->dirty_count = 0;
+}
+
+
+
+void dvz_font_atlas_sdf_destroy(DvzFontAtlas* atlas)
+{
+    ASSERT(atlas != NULL);
+    ASSERT(atlas->sdf);
+#if HAS_FREETYPE
+    if (atlas->ft_face != NULL)
+        FT_Done_Face((FT_Face)atlas->ft_face);
+    if (atlas->ft_library != NULL)
+        FT_Done_FreeType((FT_Library)atlas->ft_library);
+#endif
+    FREE(atlas->font_texture);
+    FREE(atlas->glyph_keys);
+    FREE(atlas->glyph_cells);
+    atlas->ft_face = NULL;
+    atlas->ft_library = NULL;
+}
@@ -15,6 +15,59 @@
 
 
 
+/*************************************************************************************************/
+/*  Axes worker structs                                                                          */
+/*************************************************************************************************/
+
+typedef struct DvzAxesRequest DvzAxesRequest;
+typedef struct DvzAxesResult DvzAxesResult;
+typedef DvzAxesResult* DvzAxesResultPtr;
+
+
+
+// Tick computation request sent by the main loop to the axes worker thread.
+struct DvzAxesRequest
+{
+    bool stop;           // stop the worker thread
+    uint32_t generation; // see DvzAxesWorker.generation
+    bool update[2];      // the axes to update
+    dvec2 range[2];
+    DvzAxesContext ctx[2];
+};
+
+
+
+// Ticks computed by the worker thread, waiting to be swapped in by the main loop.
+struct DvzAxesResult
+{
+    uint32_t generation;
+    DvzAxesContext ctx;
+    DvzAxesTicks ticks;
+};
+
+
+
+struct DvzAxesWorker
+{
+    DvzThread thread;
+    DvzFifo requests;
+
+    // The ticks cache is shared by the worker and the synchronous tick computations.
+    DvzTicksCache* cache;
+    pthread_mutex_t cache_lock;
+
+    // Latest results, swapped atomically: the worker replaces them, the main loop takes them.
+    atomic(DvzAxesResultPtr, pending[2]);
+
+    // Only accessed by the main loop.
+    bool in_flight[2];       // whether a request is being processed, to avoid flooding the worker
+    bool deferred[2];        // whether a range arrived while a request was in flight
+    dvec2 deferred_range[2]; // latest such range, sent once the in-flight ticks are swapped in
+    uint32_t generation;     // incremented when the ticks are reset, to discard obsolete results
+};
+
+
+
 /*************************************************************************************************/
 /*  Axes functions                                                                               */
 /*************************************************************************************************/
@@ -89,7 +142,13 @@ static void _axes_ticks(DvzController* controller, DvzAxisCoord coord, dvec2 ran
         dvz_ticks_destroy(&axes->ticks[coord]);
 
     // Determine the tick number and positions.
-    axes->ticks[coord] = dvz_ticks(vmin, vmax, ctx);
+    if (axes->ticks_cache == NULL)
+        axes->ticks_cache = (DvzTicksCache*)calloc(1, sizeof(DvzTicksCache));
+    if (axes->worker != NULL)
+        pthread_mutex_lock(&axes->worker->cache_lock);
+    axes->ticks[coord] = dvz_ticks_cached(axes->ticks_cache, vmin, vmax, ctx);
+    if (axes->worker != NULL)
+        pthread_mutex_unlock(&axes->worker->cache_lock);
 
     // We keep track of the context.
     axes->ctx[coord] = ctx;
@@ -161,6 +220,258 @@ static void _axes_upload(DvzController* controller, DvzAxisCoord coord)
 
 
 
+/*************************************************************************************************/
+/*  Axes worker                                                                                  */
+/*************************************************************************************************/
+
+static void _axes_result_destroy(DvzAxesResult* result)
+{
+    if (result == NULL)
+        return;
+    dvz_ticks_destroy(&result->ticks);
+    FREE(result);
+}
+
+
+
+// Merge an older request into a newer one, for the axes that the newer one does not update.
+static void _axes_request_merge(DvzAxesRequest* older, DvzAxesRequest* newer)
+{
+    ASSERT(older != NULL);
+    ASSERT(newer != NULL);
+    if (older->stop || newer->stop || older->generation != newer->generation)
+        return;
+    for (uint32_t coord = 0; coord < 2; coord++)
+    {
+        if (!older->update[coord] || newer->update[coord])
+            continue;
+        newer->update[coord] = true;
+        newer->range[coord][0] = older->range[coord][0];
+        newer->range[coord][1] = older->range[coord][1];
+        newer->ctx[coord] = older->ctx[coord];
+    }
+}
+
+
+
+// Worker thread computing the ticks and labels in the background.
+static void* _axes_worker(void* user_data)
+{
+    DvzAxesWorker* worker = (DvzAxesWorker*)user_data;
+    ASSERT(worker != NULL);
+    log_debug("starting axes worker thread");
+
+    DvzAxesRequest* req = NULL;
+    DvzAxesRequest* next = NULL;
+    DvzAxesResult* result = NULL;
+    while (true)
+    {
+        req = (DvzAxesRequest*)dvz_fifo_dequeue(&worker->requests, true);
+        ASSERT(req != NULL);
+
+        // Only process the most recent request if several ones are pending.
+        while (!req->stop &&
+               (next = (DvzAxesRequest*)dvz_fifo_dequeue(&worker->requests, false)) != NULL)
+        {
+            _axes_request_merge(req, next);
+            FREE(req);
+            req = next;
+        }
+        if (req->stop)
+        {
+            FREE(req);
+            break;
+        }
+
+        for (uint32_t coord = 0; coord < 2; coord++)
+        {
+            if (!req->update[coord])
+                continue;
+            result = (DvzAxesResult*)calloc(1, sizeof(DvzAxesResult));
+            result->generation = req->generation;
+            result->ctx = req->ctx[coord];
+
+            pthread_mutex_lock(&worker->cache_lock);
+            result->ticks = dvz_ticks_cached(
+                worker->cache, req->range[coord][0], req->range[coord][1], req->ctx[coord]);
+            pthread_mutex_unlock(&worker->cache_lock);
+
+            // Publish the ticks, replacing the previous ones if they were not consumed yet.
+            _axes_result_destroy(atomic_exchange(&worker->pending[coord], result));
+        }
+        FREE(req);
+    }
+
+    log_debug("stopping axes worker thread");
+    return NULL;
+}
+
+
+
+static DvzAxesWorker* _axes_worker_start(DvzAxes2D* axes)
+{
+    ASSERT(axes != NULL);
+    if (axes->ticks_cache == NULL)
+        axes->ticks_cache = (DvzTicksCache*)calloc(1, sizeof(DvzTicksCache));
+
+    DvzAxesWorker* worker = (DvzAxesWorker*)calloc(1, sizeof(DvzAxesWorker));
+    worker->requests = dvz_fifo(DVZ_MAX_FIFO_CAPACITY);
+    worker->cache = axes->ticks_cache;
+    if (pthread_mutex_init(&worker->cache_lock, NULL) != 0)
+        log_error("mutex creation failed");
+    atomic_init(&worker->pending[0], NULL);
+    atomic_init(&worker->pending[1], NULL);
+
+    // NOTE: the worker must be fully initialized before the thread starts.
+    worker->thread = dvz_thread(_axes_worker, worker);
+    return worker;
+}
+
+
+
+// Discard the ticks being computed in the background.
+static void _axes_worker_reset(DvzAxesWorker* worker)
+{
+    ASSERT(worker != NULL);
+    worker->generation++;
+    for (uint32_t coord = 0; coord < 2; coord++)
+    {
+        _axes_result_destroy(atomic_exchange(&worker->pending[coord], NULL));
+        worker->in_flight[coord] = false;
+        worker->deferred[coord] = false;
+    }
+}
+
+
+
+static void _axes_worker_stop(DvzAxesWorker* worker)
+{
+    ASSERT(worker != NULL);
+
+    DvzAxesRequest* req = (DvzAxesRequest*)calloc(1, sizeof(DvzAxesRequest));
+    req->stop = true;
+    dvz_fifo_enqueue(&worker->requests, req);
+    dvz_thread_join(&worker->thread);
+
+    // Free the requests that were not processed.
+    while ((req = (DvzAxesRequest*)dvz_fifo_dequeue(&worker->requests, false)) != NULL)
+        FREE(req);
+    dvz_fifo_destroy(&worker->requests);
+
+    for (uint32_t coord = 0; coord < 2; coord++)
+        _axes_result_destroy(atomic_exchange(&worker->pending[coord], NULL));
+    pthread_mutex_destroy(&worker->cache_lock);
+}
+
+
+
+// Swap in the ticks computed in the background, and update the axes visuals.
+static void _axes_worker_swap(DvzController* controller)
+{
+    ASSERT(controller != NULL);
+    DvzAxes2D* axes = &controller->u.axes_2D;
+    DvzAxesWorker* worker = axes->worker;
+    if (worker == NULL)
+        return;
+
+    DvzAxesResult* result = NULL;
+    for (uint32_t coord = 0; coord < 2; coord++)
+    {
+        result = atomic_exchange(&worker->pending[coord], NULL);
+        if (result == NULL)
+            continue;
+        worker->in_flight[coord] = false;
+        if (result->generation == worker->generation)
+        {
+            dvz_ticks_destroy(&axes->ticks[coord]);
+            axes->ticks[coord] = result->ticks;
+            axes->ctx[coord] = result->ctx;
+            // NOTE: the ticks are now owned by the axes.
+            memset(&result->ticks, 0, sizeof(DvzAxesTicks));
+            _axes_upload(controller, (DvzAxisCoord)coord);
+        }
+        _axes_result_destroy(result);
+    }
+}
+
+
+
+// Send a tick computation request to the worker, which is started if needed.
+static void _axes_worker_request(DvzController* controller, bool* update, dvec2* range)
+{
+    ASSERT(controller != NULL);
+    DvzAxes2D* axes = &controller->u.axes_2D;
+    if (axes->worker == NULL)
+        axes->worker = _axes_worker_start(axes);
+    DvzAxesWorker* worker = axes->worker;
+    ASSERT(worker != NULL);
+
+    DvzAxesRequest* req = (DvzAxesRequest*)calloc(1, sizeof(DvzAxesRequest));
+    req->generation = worker->generation;
+    for (uint32_t coord = 0; coord < 2; coord++)
+    {
+        if (!update[coord])
+            continue;
+        req->update[coord] = true;
+        req->range[coord][0] = range[coord][0];
+        req->range[coord][1] = range[coord][1];
+        req->ctx[coord] = _axes_context(controller, (DvzAxisCoord)coord);
+        worker->in_flight[coord] = true;
+        worker->deferred[coord] = false;
+    }
+    dvz_fifo_enqueue(&worker->requests, req);
+}
+
+
+
+// Send the ranges that arrived while a request was in flight, once that request has completed.
+// This ensures the ticks match the final range after the interaction has stopped.
+static void _axes_worker_deferred(DvzController* controller)
+{
+    ASSERT(controller != NULL);
+    DvzAxesWorker* worker = controller->u.axes_2D.worker;
+    if (worker == NULL)
+        return;
+
+    bool update[2] = {false, false};
+    bool send = false;
+    for (uint32_t coord = 0; coord < 2; coord++)
+    {
+        update[coord] = worker->deferred[coord] && !worker->in_flight[coord];
+        send |= update[coord];
+    }
+    if (send)
+        _axes_worker_request(controller, update, worker->deferred_range);
+}
+
+
+
+// Post new ranges to the worker. Only one request per axis is in flight, except if force is true
+// (after a resize, as the axes context has changed). The latest range arriving in the meantime is
+// sent afterwards.
+static void _axes_worker_post(DvzController* controller, bool* update, dvec2* range, bool force)
+{
+    ASSERT(controller != NULL);
+    DvzAxesWorker* worker = controller->u.axes_2D.worker;
+
+    bool send = false;
+    for (uint32_t coord = 0; coord < 2; coord++)
+    {
+        if (update[coord] && worker != NULL && worker->in_flight[coord] && !force)
+        {
+            worker->deferred[coord] = true;
+            worker->deferred_range[coord][0] = range[coord][0];
+            worker->deferred_range[coord][1] = range[coord][1];
+            update[coord] = false;
+        }
+        send |= update[coord];
+    }
+    if (send)
+        _axes_worker_request(controller, update, range);
+}
+
+
+
 // Update the axes to the extent defined by the DvzDataCoords struct in the DvzPanel
 static void _axes_set(DvzController* controller, DvzBox box)
 {
@@ -179,6 +490,10 @@ static void _axes_set(DvzController* controller, DvzBox box)
     _check_box(box);
     axes->box = box;
 
+    // The ticks being computed in the background are now obsolete.
+    if (axes->worker != NULL)
+        _axes_worker_reset(axes->worker);
+
     for (uint32_t coord = 0; coord < 2; coord++)
     {
         // Compute the ticks for these ranges.
@@ -304,6 +619,13 @@ static void _axes_refresh(DvzController* controller, bool force)
     DvzPanel* panel = controller->panel;
     ASSERT(panel != NULL);
 
+    DvzAxes2D* axes = &controller->u.axes_2D;
+
+    // Show the ticks computed in the background as soon as they are ready. Until then, the
+    // previous ticks remain visible and follow the panzoom.
+    _axes_worker_swap(controller);
+    _axes_worker_deferred(controller);
+
     if (!force && !controller->interacts[0].is_active && !canvas->resized)
         return;
 
@@ -338,16 +660,22 @@ static void _axes_refresh(DvzController* controller, bool force)
         update[1] = true;
     }
 
-    for (uint32_t coord = 0; coord < 2; coord++)
+    // Forced refreshes are synchronous.
+    if (force)
     {
-        if (!update[coord])
-            continue;
-        _axes_ticks(controller, (DvzAxisCoord)coord, range[coord]);
-        _axes_upload(controller, (DvzAxisCoord)coord);
-
-        // TODO: what else to do here? update a request??
-        // canvas->obj.status = DVZ_OBJECT_STATUS_NEED_UPDATE;
+        if (axes->worker != NULL)
+            _axes_worker_reset(axes->worker);
+        for (uint32_t coord = 0; coord < 2; coord++)
+        {
+            _axes_ticks(controller, (DvzAxisCoord)coord, range[coord]);
+            _axes_upload(controller, (DvzAxisCoord)coord);
+        }
+        return;
     }
+
+    // During interaction, the ticks are computed in the background so that the frame is not
+    // delayed.
+    _axes_worker_post(controller, update, range, canvas->resized);
 }
 
 
@@ -362,6 +690,22 @@ static void _axes_callback(DvzController* controller, DvzEvent ev)
 
 
 
+// Replace a graphics pipeline of an axes visual with the variant specialized on its clip mode,
+// so that the fragment shaders do not branch on the viewport.
+// NOTE: the variant has the same shaders and slots as the generic graphics, so that the bindings
+// of the visual remain compatible with it.
+static void _axes_graphics_clip(DvzVisual* visual, uint32_t pidx, DvzGraphicsType type)
+{
+    ASSERT(visual != NULL);
+    ASSERT(pidx < visual->graphics_count);
+    DvzSpecialization spec = {0};
+    int32_t clip = (int32_t)visual->clip[pidx];
+    dvz_specialization_constant(&spec, DVZ_SPECIALIZATION_CLIP, sizeof(clip), &clip);
+    visual->graphics[pidx] = dvz_graphics_variant(visual->canvas, type, 0, &spec);
+}
+
+
+
 static void _axes_visual(DvzController* controller, DvzAxisCoord coord)
 {
     ASSERT(controller != NULL);
@@ -391,6 +735,8 @@ static void _axes_visual(DvzController* controller, DvzAxisCoord coord)
 
     visual->clip[0] = DVZ_VIEWPORT_OUTER;
     visual->clip[1] = coord == 0 ? DVZ_VIEWPORT_OUTER_BOTTOM : DVZ_VIEWPORT_OUTER_LEFT;
+    _axes_graphics_clip(visual, 0, DVZ_GRAPHICS_SEGMENT);
+    _axes_graphics_clip(visual, 1, DVZ_GRAPHICS_TEXT);
 
     visual->interact_axis[0] = visual->interact_axis[1] =
         (coord == 0 ? DVZ_INTERACT_FIXED_AXIS_Y : DVZ_INTERACT_FIXED_AXIS_X) >> 12;
@@ -440,10 +786,22 @@ static void _axes_destroy(DvzController* controller)
     DvzAxes2D* axes = &controller->u.axes_2D;
     ASSERT(axes != NULL);
 
+    if (axes->worker != NULL)
+    {
+        _axes_worker_stop(axes->worker);
+        FREE(axes->worker);
+    }
+
     for (uint32_t i = 0; i < 2; i++)
     {
         dvz_ticks_destroy(&axes->ticks[i]);
     }
+
+    if (axes->ticks_cache != NULL)
+    {
+        dvz_ticks_cache_destroy(axes->ticks_cache);
+        FREE(axes->ticks_cache);
+    }
 }
 
 
@@ -1,5 +1,6 @@
 #include "../include/datoviz/builtin_visuals.h"
 #include "../include/datoviz/array.h"
+#include "../include/datoviz/atlas.h"
 #include "../include/datoviz/interact.h"
 #include "../include/datoviz/mesh.h"
 #include "visuals_utils.h"
@@ -12,6 +13,57 @@
 /*************************************************************************************************/
 /*************************************************************************************************/
 
+/*************************************************************************************************/
+/*  Basic vertex                                                                                 */
+/*************************************************************************************************/
+
+static inline bool _is_double_pos(DvzVisual* visual)
+{
+    return (visual->flags & DVZ_GRAPHICS_FLAGS_DOUBLE_POS) != 0;
+}
+
+
+
+// Vertex buffer source of the visuals using DvzVertex, or DvzVertexDouble with the emulated double
+// positions.
+static void _basic_vertex_source(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    VkDeviceSize item_size = _is_double_pos(visual) ? sizeof(DvzVertexDouble) : sizeof(DvzVertex);
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, 0, item_size, 0);
+}
+
+
+
+// Vertex pos and color props. With the emulated double positions, the dvec3 positions are cast
+// into pairs of hi + lo vec3 fields. Return the color prop.
+static DvzProp* _basic_vertex_props(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzProp* prop = NULL;
+
+    // Vertex pos.
+    prop = dvz_visual_prop(visual, DVZ_PROP_POS, 0, DVZ_DTYPE_DVEC3, DVZ_SOURCE_TYPE_VERTEX, 0);
+    if (_is_double_pos(visual))
+        dvz_visual_prop_cast(
+            prop, 0, offsetof(DvzVertexDouble, pos), DVZ_DTYPE_DVEC3_HILO, DVZ_ARRAY_COPY_SINGLE,
+            1);
+    else
+        dvz_visual_prop_cast(
+            prop, 0, offsetof(DvzVertex, pos), DVZ_DTYPE_VEC3, DVZ_ARRAY_COPY_SINGLE, 1);
+
+    // Vertex color.
+    prop = dvz_visual_prop(visual, DVZ_PROP_COLOR, 0, DVZ_DTYPE_CVEC4, DVZ_SOURCE_TYPE_VERTEX, 0);
+    if (_is_double_pos(visual))
+        dvz_visual_prop_copy(prop, 2, offsetof(DvzVertexDouble, color), DVZ_ARRAY_COPY_SINGLE, 1);
+    else
+        dvz_visual_prop_copy(prop, 1, offsetof(DvzVertex, color), DVZ_ARRAY_COPY_SINGLE, 1);
+    return prop;
+}
+
+
+
 /*************************************************************************************************/
 /*  Point                                                                                        */
 /*************************************************************************************************/
@@ -27,8 +79,7 @@ static void _visual_point(DvzVisual* visual)
     dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_POINT, visual->flags));
 
     // Sources
-    dvz_visual_source(
-        visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, 0, sizeof(DvzVertex), 0);
+    _basic_vertex_source(visual);
     _common_sources(visual);
     dvz_visual_source(
         visual, DVZ_SOURCE_TYPE_PARAM, 0, DVZ_PIPELINE_GRAPHICS, 0, DVZ_USER_BINDING,
@@ -36,14 +87,8 @@ static void _visual_point(DvzVisual* visual)
 
     // Props:
 
-    // Vertex pos.
-    prop = dvz_visual_prop(visual, DVZ_PROP_POS, 0, DVZ_DTYPE_DVEC3, DVZ_SOURCE_TYPE_VERTEX, 0);
-    dvz_visual_prop_cast(
-        prop, 0, offsetof(DvzVertex, pos), DVZ_DTYPE_VEC3, DVZ_ARRAY_COPY_SINGLE, 1);
-
-    // Vertex color.
-    prop = dvz_visual_prop(visual, DVZ_PROP_COLOR, 0, DVZ_DTYPE_CVEC4, DVZ_SOURCE_TYPE_VERTEX, 0);
-    dvz_visual_prop_copy(prop, 1, offsetof(DvzVertex, color), DVZ_ARRAY_COPY_SINGLE, 1);
+    // Vertex pos and color.
+    prop = _basic_vertex_props(visual);
     cvec4 color = {200, 200, 200, 255};
     dvz_visual_prop_default(prop, &color);
 
@@ -205,23 +250,17 @@ static void _visual_line_strip(DvzVisual* visual)
     DvzProp* prop = NULL;
 
     // Graphics.
-    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_LINE_STRIP, 0));
+    int flags = visual->flags & DVZ_GRAPHICS_FLAGS_DOUBLE_POS;
+    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_LINE_STRIP, flags));
 
     // Sources
-    dvz_visual_source(
-        visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, 0, sizeof(DvzVertex), 0);
+    _basic_vertex_source(visual);
     _common_sources(visual);
 
     // Props:
 
-    // Vertex pos.
-    prop = dvz_visual_prop(visual, DVZ_PROP_POS, 0, DVZ_DTYPE_DVEC3, DVZ_SOURCE_TYPE_VERTEX, 0);
-    dvz_visual_prop_cast(
-        prop, 0, offsetof(DvzVertex, pos), DVZ_DTYPE_VEC3, DVZ_ARRAY_COPY_SINGLE, 1);
-
-    // Vertex color.
-    prop = dvz_visual_prop(visual, DVZ_PROP_COLOR, 0, DVZ_DTYPE_CVEC4, DVZ_SOURCE_TYPE_VERTEX, 0);
-    dvz_visual_prop_copy(prop, 1, offsetof(DvzVertex, color), DVZ_ARRAY_COPY_SINGLE, 1);
+    // Vertex pos and color.
+    _basic_vertex_props(visual);
 
     // Line strip length.
     prop = dvz_visual_prop(visual, DVZ_PROP_LENGTH, 0, DVZ_DTYPE_UINT, DVZ_SOURCE_TYPE_NONE, 0);
@@ -235,6 +274,84 @@ static void _visual_line_strip(DvzVisual* visual)
 
 
 
+/*************************************************************************************************/
+/*  Line stream                                                                                  */
+/*************************************************************************************************/
+
+static void _line_stream_bake(DvzVisual* visual, DvzVisualDataEvent ev)
+{
+    ASSERT(visual != NULL);
+
+    // Bake the samples written since the last update, this advances the ring head.
+    _default_visual_bake(visual, ev);
+
+    // Pass the ring state to the vertex shader, which computes the x coordinates.
+    DvzVisualRing* ring = &visual->ring;
+    uvec4 ring_params = {ring->capacity, ring->head, ring->count, 0};
+    dvz_visual_data(visual, DVZ_PROP_INDEX, 0, 1, ring_params);
+}
+
+static void _visual_line_stream(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzProp* prop = NULL;
+
+    // Graphics.
+    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_LINE_STREAM, 0));
+
+    // Sources
+    // NOTE: the vertex buffer is also bound as a storage buffer, the vertex shader fetches the
+    // samples directly from the ring buffer.
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, DVZ_USER_BINDING + 1,
+        sizeof(DvzGraphicsLineStreamVertex), DVZ_SOURCE_FLAG_STORAGE);
+    _common_sources(visual);
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_PARAM, 0, DVZ_PIPELINE_GRAPHICS, 0, DVZ_USER_BINDING,
+        sizeof(DvzGraphicsLineStreamParams), 0);
+
+    // Props:
+
+    // Sample value.
+    prop = dvz_visual_prop(visual, DVZ_PROP_VALUE, 0, DVZ_DTYPE_FLOAT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 0, offsetof(DvzGraphicsLineStreamVertex, y), DVZ_ARRAY_COPY_SINGLE, 1);
+    float value = 0;
+    dvz_visual_prop_default(prop, &value);
+
+    // Sample color.
+    prop = dvz_visual_prop(visual, DVZ_PROP_COLOR, 0, DVZ_DTYPE_CVEC4, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_copy(
+        prop, 1, offsetof(DvzGraphicsLineStreamVertex, color), DVZ_ARRAY_COPY_SINGLE, 1);
+    cvec4 color = {200, 200, 200, 255};
+    dvz_visual_prop_default(prop, &color);
+
+    // Common props.
+    _common_props(visual);
+
+    // Param: ring state, set automatically by the baking function.
+    prop = dvz_visual_prop(visual, DVZ_PROP_INDEX, 0, DVZ_DTYPE_UVEC4, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 0, offsetof(DvzGraphicsLineStreamParams, ring), DVZ_ARRAY_COPY_SINGLE, 1);
+
+    // Param: range of the sample values.
+    prop = dvz_visual_prop(visual, DVZ_PROP_RANGE, 0, DVZ_DTYPE_VEC2, DVZ_SOURCE_TYPE_PARAM, 0);
+    dvz_visual_prop_copy(
+        prop, 1, offsetof(DvzGraphicsLineStreamParams, yrange), DVZ_ARRAY_COPY_SINGLE, 1);
+    vec2 yrange = {-1, +1};
+    dvz_visual_prop_default(prop, yrange);
+
+    // Streaming mode.
+    dvz_visual_ring(visual, DVZ_DEFAULT_LINE_STREAM_CAPACITY);
+
+    // Baking function.
+    dvz_visual_callback_bake(visual, _line_stream_bake);
+}
+
+
+
 /*************************************************************************************************/
 /*  Triangle                                                                                     */
 /*************************************************************************************************/
@@ -1011,6 +1128,460 @@ static void _visual_image_cmap(DvzVisual* visual)
 
 
 
+/*************************************************************************************************/
+/*  Text                                                                                         */
+/*************************************************************************************************/
+
+// The label strings are packed in a single buffer at every bake, along with the common vertex
+// and the glyph range of every label. When the number of glyphs of every label is unchanged, the
+// vertex array is kept and only the labels that differ from the previous bake are laid out and
+// uploaded.
+
+static float DVZ_DEFAULT_TEXT_SIZE = 12.0f;
+
+typedef struct DvzTextLabel DvzTextLabel;
+
+struct DvzTextLabel
+{
+    uint32_t offset;              // offset of the string in the packed string buffer
+    uint32_t first_glyph;         // index of the first glyph in the vertex array
+    uint32_t glyph_count;         // number of glyphs (codepoints)
+    DvzGraphicsTextVertex vertex; // vertex shared by all glyphs of the label
+};
+
+struct DvzTextLabels
+{
+    DvzTexture* texture;  // font atlas texture used for the glyph indices
+    uint32_t count;       // number of labels
+    uint32_t glyph_count; // total number of glyphs
+    char* chars;          // packed null-terminated strings, stored after the labels
+    DvzTextLabel labels[];
+};
+
+
+
+// Item of a per-label prop, the last item being repeated if the prop has fewer items.
+static void* _text_prop_item(DvzProp* prop, uint32_t idx)
+{
+    ASSERT(prop != NULL);
+    DvzArray* arr = _prop_array(prop);
+    if (arr->item_count == 0)
+        return prop->default_value;
+    return dvz_array_item(arr, MIN(idx, arr->item_count - 1));
+}
+
+
+
+// Bind the current font atlas, which may have been replaced since the last bake.
+static void _text_atlas(DvzVisual* visual, DvzFontAtlas* atlas)
+{
+    ASSERT(visual != NULL);
+    ASSERT(atlas != NULL);
+    ASSERT(atlas->texture != NULL);
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_FONT_ATLAS, 0);
+    if (source->origin != DVZ_SOURCE_ORIGIN_NONE && source->u.tex == atlas->texture)
+        return;
+
+    dvz_visual_texture(visual, DVZ_SOURCE_TYPE_FONT_ATLAS, 0, atlas->texture);
+    DvzGraphicsTextParams params = {0};
+    params.grid_size[0] = (int32_t)atlas->rows;
+    params.grid_size[1] = (int32_t)atlas->cols;
+    params.tex_size[0] = (int32_t)atlas->width;
+    params.tex_size[1] = (int32_t)atlas->height;
+    dvz_visual_data_source(visual, DVZ_SOURCE_TYPE_PARAM, 0, 0, 1, 1, &params);
+}
+
+
+
+// Whether a label is identical in two bakes with the same glyph ranges.
+static bool _text_label_eq(DvzTextLabels* labels, DvzTextLabels* prev, uint32_t idx)
+{
+    ASSERT(labels != NULL);
+    ASSERT(prev != NULL);
+    ASSERT(idx < labels->count && idx < prev->count);
+    DvzTextLabel* label = &labels->labels[idx];
+    DvzTextLabel* other = &prev->labels[idx];
+    return memcmp(&label->vertex, &other->vertex, sizeof(DvzGraphicsTextVertex)) == 0 &&
+           strcmp(&labels->chars[label->offset], &prev->chars[other->offset]) == 0;
+}
+
+
+
+// Lay out the glyphs of a label directly in the vertex array.
+static void _text_layout(
+    DvzFontAtlas* atlas, DvzTextLabel* label, const char* str, uint32_t idx,
+    DvzGraphicsTextVertex* vertices)
+{
+    ASSERT(atlas != NULL);
+    ASSERT(label != NULL);
+    ASSERT(str != NULL);
+    ASSERT(vertices != NULL);
+
+    DvzGraphicsTextVertex vertex = label->vertex;
+    vertex.glyph[2] = label->glyph_count; // str len
+    // NOTE: the string index only needs to differ between successive labels, so that the
+    // fragment shader discards the triangles connecting them.
+    vertex.glyph[3] = idx & 0xFFFF; // str idx
+
+    uint32_t codepoint = 0;
+    DvzGraphicsTextVertex* v = &vertices[4 * label->first_glyph];
+    for (uint32_t i = 0; i < label->glyph_count; i++)
+    {
+        str += _utf8_decode(str, &codepoint);
+        vertex.glyph[0] = dvz_font_atlas_glyph(atlas, codepoint); // char
+        vertex.glyph[1] = i;                                      // char idx
+        v[0] = v[1] = v[2] = v[3] = vertex;
+        v += 4;
+    }
+}
+
+
+
+static void _visual_text_bake(DvzVisual* visual, DvzVisualDataEvent ev)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzFontAtlas* atlas = &canvas->gpu->context->font_atlas;
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    _text_atlas(visual, atlas);
+
+    DvzArray* arr_text = dvz_prop_array(visual, DVZ_PROP_TEXT, 0);
+    uint32_t n = arr_text->item_count;
+    if (n == 0)
+    {
+        log_warn("skip text visual bake as TEXT not set");
+        return;
+    }
+    char** strings = (char**)arr_text->data;
+
+    DvzProp* prop_pos = dvz_prop_get(visual, DVZ_PROP_POS, 0);
+    DvzProp* prop_color = dvz_prop_get(visual, DVZ_PROP_COLOR, 0);
+    DvzProp* prop_size = dvz_prop_get(visual, DVZ_PROP_TEXT_SIZE, 0);
+    DvzProp* prop_anchor = dvz_prop_get(visual, DVZ_PROP_ANCHOR, 0);
+    DvzProp* prop_angle = dvz_prop_get(visual, DVZ_PROP_ANGLE, 0);
+    ASSERT(_prop_array(prop_pos)->item_count > 0);
+
+    // Pack the strings after the labels, in a single block.
+    VkDeviceSize size = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        ASSERT(strings[i] != NULL);
+        size += strlen(strings[i]) + 1;
+    }
+    DvzTextLabels* labels = calloc(1, sizeof(DvzTextLabels) + n * sizeof(DvzTextLabel) + size);
+    labels->texture = atlas->texture;
+    labels->count = n;
+    labels->chars = (char*)&labels->labels[n];
+
+    // The vertex array is kept if the glyph ranges of all labels are unchanged.
+    DvzTextLabels* prev = visual->text_labels;
+    bool full = prev == NULL || prev->count != n || prev->texture != atlas->texture ||
+                source->arr.item_count != 4 * prev->glyph_count;
+
+    // Pack the strings and compute the label vertices in a single pass.
+    DvzTextLabel* label = NULL;
+    DvzGraphicsTextVertex* vertex = NULL;
+    uint32_t offset = 0, glyph = 0, len = 0;
+    float font_size = 0;
+    double* pos = NULL;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        label = &labels->labels[i];
+        len = strlen(strings[i]);
+        memcpy(&labels->chars[offset], strings[i], len + 1);
+        label->offset = offset;
+        label->first_glyph = glyph;
+        label->glyph_count = _utf8_length(strings[i]);
+        offset += len + 1;
+        glyph += label->glyph_count;
+        full = full || label->glyph_count != prev->labels[i].glyph_count;
+
+        // NOTE: the label block is zero-initialized, so that the vertices can be compared with
+        // memcmp.
+        vertex = &label->vertex;
+        pos = _text_prop_item(prop_pos, i);
+        vertex->pos[0] = pos[0];
+        vertex->pos[1] = pos[1];
+        vertex->pos[2] = pos[2];
+        memcpy(vertex->color, _text_prop_item(prop_color, i), sizeof(cvec4));
+        memcpy(vertex->anchor, _text_prop_item(prop_anchor, i), sizeof(vec2));
+        vertex->angle = *(float*)_text_prop_item(prop_angle, i);
+        font_size = *(float*)_text_prop_item(prop_size, i);
+        DPI_SCALE(font_size)
+        _font_atlas_glyph_size(atlas, font_size, vertex->glyph_size);
+    }
+    labels->glyph_count = glyph;
+    if (glyph == 0)
+    {
+        // Clear the glyphs of the previous labels.
+        log_debug("all text labels are empty");
+        FREE(labels);
+        FREE(visual->text_labels);
+        dvz_array_resize(&source->arr, 0);
+        source->partial = false;
+        _source_set_changed(source, true);
+        return;
+    }
+
+    // Lay out all labels, or only those that differ from the previous bake.
+    if (full)
+        dvz_array_resize(&source->arr, 4 * labels->glyph_count);
+    DvzGraphicsTextVertex* vertices = source->arr.data;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        label = &labels->labels[i];
+        if (!full && _text_label_eq(labels, prev, i))
+            continue;
+        _text_layout(atlas, label, &labels->chars[label->offset], i, vertices);
+        if (!full)
+            _source_dirty(source, 4 * label->first_glyph, 4 * label->glyph_count);
+    }
+    source->partial = !full;
+
+    FREE(visual->text_labels)
+    visual->text_labels = labels;
+}
+
+static void _visual_text(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzProp* prop = NULL;
+
+    // Graphics.
+    dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_TEXT, 0));
+
+    // Sources
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_VERTEX, 0, DVZ_PIPELINE_GRAPHICS, 0, 0,
+        sizeof(DvzGraphicsTextVertex), 0);
+    _common_sources(visual);
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_PARAM, 0, DVZ_PIPELINE_GRAPHICS, 0, DVZ_USER_BINDING,
+        sizeof(DvzGraphicsTextParams), 0);
+    dvz_visual_source(
+        visual, DVZ_SOURCE_TYPE_FONT_ATLAS, 0, DVZ_PIPELINE_GRAPHICS, 0, DVZ_USER_BINDING + 1,
+        sizeof(cvec4), 0);
+
+    // Props: one item per label, laid out by the baking function.
+
+    // Label position.
+    prop = dvz_visual_prop(visual, DVZ_PROP_POS, 0, DVZ_DTYPE_DVEC3, DVZ_SOURCE_TYPE_VERTEX, 0);
+
+    // Label text.
+    prop = dvz_visual_prop(visual, DVZ_PROP_TEXT, 0, DVZ_DTYPE_STR, DVZ_SOURCE_TYPE_VERTEX, 0);
+
+    // Label color.
+    prop = dvz_visual_prop(visual, DVZ_PROP_COLOR, 0, DVZ_DTYPE_CVEC4, DVZ_SOURCE_TYPE_VERTEX, 0);
+    cvec4 color = {0, 0, 0, 255};
+    dvz_visual_prop_default(prop, &color);
+
+    // Font size.
+    prop =
+        dvz_visual_prop(visual, DVZ_PROP_TEXT_SIZE, 0, DVZ_DTYPE_FLOAT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    dvz_visual_prop_default(prop, &DVZ_DEFAULT_TEXT_SIZE);
+
+    // Label anchor, in normalized coordinates of the label box: (0, 0) is the center.
+    prop = dvz_visual_prop(visual, DVZ_PROP_ANCHOR, 0, DVZ_DTYPE_VEC2, DVZ_SOURCE_TYPE_VERTEX, 0);
+    vec2 anchor = {0, 0};
+    dvz_visual_prop_default(prop, anchor);
+
+    // Label angle.
+    prop = dvz_visual_prop(visual, DVZ_PROP_ANGLE, 0, DVZ_DTYPE_FLOAT, DVZ_SOURCE_TYPE_VERTEX, 0);
+    float angle = 0;
+    dvz_visual_prop_default(prop, &angle);
+
+    // Common props.
+    _common_props(visual);
+
+    // Baking function.
+    dvz_visual_callback_bake(visual, _visual_text_bake);
+}
+
+
+
+/*************************************************************************************************/
+/*  Text pool                                                                                    */
+/*************************************************************************************************/
+
+// The text vertex array is split into fixed slots of DVZ_TEXT_POOL_GLYPHS glyphs, one label per
+// slot. Labels that are still displayed after a bake keep their slot, so that only the slots of
+// the new and removed labels are laid out and uploaded. The unused glyphs of a slot have a zero
+// size, and a string index differing from the label glyphs so that the fragment shader discards
+// the triangles connecting them in the triangle strip.
+
+#define DVZ_TEXT_POOL_GLYPHS    24 // glyphs per slot, the labels must be shorter
+#define DVZ_TEXT_POOL_MIN_SLOTS 16
+#define DVZ_TEXT_POOL_MAX_SLOTS 256
+
+typedef struct DvzTextPoolSlot DvzTextPoolSlot;
+
+struct DvzTextPoolSlot
+{
+    bool used; // whether the slot holds a label
+    bool kept; // whether the label is still displayed after the current bake
+    vec3 pos;
+    char label[DVZ_TEXT_POOL_GLYPHS];
+};
+
+struct DvzTextPool
+{
+    uint32_t slot_count;
+    DvzGraphicsTextItem item; // common parameters of all labels
+    DvzTextPoolSlot slots[];
+};
+
+
+
+static void _text_pool_slot(DvzFontAtlas* atlas, DvzTextPool* pool, DvzArray* arr, uint32_t s)
+{
+    ASSERT(atlas != NULL);
+    ASSERT(pool != NULL);
+    ASSERT(arr != NULL);
+    ASSERT(s < pool->slot_count);
+
+    DvzTextPoolSlot* slot = &pool->slots[s];
+    uint32_t n = slot->used ? _utf8_length(slot->label) : 0;
+    ASSERT(n < DVZ_TEXT_POOL_GLYPHS);
+    const char* str = slot->label;
+    uint32_t codepoint = 0;
+
+    DvzGraphicsTextVertex vertex = pool->item.vertex;
+    glm_vec3_copy(slot->pos, vertex.pos);
+    vec2 glyph_size = {0};
+    _font_atlas_glyph_size(atlas, pool->item.font_size, glyph_size);
+
+    DvzGraphicsTextVertex* vertices = dvz_array_item(arr, 4 * DVZ_TEXT_POOL_GLYPHS * s);
+    for (uint32_t i = 0; i < DVZ_TEXT_POOL_GLYPHS; i++)
+    {
+        bool visible = i < n;
+        if (visible)
+            str += _utf8_decode(str, &codepoint);
+        vertex.glyph_size[0] = visible ? glyph_size[0] : 0;
+        vertex.glyph_size[1] = visible ? glyph_size[1] : 0;
+        vertex.glyph[0] = visible ? dvz_font_atlas_glyph(atlas, codepoint) : 0; // char
+        vertex.glyph[1] = i;                                                  // char idx
+        vertex.glyph[2] = n;                                                  // str len
+        vertex.glyph[3] = 2 * s + (visible ? 0 : 1);                          // str idx
+        for (uint32_t j = 0; j < 4; j++)
+            vertices[4 * i + j] = vertex;
+    }
+}
+
+
+
+/**
+ * Lay out labels in the text pool of a visual, and mark the modified slots as dirty.
+ *
+ * The pool is (re)created, and the whole array laid out, when it is too small or when the common
+ * label parameters change.
+ *
+ * @param visual the visual
+ * @param source the text vertex source
+ * @param item the common label parameters, the string and position are ignored
+ * @param count the number of labels
+ * @param labels the labels
+ * @param positions the label positions
+ * @returns false if the labels do not fit in the pool, in which case nothing is done
+ */
+static bool _text_pool_bake(
+    DvzVisual* visual, DvzSource* source, DvzGraphicsTextItem* item, uint32_t count,
+    char** labels, vec3* positions)
+{
+    ASSERT(visual != NULL);
+    ASSERT(source != NULL);
+    ASSERT(item != NULL);
+    DvzFontAtlas* atlas = &visual->canvas->gpu->context->font_atlas;
+
+    if (count > DVZ_TEXT_POOL_MAX_SLOTS)
+        return false;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        ASSERT(labels[i] != NULL);
+        if (strlen(labels[i]) >= DVZ_TEXT_POOL_GLYPHS)
+            return false;
+    }
+
+    DvzTextPool* pool = visual->text_pool;
+    DvzArray* arr = &source->arr;
+    uint32_t slot_count = MAX(DVZ_TEXT_POOL_MIN_SLOTS, dvz_next_pow2(count));
+    bool full = pool == NULL || pool->slot_count < slot_count ||
+                memcmp(&pool->item.vertex, &item->vertex, sizeof(DvzGraphicsTextVertex)) != 0 ||
+                pool->item.font_size != item->font_size;
+    if (full)
+    {
+        FREE(visual->text_pool)
+        pool = visual->text_pool =
+            calloc(1, sizeof(DvzTextPool) + slot_count * sizeof(DvzTextPoolSlot));
+        pool->slot_count = slot_count;
+        pool->item = *item;
+        dvz_array_resize(arr, 4 * DVZ_TEXT_POOL_GLYPHS * slot_count);
+    }
+    ASSERT(pool != NULL);
+    ASSERT(arr->item_count == 4 * DVZ_TEXT_POOL_GLYPHS * pool->slot_count);
+
+    // Keep the slots of the labels that are still displayed.
+    uint32_t idx[DVZ_TEXT_POOL_MAX_SLOTS] = {0};
+    DvzTextPoolSlot* slot = NULL;
+    for (uint32_t s = 0; s < pool->slot_count; s++)
+        pool->slots[s].kept = false;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        idx[i] = UINT32_MAX;
+        for (uint32_t s = 0; s < pool->slot_count; s++)
+        {
+            slot = &pool->slots[s];
+            if (slot->used && !slot->kept && glm_vec3_eqv(slot->pos, positions[i]) &&
+                strcmp(slot->label, labels[i]) == 0)
+            {
+                slot->kept = true;
+                idx[i] = s;
+                break;
+            }
+        }
+    }
+
+    // Free the slots of the labels that are not displayed anymore.
+    bool stale[DVZ_TEXT_POOL_MAX_SLOTS] = {0};
+    for (uint32_t s = 0; s < pool->slot_count; s++)
+    {
+        slot = &pool->slots[s];
+        stale[s] = full || (slot->used && !slot->kept);
+        slot->used = slot->kept;
+    }
+
+    // Put the new labels in the free slots.
+    uint32_t s = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (idx[i] != UINT32_MAX)
+            continue;
+        while (pool->slots[s].used)
+            s++;
+        ASSERT(s < pool->slot_count);
+        slot = &pool->slots[s];
+        slot->used = true;
+        glm_vec3_copy(positions[i], slot->pos);
+        strcpy(slot->label, labels[i]);
+        stale[s] = true;
+    }
+
+    // Only lay out and upload the modified slots.
+    for (s = 0; s < pool->slot_count; s++)
+    {
+        if (!stale[s])
+            continue;
+        _text_pool_slot(atlas, pool, arr, s);
+        _source_dirty(source, 4 * DVZ_TEXT_POOL_GLYPHS * s, 4 * DVZ_TEXT_POOL_GLYPHS);
+    }
+    source->partial = true;
+    return true;
+}
+
+
+
 /*************************************************************************************************/
 /*  Axes 2D                                                                                      */
 /*************************************************************************************************/
@@ -1048,7 +1619,7 @@ static uint32_t _count_chars(DvzArray* arr_text)
     for (uint32_t i = 0; i < n_text; i++)
     {
         str = ((char**)arr_text->data)[i];
-        slen = strlen(str);
+        slen = _utf8_length(str);
         ASSERT(slen > 0);
         char_count += slen;
     }
@@ -1268,9 +1839,6 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
     n_text = MIN(n_text, n_major);
     ASSERT(n_text > 0);
 
-    // Allocate the text vertex array.
-    dvz_graphics_alloc(&text_data, count_chars);
-
     char* text = NULL;
     DvzGraphicsTextItem str_item = {0};
     double* x = NULL;
@@ -1291,16 +1859,34 @@ static void _visual_axes_2D_bake(DvzVisual* visual, DvzVisualDataEvent ev)
         str_item.vertex.shift[0] = -10;
     }
     str_item.vertex.color[3] = 255;
+    str_item.font_size = font_size;
+
+    // Position of the text corresponds to position of the major tick.
+    char** labels = (char**)arr_text->data;
+    vec3 positions[DVZ_TEXT_POOL_MAX_SLOTS] = {0};
+    for (uint32_t i = 0; i < MIN(n_text, DVZ_TEXT_POOL_MAX_SLOTS); i++)
+    {
+        x = dvz_prop_item(prop_major, i);
+        ASSERT(x != NULL);
+        _tick_pos(*x, DVZ_AXES_LEVEL_MAJOR, coord, positions[i], P);
+    }
+
+    // When panning, most labels remain the same: only lay out and upload the modified ones.
+    if (_text_pool_bake(visual, text_vert_src, &str_item, n_text, labels, positions))
+        return;
+
+    // Otherwise, lay out all labels.
+    FREE(visual->text_pool)
+    text_vert_src->partial = false;
+    dvz_graphics_alloc(&text_data, count_chars);
     for (uint32_t i = 0; i < n_text; i++)
     {
         // Add text.
-        text = ((char**)arr_text->data)[i];
+        text = labels[i];
         ASSERT(text != NULL);
         ASSERT(strlen(text) > 0);
-        str_item.font_size = font_size;
         str_item.string = text;
 
-        // Position of the text corresponds to position of the major tick.
         x = dvz_prop_item(prop_major, i);
         ASSERT(x != NULL);
         _tick_pos(*x, DVZ_AXES_LEVEL_MAJOR, coord, str_item.vertex.pos, P);
@@ -1317,6 +1903,8 @@ static void _visual_axes_2D(DvzVisual* visual)
     DvzProp* prop = NULL;
 
     // Graphics.
+    // NOTE: the axes controller replaces these graphics with variants specialized on its clip
+    // modes, see _axes_visual() in axes.h.
     dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_SEGMENT, 0));
     dvz_visual_graphics(visual, dvz_graphics_builtin(canvas, DVZ_GRAPHICS_TEXT, 0));
 
@@ -1921,6 +2509,10 @@ void dvz_visual_builtin(DvzVisual* visual, DvzVisualType type, int flags)
         _visual_line_strip(visual);
         break;
 
+    case DVZ_VISUAL_LINE_STREAM:
+        _visual_line_stream(visual);
+        break;
+
     case DVZ_VISUAL_TRIANGLE:
         _visual_triangle(visual);
         break;
@@ -1947,6 +2539,10 @@ void dvz_visual_builtin(DvzVisual* visual, DvzVisualType type, int flags)
         _visual_path(visual);
         break;
 
+    case DVZ_VISUAL_TEXT:
+        _visual_text(visual);
+        break;
+
     case DVZ_VISUAL_IMAGE:
         _visual_image(visual);
         break;
@@ -1510,6 +1510,159 @@ void dvz_event_stop(DvzCanvas* canvas)
 /*  Screencast                                                                                   */
 /*************************************************************************************************/
 
+// Row strides of the YUV420 planes, such that the conversion shader only writes whole words, and
+// total size of the planes.
+static VkDeviceSize _screencast_yuv_size(uint32_t width, uint32_t height, uint32_t* linesizes)
+{
+    ASSERT(linesizes != NULL);
+    linesizes[1] = linesizes[2] = 4 * ((width + 7) / 8);
+    linesizes[0] = 2 * linesizes[1];
+    return (VkDeviceSize)linesizes[0] * height +
+           2 * (VkDeviceSize)linesizes[1] * ((height + 1) / 2);
+}
+
+
+
+// Whole-buffer regions for the barriers, which use the region of the command buffer index.
+static DvzBufferRegions _screencast_regions(DvzBuffer* buffer, uint32_t count)
+{
+    ASSERT(buffer != NULL);
+    ASSERT(count <= DVZ_MAX_BUFFER_REGIONS_PER_SET);
+    DvzBufferRegions br = {0};
+    br.buffer = buffer;
+    br.count = count;
+    br.size = buffer->size;
+    return br;
+}
+
+
+
+// (Re)create the buffers of the YUV420 conversion with the size of the swapchain images.
+static void _screencast_yuv_buffers(DvzScreencast* screencast)
+{
+    ASSERT(screencast != NULL);
+    ASSERT(screencast->compute != NULL);
+    DvzGpu* gpu = screencast->canvas->gpu;
+    DvzImages* images = screencast->canvas->swapchain.images;
+
+    VkDeviceSize source_size = images->width * images->height * 4;
+    VkDeviceSize planes_size =
+        _screencast_yuv_size(images->width, images->height, screencast->linesizes);
+
+    DvzScreencastSlot* slot = NULL;
+    for (uint32_t k = 0; k < DVZ_SCREENCAST_DEPTH; k++)
+    {
+        slot = &screencast->slots[k];
+        if (dvz_obj_is_created(&slot->source.obj))
+            dvz_buffer_destroy(&slot->source);
+        if (dvz_obj_is_created(&slot->planes.obj))
+            dvz_buffer_destroy(&slot->planes);
+
+        // The frame is copied and converted on the GPU.
+        slot->source = dvz_buffer(gpu);
+        dvz_buffer_size(&slot->source, source_size);
+        dvz_buffer_usage(
+            &slot->source, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        dvz_buffer_memory(&slot->source, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        dvz_buffer_queue_access(&slot->source, DVZ_DEFAULT_QUEUE_RENDER);
+        dvz_buffer_create(&slot->source);
+
+        // Only the planes are read back.
+        slot->planes = dvz_buffer(gpu);
+        dvz_buffer_size(&slot->planes, planes_size);
+        dvz_buffer_usage(&slot->planes, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        dvz_buffer_memory(
+            &slot->planes,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        dvz_buffer_queue_access(&slot->planes, DVZ_DEFAULT_QUEUE_RENDER);
+        dvz_buffer_create(&slot->planes);
+
+        dvz_bindings_buffer(
+            &slot->bindings, 0, dvz_buffer_regions(&slot->source, 1, 0, source_size, 0));
+        dvz_bindings_buffer(
+            &slot->bindings, 1, dvz_buffer_regions(&slot->planes, 1, 0, planes_size, 0));
+        dvz_bindings_update(&slot->bindings);
+    }
+}
+
+
+
+// Create the compute shader of the YUV420 conversion, with one set of bindings per slot.
+static void _screencast_yuv_compute(DvzScreencast* screencast)
+{
+    ASSERT(screencast != NULL);
+    ASSERT(screencast->compute == NULL);
+    DvzGpu* gpu = screencast->canvas->gpu;
+
+    DvzCompute* compute = dvz_ctx_compute(gpu->context, "screencast_yuv_comp");
+    dvz_compute_slot(compute, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    dvz_compute_slot(compute, 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    dvz_compute_push(compute, 0, 5 * sizeof(uint32_t), VK_SHADER_STAGE_COMPUTE_BIT);
+
+    // The shader is embedded in the library.
+    unsigned long size = 0;
+    const unsigned char* buffer = dvz_resource_shader("screencast_yuv_comp", &size);
+    ASSERT(buffer != NULL);
+    ASSERT(size > 0 && size % 4 == 0);
+    uint32_t* code = (uint32_t*)calloc(size, 1);
+    memcpy(code, buffer, size);
+    dvz_compute_spirv(compute, size, code);
+    FREE(code);
+
+    for (uint32_t k = 0; k < DVZ_SCREENCAST_DEPTH; k++)
+        screencast->slots[k].bindings = dvz_bindings(&compute->slots, 1);
+    screencast->compute = compute;
+    _screencast_yuv_buffers(screencast);
+
+    dvz_compute_bindings(compute, &screencast->slots[0].bindings);
+    dvz_compute_create(compute);
+}
+
+
+
+// Record the conversion of the frame copied in the source buffer of a slot to YUV420 planes.
+static void _screencast_yuv_cmds(DvzScreencast* screencast, uint32_t k, uint32_t i)
+{
+    ASSERT(screencast != NULL);
+    ASSERT(screencast->compute != NULL);
+    DvzGpu* gpu = screencast->canvas->gpu;
+    DvzImages* images = screencast->canvas->swapchain.images;
+    DvzScreencastSlot* slot = &screencast->slots[k];
+    DvzCommands* cmds = &slot->cmds;
+
+    // The conversion waits for the copy.
+    DvzBarrier barrier = dvz_barrier(gpu);
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    dvz_barrier_buffer(&barrier, _screencast_regions(&slot->source, images->count));
+    dvz_barrier_buffer_access(&barrier, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    dvz_cmd_barrier(cmds, i, &barrier);
+
+    // NOTE: the bindings of the slot are bound when recording the command buffer.
+    dvz_compute_bindings(screencast->compute, &slot->bindings);
+    bool swizzle = images->format == VK_FORMAT_B8G8R8A8_UNORM ||
+                   images->format == VK_FORMAT_B8G8R8A8_SRGB;
+    uint32_t push[5] = {
+        images->width, images->height, screencast->linesizes[0], screencast->linesizes[1],
+        swizzle};
+    dvz_cmd_push(
+        cmds, i, &screencast->compute->slots, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push),
+        push);
+    // Each invocation converts 8x2 pixels, with 8x8 invocations per workgroup.
+    dvz_cmd_compute(
+        cmds, i, screencast->compute,
+        (uvec3){(images->width + 63) / 64, (images->height + 15) / 16, 1});
+
+    // The planes are read by the host once the fence is signaled.
+    DvzBarrier host = dvz_barrier(gpu);
+    dvz_barrier_stages(&host, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+    dvz_barrier_buffer(&host, _screencast_regions(&slot->planes, images->count));
+    dvz_barrier_buffer_access(&host, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT);
+    dvz_cmd_barrier(cmds, i, &host);
+}
+
+
+
 static void _screencast_cmds(DvzScreencast* screencast)
 {
     ASSERT(screencast != NULL);
@@ -1523,29 +1676,139 @@ static void _screencast_cmds(DvzScreencast* screencast)
     dvz_barrier_stages(&barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
     dvz_barrier_images(&barrier, images);
 
-    for (uint32_t i = 0; i < img_count; i++)
+    DvzCommands* cmds = NULL;
+    for (uint32_t k = 0; k < DVZ_SCREENCAST_DEPTH; k++)
+    {
+        cmds = &screencast->slots[k].cmds;
+        for (uint32_t i = 0; i < img_count; i++)
+        {
+            dvz_cmd_reset(cmds, i);
+            dvz_cmd_begin(cmds, i);
+
+            // Transition to SRC layout
+            dvz_barrier_images_layout(
+                &barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+            dvz_barrier_images_access(
+                &barrier, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+            dvz_cmd_barrier(cmds, i, &barrier);
+
+            // Copy swapchain image to screencast image, or to the buffer converted to YUV420.
+            if (screencast->yuv)
+                dvz_cmd_copy_image_to_buffer(cmds, i, images, &screencast->slots[k].source);
+            else
+                dvz_cmd_copy_image(cmds, i, images, &screencast->slots[k].staging);
+
+            // Transition back to previous layout
+            dvz_barrier_images_layout(
+                &barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+            dvz_barrier_images_access(
+                &barrier, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+            dvz_cmd_barrier(cmds, i, &barrier);
+
+            if (screencast->yuv)
+                _screencast_yuv_cmds(screencast, k, i);
+
+            dvz_cmd_end(cmds, i);
+        }
+    }
+}
+
+
+
+// Take a frame buffer from the pool, or return NULL if they are all in use.
+static uint8_t* _screencast_frame(DvzScreencast* screencast, VkDeviceSize size)
+{
+    ASSERT(screencast != NULL);
+    ASSERT(size > 0);
+
+    DvzScreencastFrame* frame = NULL;
+    for (uint32_t i = 0; i < DVZ_SCREENCAST_POOL_SIZE; i++)
+    {
+        frame = &screencast->frames[i];
+        if (atomic_load(&frame->in_use))
+            continue;
+        // The frame buffers are reallocated after a resize.
+        if (frame->size < size)
+        {
+            FREE(frame->rgba);
+            frame->rgba = calloc(size, 1);
+            frame->size = size;
+        }
+        atomic_store(&frame->in_use, true);
+        return frame->rgba;
+    }
+    return NULL;
+}
+
+
+
+// Download a staging image to a frame buffer, and raise a SCREENCAST event.
+static void _screencast_download(DvzCanvas* canvas, DvzScreencast* screencast, uint32_t k)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(screencast != NULL);
+    DvzScreencastSlot* slot = &screencast->slots[k];
+    ASSERT(slot->status == DVZ_SCREENCAST_AWAIT_TRANSFER);
+
+    // NOTE: there are no staging images in YUV mode.
+    uint32_t width = canvas->swapchain.images->width;
+    uint32_t height = canvas->swapchain.images->height;
+    VkDeviceSize size = screencast->yuv ? slot->planes.size : width * height * 4;
+    uint8_t* rgb_a = _screencast_frame(screencast, size);
+    if (rgb_a == NULL)
     {
-        dvz_cmd_reset(&screencast->cmds, i);
-        dvz_cmd_begin(&screencast->cmds, i);
+        atomic_fetch_add(&screencast->dropped, 1);
+        log_warn(
+            "drop screencast frame #%d as all frame buffers are in use, they must be released "
+            "with dvz_screencast_release()",
+            slot->frame_idx);
+        return;
+    }
+
+    // Copy the image from the staging image, or the YUV420 planes, to the CPU.
+    log_trace("screencast CPU download of frame #%d", slot->frame_idx);
+    if (screencast->yuv)
+        dvz_buffer_download(&slot->planes, 0, size, rgb_a);
+    else
+        dvz_images_download(&slot->staging, 0, true, screencast->has_alpha, rgb_a);
 
-        // Transition to SRC layout
-        dvz_barrier_images_layout(
-            &barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-        dvz_barrier_images_access(
-            &barrier, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
-        dvz_cmd_barrier(&screencast->cmds, i, &barrier);
+    // Enqueue a special SCREENCAST public event with a pointer to the CPU buffer user
+    DvzEvent sev = {0};
+    sev.type = DVZ_EVENT_SCREENCAST;
+    sev.u.sc.idx = slot->frame_idx;
+    sev.u.sc.interval = slot->interval;
+    sev.u.sc.rgba = rgb_a;
+    sev.u.sc.width = width;
+    sev.u.sc.height = height;
+    sev.u.sc.yuv = screencast->yuv;
+    memcpy(sev.u.sc.linesizes, screencast->linesizes, sizeof(screencast->linesizes));
+    log_trace("send SCREENCAST event");
+    _event_produce(canvas, sev);
+}
 
-        // Copy swapchain image to screencast image
-        dvz_cmd_copy_image(&screencast->cmds, i, images, &screencast->staging);
 
-        // Transition back to previous layout
-        dvz_barrier_images_layout(
-            &barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
-        dvz_barrier_images_access(
-            &barrier, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
-        dvz_cmd_barrier(&screencast->cmds, i, &barrier);
 
-        dvz_cmd_end(&screencast->cmds, i);
+// Read back the staging images whose copy has completed, in the order of the frames. If wait is
+// true, wait for the oldest copy.
+static void _screencast_readback(DvzCanvas* canvas, DvzScreencast* screencast, bool wait)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(screencast != NULL);
+
+    uint32_t k = 0;
+    while (screencast->pending > 0)
+    {
+        k = screencast->tail;
+        if (wait)
+            dvz_fences_wait(&screencast->fences, k);
+        else if (!dvz_fences_ready(&screencast->fences, k))
+            break;
+        wait = false;
+
+        _screencast_download(canvas, screencast, k);
+        screencast->slots[k].status = DVZ_SCREENCAST_IDLE;
+        screencast->tail = (k + 1) % DVZ_SCREENCAST_DEPTH;
+        screencast->pending--;
     }
 }
 
@@ -1564,11 +1827,18 @@ static void _screencast_timer_callback(DvzCanvas* canvas, DvzEvent ev)
 
     log_trace("screencast timer frame #%d", screencast->frame_idx);
 
-    dvz_fences_wait(&screencast->fence, 0);
+    // If all staging images are being transferred, wait for the oldest one.
+    uint32_t k = screencast->head;
+    if (screencast->slots[k].status == DVZ_SCREENCAST_AWAIT_TRANSFER)
+    {
+        log_trace("screencast ring full, wait for the oldest transfer");
+        _screencast_readback(canvas, screencast, true);
+    }
+    ASSERT(screencast->slots[k].status != DVZ_SCREENCAST_AWAIT_TRANSFER);
 
     DvzSubmit* submit = &screencast->submit;
     dvz_submit_reset(submit);
-    dvz_submit_commands(submit, &screencast->cmds);
+    dvz_submit_commands(submit, &screencast->slots[k].cmds);
 
     // Wait for "image_ready" semaphore
     dvz_submit_wait_semaphores(
@@ -1592,71 +1862,64 @@ static void _screencast_post_send(DvzCanvas* canvas, DvzEvent ev)
     ASSERT(screencast != NULL);
     ASSERT(screencast->canvas != NULL);
     ASSERT(screencast->canvas->gpu != NULL);
-    if (!screencast->is_active)
-        return;
 
     uint32_t img_idx = canvas->swapchain.img_idx;
     // Always make sure the present semaphore is reset to its original value.
     canvas->present_semaphores = &canvas->sem_render_finished;
 
-    // Do nothing if the screencast image is not ready.
-    if (screencast->status <= DVZ_SCREENCAST_IDLE)
-        return;
-
-    log_trace("screencast event #%d", screencast->frame_idx);
-
     // Send the copy job
-    if (screencast->status == DVZ_SCREENCAST_AWAIT_COPY)
+    if (screencast->is_active && screencast->status == DVZ_SCREENCAST_AWAIT_COPY)
     {
-        log_trace("screencast send");
+        uint32_t k = screencast->head;
+        DvzScreencastSlot* slot = &screencast->slots[k];
+        log_trace("screencast send frame #%d to staging image %d", screencast->frame_idx, k);
+
         // The copy job waits for the current image to be ready.
         // It signals the screencast semaphore when the copy is done.
         // The present swapchain command must wait for the screencast semaphore rather than
         // the render_finished semaphore.
-        // HACK: do not wait when submitting at the first frame.
-        dvz_submit_send(&screencast->submit, img_idx, &screencast->fence, 0);
-        // canvas->frame_idx == 0 ? NULL : &screencast->fence, 0);
-
+        dvz_submit_send(&screencast->submit, img_idx, &screencast->fences, k);
         canvas->present_semaphores = &screencast->semaphore;
-        screencast->status = DVZ_SCREENCAST_AWAIT_TRANSFER;
-    }
-
-    else if (screencast->status == DVZ_SCREENCAST_AWAIT_TRANSFER)
-    {
-        // if (!dvz_fences_ready(&screencast->fence, 0))
-        // {
-        //     log_trace("screencast await transfer but fence not ready");
-        //     return;
-        // }
-        // else
-        // {
-        //     log_trace("screencast await transfer and fence ready");
-        // }
-        dvz_fences_wait(&screencast->fence, 0);
-
-        // To be freed by the SCREENCAST event callback.
-        uint8_t* rgb_a =
-            calloc(screencast->staging.width * screencast->staging.height, 4 * sizeof(uint8_t));
-
-        // Copy the image from the staging image to the CPU.
-        log_trace("screencast CPU download");
-        dvz_images_download(&screencast->staging, 0, true, screencast->has_alpha, rgb_a);
-
-        // Enqueue a special SCREENCAST public event with a pointer to the CPU buffer user
-        DvzEvent sev = {0};
-        sev.type = DVZ_EVENT_SCREENCAST;
-        sev.u.sc.idx = screencast->frame_idx;
-        sev.u.sc.interval = screencast->clock.interval;
-        sev.u.sc.rgba = rgb_a;
-        sev.u.sc.width = screencast->staging.width;
-        sev.u.sc.height = screencast->staging.height;
-        log_trace("send SCREENCAST event");
-        _event_produce(canvas, sev);
-
-        // Reset screencast status.
+
         _clock_set(&screencast->clock);
+        slot->status = DVZ_SCREENCAST_AWAIT_TRANSFER;
+        slot->frame_idx = screencast->frame_idx++;
+        slot->interval = screencast->clock.interval;
+        screencast->head = (k + 1) % DVZ_SCREENCAST_DEPTH;
+        screencast->pending++;
         screencast->status = DVZ_SCREENCAST_IDLE;
-        screencast->frame_idx++;
+    }
+
+    // Read back the previous frames whose copy has completed, without blocking. This also
+    // delivers the last frames after the screencast has been paused.
+    _screencast_readback(canvas, screencast, false);
+}
+
+
+
+// Create the host-visible staging images the swapchain images are copied to, in RGBA mode only.
+static void _screencast_staging(DvzScreencast* screencast)
+{
+    ASSERT(screencast != NULL);
+    ASSERT(screencast->canvas != NULL);
+    DvzImages* images = screencast->canvas->swapchain.images;
+
+    DvzImages* staging = NULL;
+    for (uint32_t k = 0; k < DVZ_SCREENCAST_DEPTH; k++)
+    {
+        staging = &screencast->slots[k].staging;
+        *staging = dvz_images(screencast->canvas->gpu, VK_IMAGE_TYPE_2D, 1);
+        dvz_images_format(staging, images->format);
+        dvz_images_size(staging, images->width, images->height, images->depth);
+        dvz_images_tiling(staging, VK_IMAGE_TILING_LINEAR);
+        dvz_images_usage(staging, VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+        dvz_images_layout(staging, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        dvz_images_memory(
+            staging, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        dvz_images_create(staging);
+
+        // Transition the staging image to its layout.
+        dvz_images_transition(staging);
     }
 }
 
@@ -1671,11 +1934,27 @@ static void _screencast_resize(DvzCanvas* canvas, DvzEvent ev)
     ASSERT(screencast->canvas != NULL);
     ASSERT(screencast->canvas->gpu != NULL);
 
+    // Deliver the frames being transferred before resizing the staging images.
+    while (screencast->pending > 0)
+        _screencast_readback(canvas, screencast, true);
+
     screencast->status = DVZ_SCREENCAST_NONE;
-    dvz_images_resize(
-        &screencast->staging, canvas->swapchain.images->width, canvas->swapchain.images->height,
-        canvas->swapchain.images->depth);
-    dvz_images_transition(&screencast->staging);
+    DvzImages* staging = NULL;
+    if (screencast->yuv)
+    {
+        _screencast_yuv_buffers(screencast);
+    }
+    else
+    {
+        for (uint32_t k = 0; k < DVZ_SCREENCAST_DEPTH; k++)
+        {
+            staging = &screencast->slots[k].staging;
+            dvz_images_resize(
+                staging, canvas->swapchain.images->width, canvas->swapchain.images->height,
+                canvas->swapchain.images->depth);
+            dvz_images_transition(staging);
+        }
+    }
 
     _screencast_cmds(screencast);
 }
@@ -1704,26 +1983,19 @@ void dvz_screencast(DvzCanvas* canvas, double interval, bool has_alpha)
     sc->canvas = canvas;
     sc->has_alpha = has_alpha;
 
-    sc->staging = dvz_images(canvas->gpu, VK_IMAGE_TYPE_2D, 1);
-    dvz_images_format(&sc->staging, images->format);
-    dvz_images_size(&sc->staging, images->width, images->height, images->depth);
-    dvz_images_tiling(&sc->staging, VK_IMAGE_TILING_LINEAR);
-    dvz_images_usage(&sc->staging, VK_IMAGE_USAGE_TRANSFER_DST_BIT);
-    dvz_images_layout(&sc->staging, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    dvz_images_memory(
-        &sc->staging, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    dvz_images_create(&sc->staging);
-
-    // Transition the staging image to its layout.
-    dvz_images_transition(&sc->staging);
+    // The screencast starts in RGBA mode, see dvz_screencast_yuv().
+    _screencast_staging(sc);
+    for (uint32_t k = 0; k < DVZ_SCREENCAST_DEPTH; k++)
+    {
+        // NOTE: we predefine the transfer command buffers, one per swapchain image.
+        sc->slots[k].cmds = dvz_commands(canvas->gpu, DVZ_DEFAULT_QUEUE_TRANSFER, images->count);
+        sc->slots[k].status = DVZ_SCREENCAST_IDLE;
+    }
 
-    sc->fence = dvz_fences(gpu, 1, true);
-    ASSERT(dvz_fences_ready(&sc->fence, 0));
+    sc->fences = dvz_fences(gpu, DVZ_SCREENCAST_DEPTH, true);
+    ASSERT(dvz_fences_ready(&sc->fences, 0));
     sc->semaphore = dvz_semaphores(gpu, 1);
 
-    // NOTE: we predefine the transfer command buffers, one per swapchain image.
-    sc->cmds =
-        dvz_commands(canvas->gpu, DVZ_DEFAULT_QUEUE_TRANSFER, canvas->swapchain.images->count);
     _screencast_cmds(sc);
     sc->submit = dvz_submit(canvas->gpu);
 
@@ -1752,9 +2024,24 @@ void dvz_screencast_destroy(DvzCanvas* canvas)
     if (!dvz_obj_is_created(&screencast->obj))
         return;
 
-    dvz_fences_destroy(&screencast->fence);
+    for (uint32_t k = 0; k < DVZ_SCREENCAST_DEPTH; k++)
+        dvz_fences_wait(&screencast->fences, k);
+    dvz_fences_destroy(&screencast->fences);
     dvz_semaphores_destroy(&screencast->semaphore);
-    dvz_images_destroy(&screencast->staging);
+    for (uint32_t k = 0; k < DVZ_SCREENCAST_DEPTH; k++)
+    {
+        // NOTE: this is a no-op for the staging images destroyed in YUV mode.
+        dvz_images_destroy(&screencast->slots[k].staging);
+        if (screencast->compute == NULL)
+            continue;
+        dvz_bindings_destroy(&screencast->slots[k].bindings);
+        dvz_buffer_destroy(&screencast->slots[k].source);
+        dvz_buffer_destroy(&screencast->slots[k].planes);
+    }
+    if (screencast->compute != NULL)
+        dvz_compute_destroy(screencast->compute);
+    for (uint32_t i = 0; i < DVZ_SCREENCAST_POOL_SIZE; i++)
+        FREE(screencast->frames[i].rgba);
 
     dvz_obj_destroyed(&screencast->obj);
     FREE(screencast);
@@ -1763,11 +2050,286 @@ void dvz_screencast_destroy(DvzCanvas* canvas)
 
 
 
+void dvz_screencast_yuv(DvzCanvas* canvas, bool yuv)
+{
+    ASSERT(canvas != NULL);
+    DvzScreencast* screencast = canvas->screencast;
+    if (screencast == NULL)
+    {
+        log_error("there is no screencast, dvz_screencast() must be called first");
+        return;
+    }
+    if (screencast->yuv == yuv)
+        return;
+    log_debug("%s screencast conversion to YUV420", yuv ? "enable" : "disable");
+
+    // Deliver the frames being transferred before changing the format.
+    while (screencast->pending > 0)
+        _screencast_readback(canvas, screencast, true);
+    screencast->status = DVZ_SCREENCAST_NONE;
+    screencast->yuv = yuv;
+    if (yuv && screencast->compute == NULL)
+        _screencast_yuv_compute(screencast);
+
+    // The RGBA staging images are only needed without the conversion, release their host-visible
+    // memory in YUV mode. The YUV buffers are kept as the mode is unlikely to change again.
+    if (yuv)
+    {
+        for (uint32_t k = 0; k < DVZ_SCREENCAST_DEPTH; k++)
+            dvz_images_destroy(&screencast->slots[k].staging);
+    }
+    else
+    {
+        _screencast_staging(screencast);
+    }
+
+    // The conversion runs on the render queue, which supports compute and has access to the
+    // swapchain images.
+    DvzImages* images = canvas->swapchain.images;
+    for (uint32_t k = 0; k < DVZ_SCREENCAST_DEPTH; k++)
+    {
+        dvz_cmd_free(&screencast->slots[k].cmds);
+        screencast->slots[k].cmds = dvz_commands(
+            canvas->gpu, yuv ? DVZ_DEFAULT_QUEUE_RENDER : DVZ_DEFAULT_QUEUE_TRANSFER,
+            images->count);
+    }
+    _screencast_cmds(screencast);
+}
+
+
+
+void dvz_screencast_release(DvzCanvas* canvas, uint8_t* rgba)
+{
+    ASSERT(canvas != NULL);
+    DvzScreencast* screencast = canvas->screencast;
+    if (screencast == NULL || rgba == NULL)
+        return;
+    for (uint32_t i = 0; i < DVZ_SCREENCAST_POOL_SIZE; i++)
+    {
+        if (screencast->frames[i].rgba == rgba)
+        {
+            atomic_store(&screencast->frames[i].in_use, false);
+            return;
+        }
+    }
+    log_error("the frame buffer %p does not belong to the screencast", rgba);
+}
+
+
+
+/*************************************************************************************************/
+/*  Screenshot                                                                                   */
+/*************************************************************************************************/
+
+// Record the copy of a swapchain image to a staging image, after the render pass, in the command
+// buffer of the same index.
+static void _staging_copy_cmds(
+    DvzCanvas* canvas, DvzCommands* cmds, uint32_t img_idx, DvzImages* staging)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(cmds != NULL);
+    ASSERT(staging != NULL);
+
+    DvzImages* images = canvas->swapchain.images;
+    ASSERT(img_idx < cmds->count);
+
+    DvzBarrier barrier = dvz_barrier(canvas->gpu);
+    dvz_barrier_images(&barrier, images);
+
+    dvz_cmd_reset(cmds, img_idx);
+    dvz_cmd_begin(cmds, img_idx);
+
+    // Transition to SRC layout, once the render pass has completed.
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    dvz_barrier_images_access(
+        &barrier, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    dvz_cmd_barrier(cmds, img_idx, &barrier);
+
+    dvz_cmd_copy_image(cmds, img_idx, images, staging);
+
+    // Transition back to the layout of the presentation.
+    dvz_barrier_stages(
+        &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+    dvz_barrier_images_layout(
+        &barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    dvz_barrier_images_access(&barrier, VK_ACCESS_TRANSFER_READ_BIT, 0);
+    dvz_cmd_barrier(cmds, img_idx, &barrier);
+
+    dvz_cmd_end(cmds, img_idx);
+}
+
+
+
+// Create a host-visible image with the size and format of the swapchain images.
+static void _staging_create(DvzCanvas* canvas, DvzImages* staging)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(staging != NULL);
+    DvzImages* images = canvas->swapchain.images;
+
+    *staging = dvz_images(canvas->gpu, VK_IMAGE_TYPE_2D, 1);
+    dvz_images_format(staging, images->format);
+    dvz_images_size(staging, images->width, images->height, images->depth);
+    dvz_images_tiling(staging, VK_IMAGE_TILING_LINEAR);
+    dvz_images_usage(staging, VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+    dvz_images_layout(staging, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    dvz_images_memory(
+        staging, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    dvz_images_create(staging);
+    dvz_images_transition(staging);
+}
+
+
+
+static void _screenshot_cmds(DvzCanvas* canvas, DvzScreenshot* screenshot, uint32_t img_idx)
+{
+    ASSERT(screenshot != NULL);
+    _staging_copy_cmds(canvas, &screenshot->cmds, img_idx, &screenshot->staging);
+}
+
+
+
+// Download the staging image to the CPU buffer of the screenshot.
+static uint8_t* _screenshot_download(DvzScreenshot* screenshot, bool has_alpha)
+{
+    ASSERT(screenshot != NULL);
+    DvzImages* staging = &screenshot->staging;
+    VkDeviceSize size = staging->width * staging->height * (has_alpha ? 4 : 3);
+    if (screenshot->size < size)
+    {
+        FREE(screenshot->rgb);
+        screenshot->rgb = calloc(size, 1);
+        screenshot->size = size;
+    }
+    dvz_images_download(staging, 0, true, has_alpha, screenshot->rgb);
+    return screenshot->rgb;
+}
+
+
+
+// Call the callback of the asynchronous screenshot.
+static void _screenshot_deliver(DvzCanvas* canvas, DvzScreenshot* screenshot)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(screenshot != NULL);
+    ASSERT(screenshot->status == DVZ_SCREENCAST_AWAIT_TRANSFER);
+
+    uint8_t* rgb = _screenshot_download(screenshot, screenshot->has_alpha);
+    screenshot->status = DVZ_SCREENCAST_NONE;
+    ASSERT(screenshot->callback != NULL);
+    screenshot->callback(
+        canvas, rgb, screenshot->staging.width, screenshot->staging.height,
+        screenshot->user_data);
+}
+
+
+
+static void _screenshot_presend(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    DvzScreenshot* screenshot = (DvzScreenshot*)ev.user_data;
+    ASSERT(screenshot != NULL);
+    if (screenshot->status != DVZ_SCREENCAST_AWAIT_COPY)
+        return;
+
+    // The copy is submitted with the render command buffers, so that the presentation waits for
+    // it, and the frame fence signals its completion.
+    uint32_t img_idx = canvas->swapchain.img_idx;
+    log_trace("screenshot of swapchain image %d", img_idx);
+    _screenshot_cmds(canvas, screenshot, img_idx);
+    dvz_submit_commands(ev.u.s.submit, &screenshot->cmds);
+    screenshot->frame = canvas->cur_frame;
+    screenshot->status = DVZ_SCREENCAST_AWAIT_TRANSFER;
+}
+
+
+
+static void _screenshot_frame(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    DvzScreenshot* screenshot = (DvzScreenshot*)ev.user_data;
+    ASSERT(screenshot != NULL);
+
+    // NOTE: the fence of the frame remains signaled until the frame in flight is reused, which
+    // happens after the FRAME callbacks.
+    if (screenshot->status == DVZ_SCREENCAST_AWAIT_TRANSFER &&
+        dvz_fences_ready(&canvas->fences_render_finished, screenshot->frame))
+        _screenshot_deliver(canvas, screenshot);
+}
+
+
+
+static void _screenshot_destroy(DvzCanvas* canvas, DvzEvent ev)
+{
+    ASSERT(canvas != NULL);
+    DvzScreenshot* screenshot = (DvzScreenshot*)ev.user_data;
+    ASSERT(screenshot != NULL);
+
+    // Deliver the pending screenshot, the GPU is idle at this point.
+    if (screenshot->status == DVZ_SCREENCAST_AWAIT_TRANSFER)
+        _screenshot_deliver(canvas, screenshot);
+
+    dvz_fences_destroy(&screenshot->fence);
+    dvz_images_destroy(&screenshot->staging);
+    FREE(screenshot->rgb);
+    FREE(screenshot);
+    canvas->screenshot = NULL;
+}
+
+
+
+// Create the screenshot resources, or resize them after the canvas has been resized.
+static DvzScreenshot* _screenshot(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzGpu* gpu = canvas->gpu;
+    DvzImages* images = canvas->swapchain.images;
+    DvzScreenshot* screenshot = canvas->screenshot;
+
+    if (screenshot != NULL)
+    {
+        DvzImages* staging = &screenshot->staging;
+        if (staging->width != images->width || staging->height != images->height)
+        {
+            ASSERT(screenshot->status != DVZ_SCREENCAST_AWAIT_TRANSFER);
+            dvz_images_resize(staging, images->width, images->height, images->depth);
+            dvz_images_transition(staging);
+        }
+        return screenshot;
+    }
+
+    log_debug("create the screenshot staging image");
+    canvas->screenshot = calloc(1, sizeof(DvzScreenshot));
+    screenshot = canvas->screenshot;
+
+    _staging_create(canvas, &screenshot->staging);
+
+    // NOTE: the copy is submitted with the render command buffers, on the same queue. There is
+    // one command buffer per possible swapchain image, as the swapchain may be recreated.
+    screenshot->cmds = dvz_commands(gpu, DVZ_DEFAULT_QUEUE_RENDER, DVZ_MAX_SWAPCHAIN_IMAGES);
+    screenshot->submit = dvz_submit(gpu);
+    screenshot->fence = dvz_fences(gpu, 1, true);
+
+    dvz_event_callback(
+        canvas, DVZ_EVENT_PRE_SEND, 0, DVZ_EVENT_MODE_SYNC, _screenshot_presend, screenshot);
+    dvz_event_callback(
+        canvas, DVZ_EVENT_FRAME, 0, DVZ_EVENT_MODE_SYNC, _screenshot_frame, screenshot);
+    dvz_event_callback(
+        canvas, DVZ_EVENT_DESTROY, 0, DVZ_EVENT_MODE_SYNC, _screenshot_destroy, screenshot);
+
+    return screenshot;
+}
+
+
+
 void dvz_screenshot_file(DvzCanvas* canvas, const char* png_path)
 {
     ASSERT(canvas != NULL);
 
-    log_info("saving screenshot of canvas to %s with full synchronization (slow)", png_path);
+    log_info("saving screenshot of canvas to %s", png_path);
     uint8_t* rgb = dvz_screenshot(canvas, false);
     if (rgb == NULL)
     {
@@ -1775,7 +2337,11 @@ void dvz_screenshot_file(DvzCanvas* canvas, const char* png_path)
         return;
     }
     DvzImages* images = canvas->swapchain.images;
-    dvz_write_png(png_path, images->width, images->height, rgb);
+    size_t len = strlen(png_path);
+    if (len >= 4 && strcmp(png_path + len - 4, ".ppm") == 0)
+        dvz_write_ppm(png_path, images->width, images->height, rgb);
+    else
+        dvz_write_png(png_path, images->width, images->height, rgb);
     FREE(rgb);
 }
 
@@ -1786,95 +2352,180 @@ uint8_t* dvz_screenshot(DvzCanvas* canvas, bool has_alpha)
     ASSERT(canvas != NULL);
     if (canvas->app->is_running)
     {
-        log_error("cannot do screenshot while the canvas is running for now");
+        log_error("cannot make a synchronous screenshot while the canvas is running, use "
+                  "dvz_screenshot_async() instead");
         return NULL;
     }
 
-    // TODO: more efficient screenshot saving with screencast
-    DvzGpu* gpu = canvas->gpu;
+    DvzScreenshot* screenshot = _screenshot(canvas);
+    ASSERT(screenshot != NULL);
 
-    dvz_gpu_wait(gpu);
-    DvzImages* images = canvas->swapchain.images;
-    DvzImages staging = dvz_images(canvas->gpu, VK_IMAGE_TYPE_2D, 1);
-
-    // Staging images.
-    {
-        dvz_images_format(&staging, images->format);
-        dvz_images_size(&staging, images->width, images->height, images->depth);
-        dvz_images_tiling(&staging, VK_IMAGE_TILING_LINEAR);
-        dvz_images_usage(&staging, VK_IMAGE_USAGE_TRANSFER_DST_BIT);
-        dvz_images_layout(&staging, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        dvz_images_memory(
-            &staging, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        dvz_images_create(&staging);
-        dvz_images_transition(&staging);
-    }
-
-    // Copy from the swapchain image to the staging image.
-    {
-        DvzBarrier barrier = dvz_barrier(canvas->gpu);
-        dvz_barrier_stages(
-            &barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
-        dvz_barrier_images(&barrier, images);
-        DvzCommands* cmds = &canvas->cmds_transfer;
-        dvz_cmd_reset(cmds, 0);
-        dvz_cmd_begin(cmds, 0);
-        dvz_barrier_images_layout(
-            &barrier, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-        dvz_barrier_images_access(
-            &barrier, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
-        dvz_cmd_barrier(cmds, 0, &barrier);
-        dvz_cmd_copy_image(cmds, 0, images, &staging);
-        dvz_barrier_images_layout(
-            &barrier, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
-        dvz_barrier_images_access(
-            &barrier, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
-        dvz_cmd_barrier(cmds, 0, &barrier);
-        dvz_cmd_end(cmds, 0);
-        dvz_cmd_submit_sync(cmds, 0);
-    }
+    // Copy the last rendered swapchain image to the staging image, and only wait for the copy.
+    // The barrier of the copy waits for the render commands submitted before on the same queue.
+    uint32_t img_idx = canvas->swapchain.img_idx;
+    _screenshot_cmds(canvas, screenshot, img_idx);
+    dvz_submit_reset(&screenshot->submit);
+    dvz_submit_commands(&screenshot->submit, &screenshot->cmds);
+    dvz_submit_send(&screenshot->submit, img_idx, &screenshot->fence, 0);
+    dvz_fences_wait(&screenshot->fence, 0);
 
     // Make the screenshot.
-    uint8_t* rgba = calloc(staging.width * staging.height, (has_alpha ? 4 : 3) * sizeof(uint8_t));
-    dvz_images_download(&staging, 0, true, has_alpha, rgba);
-    dvz_gpu_wait(gpu);
-    dvz_images_destroy(&staging);
+    DvzImages* staging = &screenshot->staging;
+    uint8_t* rgba =
+        calloc(staging->width * staging->height, (has_alpha ? 4 : 3) * sizeof(uint8_t));
+    dvz_images_download(staging, 0, true, has_alpha, rgba);
     // NOTE: the caller MUST free the returned pointer.
     return rgba;
 }
 
 
 
+bool dvz_screenshot_async(
+    DvzCanvas* canvas, bool has_alpha, DvzScreenshotCallback callback, void* user_data)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(callback != NULL);
+
+    DvzScreenshot* screenshot = _screenshot(canvas);
+    ASSERT(screenshot != NULL);
+    if (screenshot->status != DVZ_SCREENCAST_NONE)
+    {
+        log_warn("skip screenshot request as another screenshot is pending");
+        return false;
+    }
+
+    screenshot->has_alpha = has_alpha;
+    screenshot->callback = callback;
+    screenshot->user_data = user_data;
+    screenshot->status = DVZ_SCREENCAST_AWAIT_COPY;
+    return true;
+}
+
+
+
 /*************************************************************************************************/
 /*  Video screencast                                                                             */
 /*************************************************************************************************/
 
+// Encoder thread: encode the frames of the queue, and release them to the screencast.
+static void* _video_thread(void* user_data)
+{
+    DvzVideoEncoder* encoder = (DvzVideoEncoder*)user_data;
+    ASSERT(encoder != NULL);
+    Video* video = (Video*)encoder->video;
+    ASSERT(video != NULL);
+    log_debug("starting the video encoder thread");
+
+    DvzVideoFrame* frame = NULL;
+    DvzVideoStats* stats = &encoder->stats;
+    double latency = 0;
+    while (true)
+    {
+        frame = (DvzVideoFrame*)dvz_fifo_dequeue(&encoder->queue, true);
+        ASSERT(frame != NULL);
+        if (frame->rgba == NULL)
+            break;
+
+        // Create the video if needed.
+        if (video->ost == NULL)
+            create_video(video);
+        if (frame->yuv)
+            add_frame_yuv(video, frame->rgba, frame->linesizes);
+        else
+            add_frame(video, frame->rgba);
+        dvz_screencast_release(encoder->canvas, frame->rgba);
+        latency = _clock_get(&encoder->clock) - frame->time;
+
+        pthread_mutex_lock(&encoder->lock);
+        ASSERT(stats->queue_depth > 0);
+        stats->queue_depth--;
+        stats->frames_encoded++;
+        stats->latency_last = latency;
+        stats->latency_max = MAX(stats->latency_max, latency);
+        encoder->latency_sum += latency;
+        stats->latency_mean = encoder->latency_sum / stats->frames_encoded;
+        pthread_cond_signal(&encoder->cond);
+        pthread_mutex_unlock(&encoder->lock);
+    }
+    log_debug("stopping the video encoder thread");
+    return NULL;
+}
+
+
+
+// Wait for the pending frames to be encoded, and save the video file.
+static void _video_encoder_destroy(DvzVideoEncoder* encoder)
+{
+    ASSERT(encoder != NULL);
+
+    // The last frame stops the thread.
+    DvzVideoFrame* frame = &encoder->frames[DVZ_SCREENCAST_POOL_SIZE];
+    frame->rgba = NULL;
+    dvz_fifo_enqueue(&encoder->queue, frame);
+    dvz_thread_join(&encoder->thread);
+
+    log_debug(
+        "video encoder: %d frames encoded, %d dropped, mean latency %.1f ms",
+        (int)encoder->stats.frames_encoded, (int)encoder->stats.frames_dropped,
+        encoder->stats.latency_mean * 1000);
+    end_video((Video*)encoder->video);
+
+    dvz_fifo_destroy(&encoder->queue);
+    pthread_mutex_destroy(&encoder->lock);
+    pthread_cond_destroy(&encoder->cond);
+    FREE(encoder);
+}
+
+
+
 static void _video_callback(DvzCanvas* canvas, DvzEvent ev)
 {
     ASSERT(canvas != NULL);
     log_debug("video frame #%d", ev.u.sc.idx);
 
-    Video* video = (Video*)canvas->screencast->user_data;
-    if (video == NULL)
+    DvzVideoEncoder* encoder = (DvzVideoEncoder*)canvas->screencast->user_data;
+    if (encoder == NULL)
+    {
+        dvz_screencast_release(canvas, ev.u.sc.rgba);
         return;
-    ASSERT(video != NULL);
+    }
+    ASSERT(encoder != NULL);
 
-    // Create the video if needed.
-    if (video->ost == NULL)
+    // Backpressure when the queue is full.
+    pthread_mutex_lock(&encoder->lock);
+    if (encoder->stats.queue_depth >= DVZ_VIDEO_QUEUE_SIZE &&
+        encoder->backpressure == DVZ_VIDEO_BACKPRESSURE_DROP)
     {
-        create_video(video);
+        encoder->stats.frames_dropped++;
+        pthread_mutex_unlock(&encoder->lock);
+        log_debug("drop video frame #%d as the encoder queue is full", ev.u.sc.idx);
+        dvz_screencast_release(canvas, ev.u.sc.rgba);
+        return;
     }
-    ASSERT(video->ost != NULL);
-
-    add_frame(video, ev.u.sc.rgba);
-    FREE(ev.u.sc.rgba);
+    while (encoder->stats.queue_depth >= DVZ_VIDEO_QUEUE_SIZE)
+        pthread_cond_wait(&encoder->cond, &encoder->lock);
+    encoder->stats.queue_depth++;
+    pthread_mutex_unlock(&encoder->lock);
+
+    // NOTE: the frames being encoded are at most DVZ_VIDEO_QUEUE_SIZE, the frame structures are
+    // not reused before they have been dequeued.
+    DvzVideoFrame* frame = &encoder->frames[encoder->frame_count++ % DVZ_SCREENCAST_POOL_SIZE];
+    frame->rgba = ev.u.sc.rgba;
+    frame->yuv = ev.u.sc.yuv;
+    for (uint32_t k = 0; k < 3; k++)
+        frame->linesizes[k] = (int)ev.u.sc.linesizes[k];
+    frame->time = _clock_get(&encoder->clock);
+    dvz_fifo_enqueue(&encoder->queue, frame);
 }
 
 static void _video_destroy(DvzCanvas* canvas, DvzEvent ev)
 {
     ASSERT(canvas != NULL);
     if (canvas->screencast != NULL && canvas->screencast->user_data != NULL)
-        end_video((Video*)canvas->screencast->user_data);
+    {
+        _video_encoder_destroy((DvzVideoEncoder*)canvas->screencast->user_data);
+        canvas->screencast->user_data = NULL;
+    }
 }
 
 
@@ -1888,14 +2539,28 @@ void dvz_canvas_video(DvzCanvas* canvas, int framerate, int bitrate, const char*
     if (video == NULL)
         return;
 
+    DvzVideoEncoder* encoder = calloc(1, sizeof(DvzVideoEncoder));
+    encoder->canvas = canvas;
+    encoder->video = video;
+    encoder->backpressure = DVZ_VIDEO_BACKPRESSURE_BLOCK;
+    encoder->queue = dvz_fifo(DVZ_VIDEO_QUEUE_SIZE + 2);
+    if (pthread_mutex_init(&encoder->lock, NULL) != 0)
+        log_error("mutex creation failed");
+    if (pthread_cond_init(&encoder->cond, NULL) != 0)
+        log_error("cond creation failed");
+    _clock_init(&encoder->clock);
+    encoder->thread = dvz_thread(_video_thread, encoder);
+
     dvz_event_callback(
         canvas, DVZ_EVENT_SCREENCAST, 0, DVZ_EVENT_MODE_SYNC, _video_callback, NULL);
     dvz_event_callback(canvas, DVZ_EVENT_DESTROY, 0, DVZ_EVENT_MODE_SYNC, _video_destroy, NULL);
 
     dvz_screencast(canvas, 1. / framerate, true);
     ASSERT(canvas->screencast != NULL);
+    // The frames are converted to YUV420 on the GPU, the encoder thread only copies them.
+    dvz_screencast_yuv(canvas, true);
     canvas->screencast->is_active = record;
-    canvas->screencast->user_data = video;
+    canvas->screencast->user_data = encoder;
 }
 
 
@@ -1929,12 +2594,44 @@ void dvz_canvas_stop(DvzCanvas* canvas)
     ASSERT(canvas->screencast->user_data != NULL);
     // This call frees the pointer.
     log_info("stop screencast");
-    end_video((Video*)canvas->screencast->user_data);
+    _video_encoder_destroy((DvzVideoEncoder*)canvas->screencast->user_data);
     canvas->screencast->user_data = NULL;
 }
 
 
 
+void dvz_canvas_video_backpressure(DvzCanvas* canvas, DvzVideoBackpressure backpressure)
+{
+    ASSERT(canvas != NULL);
+    if (canvas->screencast == NULL || canvas->screencast->user_data == NULL)
+    {
+        log_error("there is no video screencast");
+        return;
+    }
+    DvzVideoEncoder* encoder = (DvzVideoEncoder*)canvas->screencast->user_data;
+    pthread_mutex_lock(&encoder->lock);
+    encoder->backpressure = backpressure;
+    pthread_mutex_unlock(&encoder->lock);
+}
+
+
+
+DvzVideoStats dvz_canvas_video_stats(DvzCanvas* canvas)
+{
+    ASSERT(canvas != NULL);
+    DvzVideoStats stats = {0};
+    if (canvas->screencast == NULL || canvas->screencast->user_data == NULL)
+        return stats;
+    DvzVideoEncoder* encoder = (DvzVideoEncoder*)canvas->screencast->user_data;
+    pthread_mutex_lock(&encoder->lock);
+    stats = encoder->stats;
+    pthread_mutex_unlock(&encoder->lock);
+    stats.frames_dropped += atomic_load(&canvas->screencast->dropped);
+    return stats;
+}
+
+
+
 /*************************************************************************************************/
 /*  Event loop                                                                                   */
 /*************************************************************************************************/
@@ -2052,6 +2749,45 @@ void dvz_canvas_frame_submit(DvzCanvas* canvas)
 
 
 
+// Free the objects destroyed during the last frame, once per frame.
+static void _app_collect(DvzApp* app)
+{
+    ASSERT(app != NULL);
+
+    DvzContainerIterator iterator = dvz_container_iterator(&app->canvases);
+    DvzCanvas* canvas = NULL;
+    while (iterator.item != NULL)
+    {
+        canvas = iterator.item;
+        dvz_container_collect(&canvas->commands);
+        dvz_container_collect(&canvas->graphics);
+        dvz_container_collect(&canvas->guis);
+        dvz_container_iter(&iterator);
+    }
+
+    iterator = dvz_container_iterator(&app->gpus);
+    DvzGpu* gpu = NULL;
+    DvzContext* context = NULL;
+    while (iterator.item != NULL)
+    {
+        gpu = iterator.item;
+        context = gpu->context;
+        if (context != NULL)
+        {
+            dvz_container_collect(&context->buffers);
+            dvz_container_collect(&context->images);
+            dvz_container_collect(&context->samplers);
+            dvz_container_collect(&context->textures);
+            dvz_container_collect(&context->computes);
+        }
+        dvz_container_iter(&iterator);
+    }
+
+    dvz_container_collect(&app->canvases);
+}
+
+
+
 void dvz_app_run(DvzApp* app, uint64_t frame_count)
 {
     if (frame_count > 1)
@@ -2206,6 +2942,9 @@ void dvz_app_run(DvzApp* app, uint64_t frame_count)
             dvz_container_iter(&iterator);
         }
 
+        // Deferred destruction: free the objects destroyed during this frame.
+        _app_collect(app);
+
         // Close the application if all canvases have been closed.
         if (n_canvas_active == 0)
         {
@@ -2221,6 +2960,253 @@ void dvz_app_run(DvzApp* app, uint64_t frame_count)
 
 
 
+/*************************************************************************************************/
+/*  Batch rendering                                                                              */
+/*************************************************************************************************/
+
+// PNG writer thread: write the figures of the queue, and return them to the pool.
+static void* _batch_thread(void* user_data)
+{
+    DvzBatch* batch = (DvzBatch*)user_data;
+    ASSERT(batch != NULL);
+
+    DvzBatchFigure* figure = NULL;
+    char path[1024] = {0};
+    while (true)
+    {
+        figure = (DvzBatchFigure*)dvz_fifo_dequeue(&batch->queue, true);
+        ASSERT(figure != NULL);
+        if (figure->idx == UINT32_MAX)
+            break;
+        if (batch->png_format != NULL)
+        {
+            snprintf(path, sizeof(path), batch->png_format, figure->idx);
+            log_trace("write figure #%d to %s", figure->idx, path);
+            dvz_write_png(path, figure->width, figure->height, figure->rgb);
+        }
+        dvz_fifo_enqueue(&batch->pool, figure);
+    }
+    return NULL;
+}
+
+
+
+// Create the staging images of an offscreen canvas, and record the copies to them.
+static void _batch_canvas(DvzBatchCanvas* bc, DvzCanvas* canvas)
+{
+    ASSERT(bc != NULL);
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->offscreen);
+    ASSERT(canvas->swapchain.images->count == 1);
+
+    bc->canvas = canvas;
+    for (uint32_t k = 0; k < DVZ_BATCH_DEPTH; k++)
+    {
+        _staging_create(canvas, &bc->staging[k]);
+        // NOTE: the canvas is not resized during the batch, the copies are recorded once.
+        bc->cmds[k] = dvz_commands(canvas->gpu, DVZ_DEFAULT_QUEUE_RENDER, 1);
+        _staging_copy_cmds(canvas, &bc->cmds[k], 0, &bc->staging[k]);
+        bc->figures[k] = -1;
+    }
+}
+
+
+
+// Read back the figure of a staging image, and pass it to the PNG writer threads.
+static void _batch_readback(DvzBatch* batch, DvzBatchCanvas* bc, uint32_t slot)
+{
+    ASSERT(batch != NULL);
+    ASSERT(bc != NULL);
+    ASSERT(slot < DVZ_BATCH_DEPTH);
+    if (bc->figures[slot] < 0)
+        return;
+
+    // Wait for a figure buffer, if the writer threads are behind.
+    DvzBatchFigure* figure = (DvzBatchFigure*)dvz_fifo_dequeue(&batch->pool, true);
+    ASSERT(figure != NULL);
+
+    DvzImages* staging = &bc->staging[slot];
+    VkDeviceSize size = staging->width * staging->height * 3;
+    if (figure->size < size)
+    {
+        FREE(figure->rgb);
+        figure->rgb = calloc(size, 1);
+        figure->size = size;
+    }
+    figure->idx = (uint32_t)bc->figures[slot];
+    figure->width = staging->width;
+    figure->height = staging->height;
+    dvz_images_download(staging, 0, true, false, figure->rgb);
+    bc->figures[slot] = -1;
+
+    dvz_fifo_enqueue(&batch->queue, figure);
+}
+
+
+
+// Render a figure on a canvas, and read back the previous figure of the canvas meanwhile.
+static void _batch_figure(DvzBatch* batch, DvzBatchCanvas* bc, uint32_t idx)
+{
+    ASSERT(batch != NULL);
+    ASSERT(bc != NULL);
+    DvzCanvas* canvas = bc->canvas;
+    ASSERT(canvas != NULL);
+
+    // Wait for the previous figure of the canvas, before the callbacks update its resources.
+    uint32_t f = canvas->cur_frame;
+    dvz_fences_wait(&canvas->fences_render_finished, f);
+
+    // INIT event at the first frame, as in the main event loop.
+    if (canvas->frame_idx == 0)
+    {
+        _event_resize(canvas);
+
+        DvzEvent ev = {0};
+        ev.type = DVZ_EVENT_INIT;
+        _event_produce(canvas, ev);
+    }
+
+    if (batch->callback != NULL)
+        batch->callback(canvas, idx, batch->user_data);
+
+    // Frame logic: FRAME and TIMER callbacks, transfers and refills.
+    dvz_canvas_frame(canvas);
+
+    // Send the render commands followed by the copy to the staging image. There is no swapchain
+    // logic with an offscreen canvas.
+    uint32_t slot = bc->head;
+    ASSERT(bc->figures[slot] < 0);
+    dvz_fences_copy(&canvas->fences_render_finished, f, &canvas->fences_flight, 0);
+    DvzSubmit* s = &canvas->submit;
+    dvz_submit_reset(s);
+    dvz_submit_commands(s, &canvas->cmds_render);
+    dvz_submit_commands(s, &bc->cmds[slot]);
+    _event_presend(canvas);
+    dvz_submit_send(s, 0, &canvas->fences_render_finished, f);
+    _event_postsend(canvas);
+
+    bc->figures[slot] = idx;
+    bc->head = (slot + 1) % DVZ_BATCH_DEPTH;
+    canvas->cur_frame = (f + 1) % canvas->fences_render_finished.count;
+    canvas->frame_idx++;
+
+    // The previous figure of the canvas has been rendered, it is read back while the GPU renders
+    // this one.
+    _batch_readback(batch, bc, (slot + DVZ_BATCH_DEPTH - 1) % DVZ_BATCH_DEPTH);
+}
+
+
+
+DvzBatchStats dvz_app_batch(
+    DvzApp* app, uint32_t figure_count, DvzBatchCallback callback, void* user_data,
+    const char* png_format, uint32_t thread_count)
+{
+    ASSERT(app != NULL);
+    DvzBatchStats stats = {0};
+    if (app->is_running)
+    {
+        log_error("cannot start a batch rendering while the app is running");
+        return stats;
+    }
+
+    DvzBatch* batch = calloc(1, sizeof(DvzBatch));
+    batch->app = app;
+    batch->callback = callback;
+    batch->user_data = user_data;
+    batch->png_format = png_format;
+
+    // Offscreen canvases of the app.
+    DvzContainerIterator iterator = dvz_container_iterator(&app->canvases);
+    DvzCanvas* canvas = NULL;
+    while (iterator.item != NULL)
+    {
+        canvas = (DvzCanvas*)iterator.item;
+        dvz_container_iter(&iterator);
+        if (canvas->obj.status < DVZ_OBJECT_STATUS_CREATED)
+            continue;
+        if (!canvas->offscreen)
+            log_warn("skip canvas with a window in the batch rendering");
+        else if (batch->canvas_count >= DVZ_BATCH_MAX_CANVAS)
+            log_warn("skip canvas beyond the maximum of %d batch canvases", DVZ_BATCH_MAX_CANVAS);
+        else
+            _batch_canvas(&batch->canvases[batch->canvas_count++], canvas);
+    }
+    if (batch->canvas_count == 0)
+    {
+        log_error("batch rendering requires at least one offscreen canvas");
+        FREE(batch);
+        return stats;
+    }
+
+    // PNG writer threads, the last figure structure stops them.
+    if (thread_count == 0)
+        thread_count = DVZ_BATCH_THREADS;
+    batch->thread_count = CLIP(thread_count, 1, DVZ_BATCH_MAX_THREADS);
+    batch->pool = dvz_fifo(DVZ_BATCH_POOL_SIZE + 1);
+    batch->queue = dvz_fifo(DVZ_BATCH_POOL_SIZE + DVZ_BATCH_MAX_THREADS + 1);
+    for (uint32_t i = 0; i < DVZ_BATCH_POOL_SIZE; i++)
+        dvz_fifo_enqueue(&batch->pool, &batch->figures[i]);
+    for (uint32_t i = 0; i < batch->thread_count; i++)
+        batch->threads[i] = dvz_thread(_batch_thread, batch);
+
+    log_debug(
+        "start batch rendering of %d figures on %d canvas(es) with %d PNG writer thread(s)",
+        figure_count, batch->canvas_count, batch->thread_count);
+    app->is_running = true;
+    DvzClock clock = {0};
+    _clock_init(&clock);
+
+    // The figures are distributed in turn to the canvases, such that a canvas prepares and reads
+    // back its figures while the GPU renders the figures of the other canvases.
+    for (uint32_t i = 0; i < figure_count; i++)
+        _batch_figure(batch, &batch->canvases[i % batch->canvas_count], i);
+
+    // Read back the last figures of each canvas, in order.
+    dvz_app_wait(app);
+    DvzBatchCanvas* bc = NULL;
+    for (uint32_t j = 0; j < batch->canvas_count; j++)
+    {
+        bc = &batch->canvases[j];
+        for (uint32_t k = 0; k < DVZ_BATCH_DEPTH; k++)
+            _batch_readback(batch, bc, (bc->head + k) % DVZ_BATCH_DEPTH);
+    }
+
+    // Wait for the PNG files to be written.
+    DvzBatchFigure* stop = &batch->figures[DVZ_BATCH_POOL_SIZE];
+    stop->idx = UINT32_MAX;
+    for (uint32_t i = 0; i < batch->thread_count; i++)
+        dvz_fifo_enqueue(&batch->queue, stop);
+    for (uint32_t i = 0; i < batch->thread_count; i++)
+        dvz_thread_join(&batch->threads[i]);
+
+    stats.figure_count = figure_count;
+    stats.canvas_count = batch->canvas_count;
+    stats.elapsed = _clock_get(&clock);
+    stats.fps = stats.elapsed > 0 ? figure_count / stats.elapsed : 0;
+    app->is_running = false;
+    log_info(
+        "batch rendering of %d figures in %.3f s, %.1f figures per second", figure_count,
+        stats.elapsed, stats.fps);
+
+    for (uint32_t j = 0; j < batch->canvas_count; j++)
+    {
+        bc = &batch->canvases[j];
+        for (uint32_t k = 0; k < DVZ_BATCH_DEPTH; k++)
+        {
+            dvz_commands_destroy(&bc->cmds[k]);
+            dvz_images_destroy(&bc->staging[k]);
+        }
+    }
+    for (uint32_t i = 0; i < DVZ_BATCH_POOL_SIZE; i++)
+        FREE(batch->figures[i].rgb);
+    dvz_fifo_destroy(&batch->pool);
+    dvz_fifo_destroy(&batch->queue);
+    FREE(batch);
+    return stats;
+}
+
+
+
 /*************************************************************************************************/
 /*  Canvas destruction                                                                           */
 /*************************************************************************************************/
@@ -4,7 +4,6 @@
 
 // Optional PNG support
 #if HAS_PNG
-#include <png.h>
 #include <zlib.h>
 #endif
 
@@ -14,78 +13,385 @@ BEGIN_INCL_NO_WARN
 #include <cglm/struct.h>
 END_INCL_NO_WARN
 
+#if OS_WIN32
+#include <direct.h>
+#define MKDIR(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define MKDIR(path) mkdir(path, 0755)
+#endif
+
 
 
 /*************************************************************************************************/
 /*  I/O                                                                                          */
 /*************************************************************************************************/
 
-int dvz_write_png(const char* filename, uint32_t width, uint32_t height, const uint8_t* image)
-{
 #if HAS_PNG
-    // from https://fossies.org/linux/libpng/example.c
-    FILE* fp;
-    png_structp png_ptr;
-    png_infop info_ptr;
 
-    fp = fopen(filename, "wb");
-    if (fp == NULL)
-        return 1;
+// Band of rows of an image, filtered and compressed by one thread.
+typedef struct
+{
+    const DvzPngOptions* options;
+    const uint8_t* image;
+    uint32_t bpp;    // bytes per pixel
+    uint32_t stride; // bytes per row of the image
+    uint32_t row0;   // first row of the band
+    uint32_t row1;   // row after the last row of the band
+    bool last;
+
+    uint8_t* filtered; // filtered rows of the whole image, each one after its filter type byte
+    uint8_t* out;      // compressed band, after 2 bytes reserved for the zlib header
+    size_t out_size;   // compressed size, excluding the 2 reserved bytes
+    uLong adler;       // checksum of the filtered rows of the band
+    int status;
+} DvzPngBand;
+
+
+
+static inline int _png_paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    return pb <= pc ? b : c;
+}
 
-    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if (png_ptr == NULL)
+
+
+// Filter a row of the image, prev is NULL for the first row. The output starts with the filter
+// type byte.
+static void _png_filter_row(
+    DvzPngFilter filter, const uint8_t* row, const uint8_t* prev, uint32_t stride, uint32_t bpp,
+    uint8_t* out)
+{
+    ASSERT(filter < DVZ_PNG_FILTER_ADAPTIVE);
+    out[0] = (uint8_t)filter;
+    uint8_t* dst = out + 1;
+    uint32_t i = 0;
+    switch (filter)
     {
-        fclose(fp);
-        return 1;
+    case DVZ_PNG_FILTER_NONE:
+        memcpy(dst, row, stride);
+        break;
+    case DVZ_PNG_FILTER_SUB:
+        memcpy(dst, row, bpp);
+        for (i = bpp; i < stride; i++)
+            dst[i] = (uint8_t)(row[i] - row[i - bpp]);
+        break;
+    case DVZ_PNG_FILTER_UP:
+        for (i = 0; i < stride; i++)
+            dst[i] = (uint8_t)(row[i] - (prev != NULL ? prev[i] : 0));
+        break;
+    case DVZ_PNG_FILTER_AVERAGE:
+        for (i = 0; i < stride; i++)
+            dst[i] = (uint8_t)(
+                row[i] - (((i >= bpp ? row[i - bpp] : 0) + (prev != NULL ? prev[i] : 0)) >> 1));
+        break;
+    case DVZ_PNG_FILTER_PAETH:
+        for (i = 0; i < stride; i++)
+            dst[i] = (uint8_t)(
+                row[i] - _png_paeth(
+                             i >= bpp ? row[i - bpp] : 0, prev != NULL ? prev[i] : 0,
+                             i >= bpp && prev != NULL ? prev[i - bpp] : 0));
+        break;
+    default:
+        break;
     }
+}
+
 
-    info_ptr = png_create_info_struct(png_ptr);
-    if (info_ptr == NULL)
+
+// Sum of the absolute values of the filtered bytes taken as signed, the heuristic of libpng to
+// choose the filter of a row.
+static uint64_t _png_filter_cost(const uint8_t* filtered, uint32_t stride)
+{
+    uint64_t cost = 0;
+    for (uint32_t i = 0; i < stride; i++)
+        cost += filtered[i] < 128 ? filtered[i] : 256 - filtered[i];
+    return cost;
+}
+
+
+
+static void* _png_band_filter(void* user_data)
+{
+    DvzPngBand* band = (DvzPngBand*)user_data;
+    ASSERT(band != NULL);
+    uint32_t stride = band->stride;
+    uint32_t bpp = band->bpp;
+    DvzPngFilter filter = band->options->filter;
+
+    uint8_t* scratch = filter == DVZ_PNG_FILTER_ADAPTIVE ? malloc(stride + 1) : NULL;
+    if (filter == DVZ_PNG_FILTER_ADAPTIVE && scratch == NULL)
     {
-        fclose(fp);
-        png_destroy_write_struct(&png_ptr, NULL);
-        return 1;
+        band->status = 1;
+        return NULL;
+    }
+    const uint8_t* row = NULL;
+    const uint8_t* prev = NULL;
+    uint8_t* out = NULL;
+    uint64_t cost = 0, best = 0;
+    for (uint32_t k = band->row0; k < band->row1; k++)
+    {
+        row = band->image + (size_t)k * stride;
+        prev = k > 0 ? row - stride : NULL;
+        out = band->filtered + (size_t)k * (stride + 1);
+        if (filter != DVZ_PNG_FILTER_ADAPTIVE)
+        {
+            _png_filter_row(filter, row, prev, stride, bpp, out);
+            continue;
+        }
+        best = UINT64_MAX;
+        for (uint32_t f = DVZ_PNG_FILTER_NONE; f < DVZ_PNG_FILTER_ADAPTIVE; f++)
+        {
+            _png_filter_row((DvzPngFilter)f, row, prev, stride, bpp, scratch);
+            cost = _png_filter_cost(scratch + 1, stride);
+            if (cost < best)
+            {
+                best = cost;
+                memcpy(out, scratch, stride + 1);
+            }
+        }
+    }
+    FREE(scratch);
+    return NULL;
+}
+
+
+
+static void* _png_band_deflate(void* user_data)
+{
+    DvzPngBand* band = (DvzPngBand*)user_data;
+    ASSERT(band != NULL);
+    const DvzPngOptions* options = band->options;
+
+    size_t row_size = band->stride + 1;
+    uint8_t* in = band->filtered + band->row0 * row_size;
+    size_t in_size = (band->row1 - band->row0) * row_size;
+
+    z_stream strm = {0};
+    int strategy = options->filter == DVZ_PNG_FILTER_NONE ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+    if (deflateInit2(&strm, options->compression, Z_DEFLATED, -15, 8, strategy) != Z_OK)
+    {
+        band->status = 1;
+        return NULL;
+    }
+
+    // Prime the compressor with the end of the previous band, so that the split barely affects
+    // the compression ratio.
+    if (band->row0 > 0)
+    {
+        size_t dict_size = MIN(band->row0 * row_size, 32768);
+        deflateSetDictionary(&strm, in - dict_size, (uInt)dict_size);
     }
 
-    if (setjmp(png_jmpbuf(png_ptr)))
+    // NOTE: the bands are raw deflate streams, the zlib header and checksum are added by the
+    // caller. The non-last bands end with a sync flush, so that they can be concatenated.
+    size_t bound = deflateBound(&strm, in_size) + 16;
+    band->out = malloc(2 + bound + 4);
+    if (band->out == NULL)
     {
-        fclose(fp);
-        png_destroy_write_struct(&png_ptr, &info_ptr);
+        band->status = 1;
+        deflateEnd(&strm);
+        return NULL;
+    }
+    strm.next_in = in;
+    strm.avail_in = (uInt)in_size;
+    strm.next_out = band->out + 2;
+    strm.avail_out = (uInt)bound;
+    int ret = deflate(&strm, band->last ? Z_FINISH : Z_SYNC_FLUSH);
+    if ((band->last && ret != Z_STREAM_END) || (!band->last && ret != Z_OK) || strm.avail_in > 0)
+        band->status = 1;
+    band->out_size = bound - strm.avail_out;
+    deflateEnd(&strm);
+
+    band->adler = adler32(adler32(0L, Z_NULL, 0), in, (uInt)in_size);
+    return NULL;
+}
+
+
+
+// Run a function on all bands, in parallel threads if there are several bands.
+static void _png_bands_run(DvzThreadCallback callback, uint32_t band_count, DvzPngBand* bands)
+{
+    DvzThread threads[DVZ_PNG_MAX_THREADS] = {0};
+    for (uint32_t k = 1; k < band_count; k++)
+        threads[k] = dvz_thread(callback, &bands[k]);
+    callback(&bands[0]);
+    for (uint32_t k = 1; k < band_count; k++)
+        dvz_thread_join(&threads[k]);
+}
+
+
+
+static inline void _png_u32(uint8_t* buf, uint32_t value)
+{
+    buf[0] = (uint8_t)(value >> 24);
+    buf[1] = (uint8_t)(value >> 16);
+    buf[2] = (uint8_t)(value >> 8);
+    buf[3] = (uint8_t)value;
+}
+
+
+
+static int _png_chunk(FILE* fp, const char* type, const uint8_t* data, uint32_t size)
+{
+    uint8_t buf[8] = {0};
+    _png_u32(buf, size);
+    memcpy(buf + 4, type, 4);
+    uLong crc = crc32(crc32(0L, Z_NULL, 0), buf + 4, 4);
+    if (size > 0)
+        crc = crc32(crc, data, size);
+
+    int res = fwrite(buf, 8, 1, fp) != 1;
+    if (size > 0)
+        res |= fwrite(data, size, 1, fp) != 1;
+    _png_u32(buf, (uint32_t)crc);
+    res |= fwrite(buf, 4, 1, fp) != 1;
+    return res;
+}
+
+#endif
+
+
+
+int dvz_write_png(const char* filename, uint32_t width, uint32_t height, const uint8_t* image)
+{
+    return dvz_write_png_options(filename, width, height, image, dvz_png_options());
+}
+
+
+
+DvzPngOptions dvz_png_options(void)
+{
+    DvzPngOptions options = {0};
+    options.compression = DVZ_PNG_COMPRESSION;
+    options.filter = DVZ_PNG_FILTER_ADAPTIVE;
+    options.thread_count = DVZ_PNG_THREADS;
+    return options;
+}
+
+
+
+int dvz_write_png_options(
+    const char* filename, uint32_t width, uint32_t height, const uint8_t* image,
+    DvzPngOptions options)
+{
+#if HAS_PNG
+    ASSERT(filename != NULL);
+    ASSERT(image != NULL);
+    ASSERT(width > 0);
+    ASSERT(height > 0);
+
+    // NOTE: the swizzling is supposed to have been done already.
+    uint32_t bpp = options.has_alpha ? 4 : 3;
+    uint32_t stride = width * bpp;
+    size_t row_size = (size_t)stride + 1;
+    options.compression = CLIP(options.compression, 0, 9);
+    if (options.filter > DVZ_PNG_FILTER_ADAPTIVE)
+        options.filter = DVZ_PNG_FILTER_ADAPTIVE;
+
+    // Split the image into bands of rows, one per thread.
+    uint32_t band_count = options.thread_count > 0 ? options.thread_count : DVZ_PNG_THREADS;
+    band_count = CLIP(band_count, 1, DVZ_PNG_MAX_THREADS);
+    band_count = CLIP(band_count, 1, MAX(1, height / DVZ_PNG_MIN_ROWS));
+
+    uint8_t* filtered = malloc(height * row_size);
+    if (filtered == NULL)
         return 1;
+    DvzPngBand bands[DVZ_PNG_MAX_THREADS] = {0};
+    DvzPngBand* band = NULL;
+    for (uint32_t k = 0; k < band_count; k++)
+    {
+        band = &bands[k];
+        band->options = &options;
+        band->image = image;
+        band->bpp = bpp;
+        band->stride = stride;
+        band->row0 = (uint32_t)((uint64_t)height * k / band_count);
+        band->row1 = (uint32_t)((uint64_t)height * (k + 1) / band_count);
+        band->last = k == band_count - 1;
+        band->filtered = filtered;
     }
 
-    png_init_io(png_ptr, fp);
-
-    // NOTE: only RGB U8 format is supported currently (swizzling is supposed to have been done
-    // already).
-    uint8_t bytes_per_pixel = 3;
-    int32_t bit_depth = 8;
-    png_set_IHDR(
-        png_ptr, info_ptr, width, height, bit_depth, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
-        PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
-    png_write_info(png_ptr, info_ptr);
-
-    if (height > PNG_SIZE_MAX / (width * bytes_per_pixel))
-        png_error(png_ptr, "Image data buffer would be too large");
-
-    png_bytep* row_pointers = calloc(height, sizeof(png_bytep));
-    if (height > PNG_UINT_32_MAX / (sizeof(png_bytep)))
-        png_error(png_ptr, "Image is too tall to process in memory");
-
-    for (uint32_t k = 0; k < height; k++)
-        row_pointers[k] = (png_bytep)((int64_t)image + k * width * bytes_per_pixel);
-    png_write_image(png_ptr, row_pointers);
-    png_write_end(png_ptr, info_ptr);
-    png_destroy_write_struct(&png_ptr, &info_ptr);
-    fclose(fp);
-    FREE(row_pointers);
-    return 0;
+    // The filters of a row only depend on the previous row of the image, all rows are filtered
+    // before the compression which primes each band with the end of the previous one.
+    _png_bands_run(_png_band_filter, band_count, bands);
+    _png_bands_run(_png_band_deflate, band_count, bands);
+
+    // zlib stream: header, concatenated bands, and checksum of all filtered rows.
+    int res = 0;
+    uLong adler = bands[0].adler;
+    for (uint32_t k = 0; k < band_count; k++)
+    {
+        res |= bands[k].status;
+        if (k > 0)
+            adler = adler32_combine(
+                adler, bands[k].adler, (z_off_t)((bands[k].row1 - bands[k].row0) * row_size));
+    }
+    // NOTE: the output buffer of a band may not have been allocated if its compression failed.
+    if (res != 0)
+    {
+        log_error("PNG compression of %s failed", filename);
+        goto end;
+    }
+    uint32_t level_flags = 3; // compression level field, as set by zlib
+    if (options.compression < 2)
+        level_flags = 0;
+    else if (options.compression < 6)
+        level_flags = 1;
+    else if (options.compression == 6)
+        level_flags = 2;
+    uint32_t header = (0x78 << 8) | (level_flags << 6);
+    header += 31 - header % 31;
+    bands[0].out[0] = (uint8_t)(header >> 8);
+    bands[0].out[1] = (uint8_t)header;
+    band = &bands[band_count - 1];
+    _png_u32(band->out + 2 + band->out_size, (uint32_t)adler);
+    band->out_size += 4;
+
+    // PNG file: signature, header, one data chunk per band, end.
+    FILE* fp = fopen(filename, "wb");
+    if (fp != NULL)
+    {
+        const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        res |= fwrite(signature, 8, 1, fp) != 1;
+
+        uint8_t ihdr[13] = {0};
+        _png_u32(ihdr, width);
+        _png_u32(ihdr + 4, height);
+        ihdr[8] = 8;                         // bit depth
+        ihdr[9] = options.has_alpha ? 6 : 2; // color type: RGBA or RGB
+        res |= _png_chunk(fp, "IHDR", ihdr, 13);
+
+        for (uint32_t k = 0; k < band_count; k++)
+        {
+            band = &bands[k];
+            res |= _png_chunk(
+                fp, "IDAT", k == 0 ? band->out : band->out + 2,
+                (uint32_t)(k == 0 ? band->out_size + 2 : band->out_size));
+        }
+        res |= _png_chunk(fp, "IEND", NULL, 0);
+        res |= fclose(fp) != 0;
+    }
+    else
+        res = 1;
+
+end:
+    for (uint32_t k = 0; k < band_count; k++)
+        FREE(bands[k].out);
+    FREE(filtered);
+    return res;
 #else
     log_error("datoviz was not build with PNG support, please install libpng-dev");
     return 1;
 #endif
 }
 
+
+
 int dvz_write_ppm(const char* filename, uint32_t width, uint32_t height, const uint8_t* image)
 {
     // from https://github.com/SaschaWillems/Vulkan/blob/master/examples/screenshot/screenshot.cpp
@@ -260,6 +566,78 @@ error:
 
 
 
+int dvz_write_file(const char* filename, size_t size, const void* data)
+{
+    ASSERT(filename != NULL);
+    ASSERT(data != NULL || size == 0);
+
+    // NOTE: the temporary file is unique per process, as several processes may write the same
+    // file at the same time.
+    char tmp[1024] = {0};
+    snprintf(tmp, sizeof(tmp), "%s.%d.tmp", filename, (int)getpid());
+    FILE* f = fopen(tmp, "wb");
+    if (f == NULL)
+    {
+        log_error("could not write %s", tmp);
+        return 1;
+    }
+    int res = size > 0 && fwrite(data, size, 1, f) != 1;
+    res |= fclose(f) != 0;
+#if OS_WIN32
+    // rename() fails on Windows if the destination exists.
+    if (res == 0)
+        remove(filename);
+#endif
+    if (res == 0)
+        res = rename(tmp, filename) != 0;
+    if (res != 0)
+    {
+        log_error("could not write %s", filename);
+        remove(tmp);
+    }
+    return res;
+}
+
+
+
+int dvz_cache_dir(char* path, size_t size)
+{
+    ASSERT(path != NULL);
+    ASSERT(size > 0);
+
+    const char* dir = getenv("DVZ_CACHE_DIR");
+    if (dir != NULL && dir[0] != 0)
+    {
+        snprintf(path, size, "%s", dir);
+        MKDIR(path);
+        return 0;
+    }
+
+#if OS_WIN32
+    dir = getenv("LOCALAPPDATA");
+    if (dir == NULL)
+        return 1;
+    snprintf(path, size, "%s/datoviz", dir);
+#else
+    dir = getenv("XDG_CACHE_HOME");
+    if (dir != NULL && dir[0] != 0)
+        snprintf(path, size, "%s/datoviz", dir);
+    else if ((dir = getenv("HOME")) != NULL)
+    {
+        // The user cache directory may not exist yet.
+        snprintf(path, size, "%s/.cache", dir);
+        MKDIR(path);
+        snprintf(path, size, "%s/.cache/datoviz", dir);
+    }
+    else
+        return 1;
+#endif
+    MKDIR(path);
+    return 0;
+}
+
+
+
 /*************************************************************************************************/
 /*  Thread                                                                                       */
 /*************************************************************************************************/
@@ -89,7 +89,10 @@ static void _context_default_buffers(DvzContext* context)
         ASSERT(buffer != NULL);
         dvz_buffer_type(buffer, DVZ_BUFFER_TYPE_STORAGE);
         dvz_buffer_size(buffer, DVZ_BUFFER_TYPE_STORAGE_SIZE);
-        dvz_buffer_usage(buffer, transferable | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        // The storage buffer also holds the indirect draw arguments of the visuals.
+        dvz_buffer_usage(
+            buffer, transferable | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
         dvz_buffer_memory(buffer, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
         dvz_buffer_create(buffer);
         ASSERT(dvz_obj_is_created(&buffer->obj));
@@ -221,6 +224,17 @@ void dvz_context_reset(DvzContext* context)
 
 
 
+void dvz_context_font(DvzContext* context, const char* font_path)
+{
+    ASSERT(context != NULL);
+    ASSERT(font_path != NULL);
+    log_debug("replace the context font atlas with a SDF atlas from %s", font_path);
+    dvz_font_atlas_destroy(&context->font_atlas);
+    context->font_atlas = dvz_font_atlas_sdf(context, font_path);
+}
+
+
+
 void dvz_context_destroy(DvzContext* context)
 {
     if (context == NULL)
@@ -289,6 +303,14 @@ DvzBufferRegions dvz_ctx_buffers(
         alignment = context->gpu->device_properties.limits.minUniformBufferOffsetAlignment;
         ASSERT(offset % alignment == 0); // offset should be already aligned
     }
+    // Vertex and storage buffer regions may be bound as storage buffers (vertex pulling), so
+    // their offset must be aligned too.
+    else if (buffer_type == DVZ_BUFFER_TYPE_VERTEX || buffer_type == DVZ_BUFFER_TYPE_STORAGE)
+    {
+        offset = aligned_size(
+            offset, context->gpu->device_properties.limits.minStorageBufferOffsetAlignment);
+        buffer->allocated_size = offset;
+    }
 
     DvzBufferRegions regions = dvz_buffer_regions(buffer, buffer_count, offset, size, alignment);
     VkDeviceSize alsize = regions.aligned_size;
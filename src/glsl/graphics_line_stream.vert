@@ -0,0 +1,42 @@
+#version 450
+#include "common.glsl"
+
+layout (std140, binding = USER_BINDING) uniform Params {
+    uvec4 ring; // capacity, head, count
+    vec2 yrange;
+} params;
+
+struct Sample {
+    float y;
+    uint color;
+};
+
+layout (std430, binding = USER_BINDING + 1) readonly buffer Samples {
+    Sample samples[];
+};
+
+layout (location = 0) out vec4 out_color;
+
+void main() {
+    uint capacity = params.ring.x;
+    uint head = params.ring.y;
+    uint count = params.ring.z;
+
+    // The vertices are ordered from the oldest to the newest slot of the ring: the newest sample
+    // is on the right edge, the slots that have not been written yet collapse on the oldest
+    // sample.
+    uint i = uint(gl_VertexIndex);
+    uint empty = capacity - count;
+    uint age = i > empty ? i - empty : 0;
+    uint oldest = (head + capacity - count) % capacity;
+    Sample s = samples[(oldest + age) % capacity];
+
+    float x = -1.0 + 2.0 * float(i) / float(max(capacity, 2) - 1);
+    float dy = params.yrange.y - params.yrange.x;
+    float y = dy != 0 ? -1.0 + 2.0 * (s.y - params.yrange.x) / dy : s.y;
+
+    gl_Position = transform(vec3(x, y, 0));
+    out_color = unpackUnorm4x8(s.color);
+    if (count == 0)
+        out_color.a = 0;
+}
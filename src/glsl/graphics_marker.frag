@@ -15,6 +15,9 @@ layout(location = 3) in float angle;
 
 layout(location = 0) out vec4 out_color;
 
+// NOTE: see DvzSpecializationConstant in graphics.h, -1 means the marker type of each vertex.
+layout (constant_id = 2) const int SPECIALIZATION_MARKER_TYPE = -1;
+
 
 void main() {
     CLIP
@@ -22,7 +25,10 @@ void main() {
     vec2 P = gl_PointCoord.xy - vec2(0.5, 0.5);
     mat2 rot = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
     P = rot * P;
-    float distance = select_marker(P * (size + 2 * params.edge_width + antialias), size, marker);
+    float marker_type =
+        SPECIALIZATION_MARKER_TYPE >= 0 ? float(SPECIALIZATION_MARKER_TYPE) : marker;
+    float distance = select_marker(
+        P * (size + 2 * params.edge_width + antialias), size, marker_type);
     if (params.edge_width > 0)
         out_color = outline(distance, params.edge_width, params.edge_color, color);
     else
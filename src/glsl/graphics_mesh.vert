@@ -24,11 +24,12 @@ layout (location = 5) out float out_alpha;
 void main() {
     gl_Position = transform(pos);
 
-    out_pos = ((mvp.model * vec4(pos, 1.0))).xyz;
+    vec3 pos_ndc = normalize_pos(pos);
+    out_pos = ((mvp.model * vec4(pos_ndc, 1.0))).xyz;
     out_normal = ((transpose(inverse(mvp.model)) * vec4(normal, 1.0))).xyz;
 
     out_uv = uv;
-    out_clip = dot(vec4(pos, 1.0), params.clip_coefs);
+    out_clip = dot(vec4(pos_ndc, 1.0), params.clip_coefs);
     out_alpha = alpha;
     out_color = vec3(0);
 
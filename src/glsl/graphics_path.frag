@@ -21,6 +21,10 @@ layout (location = 4) in vec2 in_bevel_distance;
 
 layout (location = 0) out vec4 out_color;
 
+// NOTE: see DvzSpecializationConstant in graphics.h, -1 means the value of the params.
+layout (constant_id = 3) const int SPECIALIZATION_CAP_TYPE = -1;
+layout (constant_id = 4) const int SPECIALIZATION_ROUND_JOIN = -1;
+
 
 // void discard_depth(vec4 color) {
 //     if (params.enableDepth > 0 && color.a < .25)
@@ -35,20 +39,23 @@ void main() {
     vec4 color = in_color;
     float linewidth = params.linewidth;
     float miter_limit = params.miter_limit;
+    int cap_type = SPECIALIZATION_CAP_TYPE >= 0 ? SPECIALIZATION_CAP_TYPE : params.cap_type;
+    int round_join =
+        SPECIALIZATION_ROUND_JOIN >= 0 ? SPECIALIZATION_ROUND_JOIN : params.round_join;
 
     if (in_caps.x < 0.0) {
-        out_color = cap(params.cap_type, in_texcoord.x, in_texcoord.y, linewidth, color);
+        out_color = cap(cap_type, in_texcoord.x, in_texcoord.y, linewidth, color);
         // discard_depth(out_color);
         return;
     }
     if (in_caps.y > in_length) {
-        out_color = cap(params.cap_type, in_texcoord.x-in_length, in_texcoord.y, linewidth, color);
+        out_color = cap(cap_type, in_texcoord.x-in_length, in_texcoord.y, linewidth, color);
         // discard_depth(out_color);
         return;
     }
 
     // Round join (instead of miter)
-    if (params.round_join > 0) {
+    if (round_join > 0) {
         if (in_texcoord.x < 0.0)          { distance = length(in_texcoord); }
         else if(in_texcoord.x > in_length) { distance = length(in_texcoord - vec2(in_length, 0.0)); }
     }
@@ -20,6 +20,6 @@ void main()
     gl_Position = transform(pos);
     out_uvw = uvw;
 
-    out_pos =  (mvp.model * vec4(pos, 1.0)).xyz;
+    out_pos =  (mvp.model * vec4(normalize_pos(pos), 1.0)).xyz;
     out_ray = out_pos + mvp.view[3].xyz;
 }
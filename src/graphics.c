@@ -41,9 +41,6 @@ static inline void _load_shader(
     dvz_graphics_topology(graphics, VK_PRIMITIVE_TOPOLOGY_##x);                                   \
     dvz_graphics_polygon_mode(graphics, VK_POLYGON_MODE_FILL);
 
-
-#define CREATE dvz_graphics_create(graphics);
-
 #define ATTR_BEGIN(t)                                                                             \
     dvz_graphics_vertex_binding(graphics, 0, sizeof(t));                                          \
     uint32_t attr_idx = 0;
@@ -73,9 +70,39 @@ static void _common_slots(DvzGraphics* graphics)
 /*  Basic graphics                                                                               */
 /*************************************************************************************************/
 
+static inline bool _is_double_pos(DvzGraphics* graphics)
+{
+    return (graphics->flags & DVZ_GRAPHICS_FLAGS_DOUBLE_POS) != 0;
+}
+
+
+
+// Vertex attributes of the basic graphics, with or without the emulated double positions.
+static void _basic_attrs(DvzGraphics* graphics)
+{
+    if (_is_double_pos(graphics))
+    {
+        ATTR_BEGIN(DvzVertexDouble)
+        ATTR_POS(DvzVertexDouble, pos)
+        ATTR_POS(DvzVertexDouble, pos_lo)
+        ATTR_COL(DvzVertexDouble, color)
+    }
+    else
+    {
+        ATTR_BEGIN(DvzVertex)
+        ATTR_POS(DvzVertex, pos)
+        ATTR_COL(DvzVertex, color)
+    }
+}
+
+
+
 static void _graphics_point(DvzCanvas* canvas, DvzGraphics* graphics)
 {
-    SHADER(VERTEX, "graphics_point_vert")
+    if (_is_double_pos(graphics))
+        SHADER(VERTEX, "graphics_point_double_vert")
+    else
+        SHADER(VERTEX, "graphics_point_vert")
     SHADER(FRAGMENT, "graphics_point_frag")
     PRIMITIVE(POINT_LIST)
 
@@ -83,19 +110,18 @@ static void _graphics_point(DvzCanvas* canvas, DvzGraphics* graphics)
     if ((graphics->flags & DVZ_GRAPHICS_FLAGS_DEPTH_TEST_ENABLE) != 0)
         dvz_graphics_depth_test(graphics, DVZ_DEPTH_TEST_ENABLE);
 
-    ATTR_BEGIN(DvzVertex)
-    ATTR_POS(DvzVertex, pos)
-    ATTR_COL(DvzVertex, color)
+    _basic_attrs(graphics);
 
     _common_slots(graphics);
     dvz_graphics_slot(graphics, DVZ_USER_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-
-    CREATE
 }
 
 static void _graphics_basic(DvzCanvas* canvas, DvzGraphics* graphics, VkPrimitiveTopology topology)
 {
-    SHADER(VERTEX, "graphics_basic_vert")
+    if (_is_double_pos(graphics))
+        SHADER(VERTEX, "graphics_basic_double_vert")
+    else
+        SHADER(VERTEX, "graphics_basic_vert")
     SHADER(FRAGMENT, "graphics_basic_frag")
 
     dvz_graphics_renderpass(graphics, &canvas->renderpass, 0);
@@ -106,13 +132,9 @@ static void _graphics_basic(DvzCanvas* canvas, DvzGraphics* graphics, VkPrimitiv
     if ((graphics->flags & DVZ_GRAPHICS_FLAGS_DEPTH_TEST_ENABLE) != 0)
         dvz_graphics_depth_test(graphics, DVZ_DEPTH_TEST_ENABLE);
 
-    ATTR_BEGIN(DvzVertex)
-    ATTR_POS(DvzVertex, pos)
-    ATTR_COL(DvzVertex, color)
+    _basic_attrs(graphics);
 
     _common_slots(graphics);
-
-    CREATE
 }
 
 
@@ -141,8 +163,6 @@ static void _graphics_marker(DvzCanvas* canvas, DvzGraphics* graphics)
 
     _common_slots(graphics);
     dvz_graphics_slot(graphics, DVZ_USER_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-
-    CREATE
 }
 
 
@@ -202,8 +222,6 @@ static void _graphics_segment(DvzCanvas* canvas, DvzGraphics* graphics)
 
     _common_slots(graphics);
     dvz_graphics_callback(graphics, _graphics_segment_callback);
-
-    CREATE
 }
 
 
@@ -252,8 +270,6 @@ static void _graphics_path(DvzCanvas* canvas, DvzGraphics* graphics)
     dvz_graphics_slot(graphics, DVZ_USER_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 
     dvz_graphics_callback(graphics, _graphics_path_callback);
-
-    CREATE
 }
 
 
@@ -281,14 +297,17 @@ static void _graphics_text_callback(DvzGraphicsData* data, uint32_t item_count,
 
     // const char* str = item;
     const DvzGraphicsTextItem* str_item = item;
-    uint32_t n = strlen(str_item->string);
+    const char* str = str_item->string;
+    uint32_t n = _utf8_length(str);
     DvzGraphicsTextVertex vertex = {0};
     vertex = str_item->vertex;
     ASSERT(n > 0);
     ASSERT(data->current_idx + n <= item_count);
+    uint32_t codepoint = 0;
     for (uint32_t i = 0; i < n; i++)
     {
-        size_t g = _font_atlas_glyph(atlas, str_item->string, i);
+        str += _utf8_decode(str, &codepoint);
+        uint32_t g = dvz_font_atlas_glyph(atlas, codepoint);
 
         // Glyph size.
         _font_atlas_glyph_size(atlas, str_item->font_size, vertex.glyph_size);
@@ -331,8 +350,6 @@ static void _graphics_text(DvzCanvas* canvas, DvzGraphics* graphics)
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
     dvz_graphics_callback(graphics, _graphics_text_callback);
-
-    CREATE
 }
 
 
@@ -393,8 +410,6 @@ static void _graphics_image(DvzCanvas* canvas, DvzGraphics* graphics)
         dvz_graphics_slot(
             graphics, DVZ_USER_BINDING + i, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
-    CREATE
-
     dvz_graphics_callback(graphics, _graphics_image_callback);
 }
 
@@ -421,8 +436,6 @@ static void _graphics_image_cmap(DvzCanvas* canvas, DvzGraphics* graphics)
     // Scalar image.
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
-    CREATE
-
     dvz_graphics_callback(graphics, _graphics_image_callback);
 }
 
@@ -485,8 +498,6 @@ static void _graphics_volume_slice(DvzCanvas* canvas, DvzGraphics* graphics)
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
-    CREATE
-
     dvz_graphics_callback(graphics, _graphics_volume_slice_callback);
 }
 
@@ -594,8 +605,6 @@ static void _graphics_volume(DvzCanvas* canvas, DvzGraphics* graphics)
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
     dvz_graphics_slot(graphics, DVZ_USER_BINDING + 2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
-    CREATE
-
     dvz_graphics_callback(graphics, _graphics_volume_callback);
 }
 
@@ -625,8 +634,27 @@ static void _graphics_mesh(DvzCanvas* canvas, DvzGraphics* graphics)
     for (uint32_t i = 1; i <= 4; i++)
         dvz_graphics_slot(
             graphics, DVZ_USER_BINDING + i, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+}
+
+
+
+/*************************************************************************************************/
+/*  Line stream                                                                                  */
+/*************************************************************************************************/
+
+static void _graphics_line_stream(DvzCanvas* canvas, DvzGraphics* graphics)
+{
+    SHADER(VERTEX, "graphics_line_stream_vert")
+    SHADER(FRAGMENT, "graphics_basic_frag")
+    PRIMITIVE(LINE_STRIP)
 
-    CREATE
+    // NOTE: no vertex attributes, the samples are fetched by the vertex shader from the ring
+    // buffer bound as a storage buffer, so that the x coordinate is computed from the sample
+    // index relative to the ring head.
+
+    _common_slots(graphics);
+    dvz_graphics_slot(graphics, DVZ_USER_BINDING, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+    dvz_graphics_slot(graphics, DVZ_USER_BINDING + 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
 }
 
 
@@ -718,17 +746,39 @@ void dvz_graphics_append(DvzGraphicsData* data, const void* item)
 /*  Graphics builtin                                                                             */
 /*************************************************************************************************/
 
-static DvzGraphics* _find_graphics(DvzCanvas* canvas, DvzGraphicsType type, int flags)
+static bool _specialization_eq(const DvzSpecialization* a, const DvzSpecialization* b)
+{
+    ASSERT(a != NULL);
+    ASSERT(b != NULL);
+    if (a->count != b->count)
+        return false;
+    for (uint32_t i = 0; i < a->count; i++)
+    {
+        if (a->entries[i].constantID != b->entries[i].constantID ||
+            a->entries[i].size != b->entries[i].size || a->data[i] != b->data[i])
+            return false;
+    }
+    return true;
+}
+
+
+
+static DvzGraphics* _find_graphics(
+    DvzCanvas* canvas, DvzGraphicsType type, int flags, const DvzSpecialization* specialization)
 {
     ASSERT(canvas != NULL);
     ASSERT(type != DVZ_GRAPHICS_CUSTOM);
+    DvzSpecialization generic = {0};
+    if (specialization == NULL)
+        specialization = &generic;
 
     DvzContainerIterator iter = dvz_container_iterator(&canvas->graphics);
     DvzGraphics* graphics = NULL;
-    if (iter.item != NULL)
+    while (iter.item != NULL)
     {
         graphics = iter.item;
-        if (graphics->type == type && graphics->flags == flags)
+        if (graphics->type == type && graphics->flags == flags &&
+            _specialization_eq(&graphics->specialization, specialization))
             return graphics;
         dvz_container_iter(&iter);
     }
@@ -737,27 +787,14 @@ static DvzGraphics* _find_graphics(DvzCanvas* canvas, DvzGraphicsType type, int
 
 
 
-DvzGraphics* dvz_graphics_builtin(DvzCanvas* canvas, DvzGraphicsType type, int flags)
+// Set up the shaders, vertex attributes, and slots of a builtin graphics, without creating its
+// pipeline. Return whether the graphics type is known and its pipeline can be created.
+static bool _graphics_setup(DvzCanvas* canvas, DvzGraphics* graphics)
 {
     ASSERT(canvas != NULL);
-    ASSERT(canvas->gpu != NULL);
-    ASSERT(type != DVZ_GRAPHICS_NONE);
-    ASSERT(canvas->graphics.capacity > 0);
-
-    // Try to find an existing graphics with the requested type and flags.
-    DvzGraphics* graphics = _find_graphics(canvas, type, flags);
-    if (graphics != NULL)
-        return graphics;
-
-    // If there is none, create a new one.
-    graphics = dvz_container_alloc(&canvas->graphics);
     ASSERT(graphics != NULL);
-    ASSERT(!dvz_obj_is_created(&graphics->obj));
-    *graphics = dvz_graphics(canvas->gpu);
-    graphics->type = type;
-    graphics->flags = flags;
 
-    switch (type)
+    switch (graphics->type)
     {
 
         // Basic graphics types.
@@ -830,19 +867,143 @@ DvzGraphics* dvz_graphics_builtin(DvzCanvas* canvas, DvzGraphicsType type, int f
         _graphics_mesh(canvas, graphics);
         break;
 
-    case DVZ_GRAPHICS_CUSTOM:
+
+        // Streaming line
+    case DVZ_GRAPHICS_LINE_STREAM:
+        _graphics_line_stream(canvas, graphics);
         break;
 
+    case DVZ_GRAPHICS_CUSTOM:
+        return false;
+
     default:
         log_error("no graphics type specified");
-        break;
+        return false;
     }
 
+    return true;
+}
+
+
+
+// Allocate a new builtin graphics in the canvas, to be set up with _graphics_setup().
+static DvzGraphics* _graphics_new(DvzCanvas* canvas, DvzGraphicsType type, int flags)
+{
+    ASSERT(canvas != NULL);
+
+    DvzGraphics* graphics = dvz_container_alloc(&canvas->graphics);
+    ASSERT(graphics != NULL);
+    ASSERT(!dvz_obj_is_created(&graphics->obj));
+    *graphics = dvz_graphics(canvas->gpu);
+    graphics->type = type;
+    graphics->flags = flags;
     return graphics;
 }
 
 
 
+static void* _prewarm_thread(void* user_data)
+{
+    DvzGraphicsPrewarm* prewarm = (DvzGraphicsPrewarm*)user_data;
+    ASSERT(prewarm != NULL);
+
+    // Each thread picks the next graphics to create until there are none left.
+    uint32_t idx = 0;
+    while ((idx = prewarm->next++) < prewarm->count)
+    {
+        ASSERT(prewarm->graphics[idx] != NULL);
+        dvz_graphics_create(prewarm->graphics[idx]);
+    }
+    return NULL;
+}
+
+
+
+DvzGraphics* dvz_graphics_builtin(DvzCanvas* canvas, DvzGraphicsType type, int flags)
+{
+    return dvz_graphics_variant(canvas, type, flags, NULL);
+}
+
+
+
+DvzGraphics* dvz_graphics_variant(
+    DvzCanvas* canvas, DvzGraphicsType type, int flags, const DvzSpecialization* specialization)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->gpu != NULL);
+    ASSERT(type != DVZ_GRAPHICS_NONE);
+    ASSERT(canvas->graphics.capacity > 0);
+
+    // Try to find an existing graphics with the requested type, flags, and constants.
+    DvzGraphics* graphics = _find_graphics(canvas, type, flags, specialization);
+    if (graphics != NULL)
+        return graphics;
+
+    // If there is none, create a new one.
+    graphics = _graphics_new(canvas, type, flags);
+    if (specialization != NULL)
+        graphics->specialization = *specialization;
+    if (_graphics_setup(canvas, graphics))
+        dvz_graphics_create(graphics);
+    return graphics;
+}
+
+
+
+void dvz_graphics_prewarm(
+    DvzCanvas* canvas, uint32_t count, const DvzGraphicsType* types, const int* flags,
+    uint32_t thread_count)
+{
+    ASSERT(canvas != NULL);
+    ASSERT(canvas->gpu != NULL);
+    ASSERT(canvas->graphics.capacity > 0);
+    if (count == 0)
+        return;
+    ASSERT(types != NULL);
+
+    DvzGraphicsPrewarm prewarm = {0};
+    prewarm.graphics = (DvzGraphics**)calloc(count, sizeof(DvzGraphics*));
+
+    // The graphics are allocated and set up serially, as the canvas containers are not
+    // thread-safe. The graphics that already exist, or appear twice in the list, are skipped.
+    DvzGraphics* graphics = NULL;
+    int f = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        ASSERT(types[i] != DVZ_GRAPHICS_NONE);
+        f = flags != NULL ? flags[i] : 0;
+        if (types[i] == DVZ_GRAPHICS_CUSTOM || _find_graphics(canvas, types[i], f, NULL) != NULL)
+            continue;
+        graphics = _graphics_new(canvas, types[i], f);
+        if (_graphics_setup(canvas, graphics))
+            prewarm.graphics[prewarm.count++] = graphics;
+    }
+    if (prewarm.count == 0)
+    {
+        FREE(prewarm.graphics);
+        return;
+    }
+
+    // The pipelines are then created concurrently: the pipeline cache is internally synchronized,
+    // and each creation only touches its own graphics object.
+    if (thread_count == 0)
+        thread_count = DVZ_PREWARM_THREADS;
+    thread_count = CLIP(thread_count, 1, MIN(DVZ_PREWARM_MAX_THREADS, prewarm.count));
+    log_debug("prewarm %d graphics pipeline(s) with %d thread(s)", prewarm.count, thread_count);
+
+    DvzThread threads[DVZ_PREWARM_MAX_THREADS] = {0};
+    for (uint32_t i = 1; i < thread_count; i++)
+        threads[i] = dvz_thread(_prewarm_thread, &prewarm);
+    // The calling thread takes its share of the work too.
+    _prewarm_thread(&prewarm);
+    for (uint32_t i = 1; i < thread_count; i++)
+        dvz_thread_join(&threads[i]);
+
+    FREE(prewarm.graphics);
+}
+
+
+
 void dvz_mvp_camera(DvzViewport viewport, vec3 eye, vec3 center, vec2 near_far, DvzMVP* mvp)
 {
     vec3 up = {0, 1, 0};
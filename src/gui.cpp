@@ -58,7 +58,7 @@ static void _imgui_enable(DvzCanvas* canvas)
     init_info.QueueFamily = gpu->queues.queue_families[DVZ_DEFAULT_QUEUE_RENDER];
     init_info.Queue = gpu->queues.queues[DVZ_DEFAULT_QUEUE_RENDER];
     init_info.DescriptorPool = gpu->dset_pool;
-    // init_info.PipelineCache = gpu->pipeline_cache;
+    init_info.PipelineCache = gpu->pipeline_cache;
     // init_info.Allocator = gpu->allocator;
     init_info.MinImageCount = canvas->swapchain.img_count;
     init_info.ImageCount = canvas->swapchain.img_count;
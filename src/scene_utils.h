@@ -27,6 +27,43 @@ static inline bool _is_aspect_fixed(DvzDataCoords* coords)
 
 
 
+// Whether the POS props of a visual are normalized on the GPU rather than on the CPU.
+static inline bool _is_gpu_normalized(DvzDataCoords* coords, DvzVisual* visual)
+{
+    return coords->transform == DVZ_TRANSFORM_CARTESIAN && _is_visual_to_transform(visual) &&
+           dvz_prop_get(visual, DVZ_PROP_POS, 0) != NULL;
+}
+
+
+
+// Whether the POS props of a visual are uploaded as absolute emulated doubles (hi + lo floats),
+// the data origin being subtracted on the GPU.
+static inline bool _is_gpu_double(DvzDataCoords* coords, DvzVisual* visual)
+{
+    return (visual->flags & DVZ_GRAPHICS_FLAGS_DOUBLE_POS) != 0 &&
+           _is_gpu_normalized(coords, visual);
+}
+
+
+
+// Whether the data origin is close enough to the box for the origin-relative float positions to
+// keep their precision.
+static bool _is_origin_valid(DvzDataCoords* coords)
+{
+    if (!coords->has_origin)
+        return false;
+    double center = 0;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        center = .5 * (coords->box.p0[i] + coords->box.p1[i]);
+        if (fabs(coords->origin[i] - center) > coords->box.p1[i] - coords->box.p0[i])
+            return false;
+    }
+    return true;
+}
+
+
+
 static bool _has_item_count_changed(DvzVisual* visual)
 {
     ASSERT(visual != NULL);
@@ -114,7 +151,14 @@ static DvzBox _visual_box(DvzVisual* visual)
         ASSERT(arr != NULL);
         if (arr->item_count == 0)
             continue;
-        boxes[n_pos_props++] = _box_bounding(arr);
+        // Use the running bounds of the prop, only rescanned if stale.
+        if (_prop_has_bounds(prop))
+        {
+            boxes[n_pos_props] = _prop_bounds(prop);
+            _box_enlarge(&boxes[n_pos_props++], .1);
+        }
+        else
+            boxes[n_pos_props++] = _box_bounding(arr);
     }
 
     if (n_pos_props == 0)
@@ -127,8 +171,20 @@ static DvzBox _visual_box(DvzVisual* visual)
 
 
 
-// Renormalize a POS prop.
-static void _transform_pos_prop(DvzDataCoords coords, DvzProp* prop)
+// Set the data origin at the center of a box.
+static void _set_origin(DvzDataCoords* coords, DvzBox box)
+{
+    ASSERT(coords != NULL);
+    for (uint32_t i = 0; i < 3; i++)
+        coords->origin[i] = .5 * (box.p0[i] + box.p1[i]);
+    coords->has_origin = true;
+}
+
+
+
+// Renormalize a POS prop, or just subtract the data origin if the normalization is done on the
+// GPU.
+static void _transform_pos_prop(DvzDataCoords coords, DvzProp* prop, bool gpu)
 {
     ASSERT(prop != NULL);
     ASSERT(prop->prop_type == DVZ_PROP_POS);
@@ -148,7 +204,10 @@ static void _transform_pos_prop(DvzDataCoords coords, DvzProp* prop)
     log_trace("normalizing POS prop, %d items", arr->item_count);
     // _box_print(coords.box);
     *arr_tr = dvz_array(arr->item_count, arr->dtype);
-    dvz_transform_pos(coords, arr, arr_tr, false);
+    if (gpu)
+        dvz_transform_pos_origin(coords, arr, arr_tr);
+    else
+        dvz_transform_pos(coords, arr, arr_tr, false);
 }
 
 
@@ -215,6 +274,20 @@ static void _update_visual_viewport(DvzPanel* panel, DvzVisual* visual)
 {
     visual->viewport = panel->viewport;
     log_trace("update visual viewport");
+
+    // Affine map from the origin-relative data to NDC, for the data normalization on the GPU.
+    DvzDataCoords* coords = &panel->data_coords;
+    if (coords->has_origin && _is_gpu_normalized(coords, visual))
+        dvz_transform_normalization(
+            *coords, visual->viewport.data_scale, visual->viewport.data_offset);
+    // The emulated double positions are absolute, the origin is subtracted on the GPU.
+    if (coords->has_origin && _is_gpu_double(coords, visual))
+    {
+        dvz_transform_origin_hilo(
+            *coords, visual->viewport.data_origin_hi, visual->viewport.data_origin_lo);
+        visual->viewport.data_scale[3] = 2;
+    }
+
     // Each graphics pipeline in the visual has its own transform/clip viewport options
     for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
     {
@@ -282,21 +355,15 @@ static void _scene_update_enqueue(DvzScene* scene, DvzSceneUpdate update)
 
 
 
+// NOTE: the visual, prop, and coords changes are not enqueued but coalesced in dirty flags, so
+// that they are processed at most once per frame in dependency order (coords, props, bake and
+// upload), see _process_scene_updates().
 static void _enqueue_visual_changed(DvzPanel* panel, DvzVisual* visual)
 {
     log_trace("enqueue visual changed");
     ASSERT(panel != NULL);
-    DvzScene* scene = panel->scene;
-    ASSERT(scene != NULL);
     ASSERT(visual != NULL);
-
-    DvzSceneUpdate up = {0};
-    up.type = DVZ_SCENE_UPDATE_VISUAL_CHANGED;
-    up.scene = scene;
-    up.canvas = scene->canvas;
-    up.panel = panel;
-    up.visual = visual;
-    _scene_update_enqueue(scene, up);
+    visual->dirty |= DVZ_SCENE_DIRTY_BAKE;
 }
 
 
@@ -324,20 +391,10 @@ static void _enqueue_prop_changed(DvzPanel* panel, DvzVisual* visual, DvzProp* p
 {
     log_trace("enqueue prop changed");
     ASSERT(panel != NULL);
-    DvzScene* scene = panel->scene;
-    ASSERT(scene != NULL);
     ASSERT(visual != NULL);
     ASSERT(prop != NULL);
-
-    DvzSceneUpdate up = {0};
-    up.type = DVZ_SCENE_UPDATE_PROP_CHANGED;
-    up.scene = scene;
-    up.canvas = scene->canvas;
-    up.panel = panel;
-    up.visual = visual;
-    up.prop = prop;
-    up.source = prop->source;
-    _scene_update_enqueue(scene, up);
+    prop->dirty |= DVZ_SCENE_DIRTY_PROP;
+    visual->dirty |= DVZ_SCENE_DIRTY_PROP;
 }
 
 
@@ -382,15 +439,7 @@ static void _enqueue_coords_changed(DvzPanel* panel)
 {
     log_trace("enqueue coords changed");
     ASSERT(panel != NULL);
-    DvzScene* scene = panel->scene;
-    ASSERT(scene != NULL);
-
-    DvzSceneUpdate up = {0};
-    up.type = DVZ_SCENE_UPDATE_COORDS_CHANGED;
-    up.scene = scene;
-    up.canvas = scene->canvas;
-    up.panel = panel;
-    _scene_update_enqueue(scene, up);
+    panel->dirty |= DVZ_SCENE_DIRTY_COORDS;
 }
 
 
@@ -411,7 +460,19 @@ static void _process_prop_changed(DvzSceneUpdate up)
     ASSERT(up.visual != NULL);
     if (up.prop->prop_type == DVZ_PROP_POS && _is_visual_to_transform(up.visual))
     {
-        _transform_pos_prop(coords, up.prop);
+        // The first data normalized on the GPU sets the data origin.
+        bool gpu = _is_gpu_normalized(&coords, up.visual);
+        if (gpu && !coords.has_origin)
+        {
+            _set_origin(&up.panel->data_coords, _visual_box(up.visual));
+            coords = up.panel->data_coords;
+        }
+
+        // Emulated double positions are uploaded as is.
+        if (!_is_gpu_double(&coords, up.visual))
+            _transform_pos_prop(coords, up.prop, gpu);
+        if (gpu)
+            _update_visual_viewport(up.panel, up.visual);
 
         // Recompute the visual box.
         DvzBox box = _visual_box(up.visual);
@@ -437,12 +498,24 @@ static void _process_prop_changed(DvzSceneUpdate up)
 
 
 // Called when the box coords has changed and ALL visuals in a panel must be renormalized.
+// With the cartesian transform, the normalization is done on the GPU, so that only the
+// normalization uniforms need to be updated, unless the data origin has become too far from the
+// new box, in which case the POS data is renormalized with a new origin.
 static void _process_coords_changed(DvzSceneUpdate up)
 {
     log_trace("process coords changed");
 
     DvzPanel* panel = up.panel;
     ASSERT(panel != NULL);
+    DvzDataCoords* coords = &panel->data_coords;
+
+    bool renormalize = true;
+    if (coords->transform == DVZ_TRANSFORM_CARTESIAN)
+    {
+        renormalize = !_is_origin_valid(coords);
+        if (renormalize)
+            _set_origin(coords, coords->box);
+    }
 
     // We'll iterate through all visuals.
     DvzVisual* visual = NULL;
@@ -464,6 +537,12 @@ static void _process_coords_changed(DvzSceneUpdate up)
             continue;
         }
 
+        // Update the normalization uniforms. Emulated double positions never need to be
+        // renormalized as they do not depend on the origin.
+        _update_visual_viewport(panel, visual);
+        if (!renormalize || _is_gpu_double(coords, visual))
+            continue;
+
         // Go through all visual props.
         iter = dvz_container_iterator(&visual->props);
         while (iter.item != NULL)
@@ -577,6 +656,9 @@ static void _process_visibility_changed(DvzSceneUpdate up)
 static void _process_item_count_changed(DvzSceneUpdate up)
 {
     ASSERT(up.canvas != NULL);
+    ASSERT(up.visual != NULL);
+    // Only the command buffers of that visual need to be re-recorded.
+    dvz_visual_to_refill(up.visual);
     // Refill command buffer.
     dvz_canvas_to_refill(up.canvas);
 }
@@ -647,12 +729,13 @@ static void _process_scene_update(DvzSceneUpdate up)
         _process_visual_added(up);
         break;
 
+    // Coalesced updates.
     case DVZ_SCENE_UPDATE_VISUAL_CHANGED:
-        _process_visual_changed(up);
+        _enqueue_visual_changed(up.panel, up.visual);
         break;
 
     case DVZ_SCENE_UPDATE_PROP_CHANGED:
-        _process_prop_changed(up);
+        _enqueue_prop_changed(up.panel, up.visual, up.prop);
         break;
 
     case DVZ_SCENE_UPDATE_VISIBILITY_CHANGED:
@@ -672,7 +755,7 @@ static void _process_scene_update(DvzSceneUpdate up)
         break;
 
     case DVZ_SCENE_UPDATE_COORDS_CHANGED:
-        _process_coords_changed(up);
+        _enqueue_coords_changed(up.panel);
         break;
 
         // case DVZ_SCENE_UPDATE_CANVAS_RESIZED:
@@ -716,7 +799,9 @@ static void _callback_controllers(DvzScene* scene)
 
 
 
-static void _enqueue_all_visuals_changed(DvzScene* scene)
+// Mark the visuals whose data has been changed by the user since the last frame. Return the
+// number of POS props to transform.
+static uint32_t _enqueue_all_visuals_changed(DvzScene* scene)
 {
     // log_trace("enqueue all visuals changed");
 
@@ -729,6 +814,7 @@ static void _enqueue_all_visuals_changed(DvzScene* scene)
     DvzVisual* visual = NULL;
     DvzContainerIterator iter_prop;
     DvzProp* prop = NULL;
+    uint32_t count = 0;
 
     // Go through all panels in the scene to detect the scene updates.
     while (iter.item != NULL)
@@ -755,6 +841,7 @@ static void _enqueue_all_visuals_changed(DvzScene* scene)
                     {
                         _enqueue_prop_changed(panel, visual, prop);
                         prop->obj.request = DVZ_VISUAL_REQUEST_SET;
+                        count++;
                     }
                     dvz_container_iter(&iter_prop);
                 }
@@ -764,6 +851,7 @@ static void _enqueue_all_visuals_changed(DvzScene* scene)
         }
         dvz_container_iter(&iter);
     }
+    return count;
 }
 
 
@@ -789,35 +877,157 @@ static DvzSceneUpdate _scene_update_dequeue(DvzScene* scene)
 
 
 
-// Process all pending scene updates.
-static void _process_scene_updates(DvzScene* scene)
+// Process all updates in the FIFO queue. Return the number of processed updates.
+static uint32_t _process_scene_fifo(DvzScene* scene)
 {
     ASSERT(scene != NULL);
-    DvzFifo* fifo = &scene->update_fifo;
+    uint32_t count = 0;
+    DvzSceneUpdate up = _scene_update_dequeue(scene);
+    while (up.type != DVZ_SCENE_UPDATE_NONE)
+    {
+        _process_scene_update(up);
+        up = _scene_update_dequeue(scene);
+        count++;
+    }
+    return count;
+}
+
 
-    // Find all visuals that need update, and enqueue them.
-    _enqueue_all_visuals_changed(scene);
 
-    // Iteratively process the scene updates, which can trigger more visuals changes.
+// Process the pending coords changes of all panels. Return the number of processed panels.
+static uint32_t _process_dirty_coords(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
     DvzSceneUpdate up = {0};
-    uint32_t i = 0;
-    while (dvz_fifo_size(fifo) > 0)
+    up.type = DVZ_SCENE_UPDATE_COORDS_CHANGED;
+    up.scene = scene;
+    up.canvas = scene->canvas;
+
+    uint32_t count = 0;
+    DvzContainerIterator iter = dvz_container_iterator(&scene->grid.panels);
+    while (iter.item != NULL)
     {
-        log_trace("scene update pass #%d", i);
+        up.panel = iter.item;
+        if ((up.panel->dirty & DVZ_SCENE_DIRTY_COORDS) != 0)
+        {
+            up.panel->dirty &= ~DVZ_SCENE_DIRTY_COORDS;
+            _process_coords_changed(up);
+            count++;
+        }
+        dvz_container_iter(&iter);
+    }
+    return count;
+}
 
-        // Process all pending updates.
-        up = _scene_update_dequeue(scene);
-        while (up.type != DVZ_SCENE_UPDATE_NONE)
+
+
+// Transform the pending POS props of all visuals, each at most once. Return the number of
+// processed props.
+static uint32_t _process_dirty_props(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    DvzSceneUpdate up = {0};
+    up.type = DVZ_SCENE_UPDATE_PROP_CHANGED;
+    up.scene = scene;
+    up.canvas = scene->canvas;
+
+    uint32_t count = 0;
+    DvzContainerIterator iter = dvz_container_iterator(&scene->grid.panels);
+    DvzContainerIterator iter_prop;
+    while (iter.item != NULL)
+    {
+        up.panel = iter.item;
+        for (uint32_t j = 0; j < up.panel->visual_count; j++)
+        {
+            up.visual = up.panel->visuals[j];
+            if ((up.visual->dirty & DVZ_SCENE_DIRTY_PROP) == 0)
+                continue;
+            up.visual->dirty &= ~DVZ_SCENE_DIRTY_PROP;
+
+            iter_prop = dvz_container_iterator(&up.visual->props);
+            while (iter_prop.item != NULL)
+            {
+                up.prop = iter_prop.item;
+                if ((up.prop->dirty & DVZ_SCENE_DIRTY_PROP) != 0)
+                {
+                    up.prop->dirty &= ~DVZ_SCENE_DIRTY_PROP;
+                    up.source = up.prop->source;
+                    _process_prop_changed(up);
+                    count++;
+                }
+                dvz_container_iter(&iter_prop);
+            }
+
+            // The transformed props need to be baked.
+            up.visual->dirty |= DVZ_SCENE_DIRTY_BAKE;
+        }
+        dvz_container_iter(&iter);
+    }
+    return count;
+}
+
+
+
+// Bake and upload the pending visuals, each at most once. Return the number of processed visuals.
+static uint32_t _process_dirty_visuals(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+    DvzSceneUpdate up = {0};
+    up.type = DVZ_SCENE_UPDATE_VISUAL_CHANGED;
+    up.scene = scene;
+    up.canvas = scene->canvas;
+
+    uint32_t count = 0;
+    DvzContainerIterator iter = dvz_container_iterator(&scene->grid.panels);
+    while (iter.item != NULL)
+    {
+        up.panel = iter.item;
+        for (uint32_t j = 0; j < up.panel->visual_count; j++)
         {
-            _process_scene_update(up);
-            up = _scene_update_dequeue(scene);
+            up.visual = up.panel->visuals[j];
+            if ((up.visual->dirty & DVZ_SCENE_DIRTY_BAKE) == 0)
+                continue;
+            up.visual->dirty &= ~DVZ_SCENE_DIRTY_BAKE;
+            _process_visual_changed(up);
+            count++;
         }
+        dvz_container_iter(&iter);
+    }
+    return count;
+}
+
 
-        // Find all visuals that need update, and enqueue them.
-        _enqueue_all_visuals_changed(scene);
 
+// Process all pending scene updates.
+// The visual, prop, and coords changes are coalesced within a frame and processed in dependency
+// order: first the panel coords and the POS props, until the panel boxes are stable (transformed
+// props may change the boxes), then the bake and upload of each changed visual, once.
+static void _process_scene_updates(DvzScene* scene)
+{
+    ASSERT(scene != NULL);
+
+    uint32_t i = 0;
+    uint32_t count = 1;
+    while (count > 0)
+    {
+        log_trace("scene update pass #%d", i);
+
+        // Find all visuals that need update, and the other pending updates.
+        count = _enqueue_all_visuals_changed(scene);
+        count += _process_scene_fifo(scene);
+
+        // Coords first, as they mark all POS props as changed.
+        count += _process_dirty_coords(scene);
+        count += _process_dirty_props(scene);
         i++;
     }
+
+    // Bake and upload each changed visual once.
+    _process_dirty_visuals(scene);
+
+    // Process the updates triggered by the uploads, like item count changes. The visual
+    // changes triggered here are kept for the next frame.
+    _process_scene_fifo(scene);
 }
 
 
@@ -863,6 +1073,9 @@ static void _scene_init(DvzCanvas* canvas, DvzEvent ev)
 
 // Refill the command buffer with all panels and visuals.
 // NOTE: the panel viewports must have been updated first.
+// Each visual records its draw commands in its own secondary command buffers, which are only
+// re-recorded when the visual or its viewport has changed. The primary command buffer just
+// executes them in order.
 static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
 {
     log_trace("scene fill");
@@ -874,6 +1087,7 @@ static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
 
     DvzViewport viewport = {0};
     DvzCommands* cmds = NULL;
+    DvzCommands* secondary = NULL;
     DvzPanel* panel = NULL;
     DvzContainerIterator iter;
     DvzVisual* visual = NULL;
@@ -886,7 +1100,9 @@ static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
         img_idx = ev.u.rf.img_idx;
 
         log_trace("visual fill cmd %d begin %d", i, img_idx);
-        dvz_visual_fill_begin(canvas, cmds, img_idx);
+        dvz_cmd_begin(cmds, img_idx);
+        dvz_cmd_begin_renderpass_secondary(
+            cmds, img_idx, &canvas->renderpass, &canvas->framebuffers);
 
         iter = dvz_container_iterator(&grid->panels);
         while (iter.item != NULL)
@@ -895,7 +1111,6 @@ static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
 
             // Find the panel viewport.
             viewport = dvz_panel_viewport(panel);
-            dvz_cmd_viewport(cmds, img_idx, viewport.viewport);
 
             // Go through all visuals in the panel.
             visual = NULL;
@@ -907,8 +1122,9 @@ static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
                     if (visual->priority != priority)
                         continue;
 
-                    dvz_visual_fill_event(
-                        visual, ev.u.rf.clear_color, cmds, img_idx, viewport, NULL);
+                    secondary = dvz_visual_fill_secondary(
+                        visual, ev.u.rf.clear_color, img_idx, viewport);
+                    dvz_cmd_execute(cmds, img_idx, secondary);
                 }
             }
 
@@ -919,6 +1135,7 @@ static void _scene_fill(DvzCanvas* canvas, DvzEvent ev)
 }
 
 
+
 static void _scene_resize(DvzCanvas* canvas, DvzEvent ev)
 {
     log_trace("scene resize");
@@ -940,6 +1157,12 @@ static void _scene_resize(DvzCanvas* canvas, DvzEvent ev)
         ASSERT(panel != NULL);
         up.panel = panel;
         _process_panel_changed(up);
+
+        // The framebuffers have been recreated, so the secondary command buffers of the visuals
+        // that inherit them need to be re-recorded.
+        for (uint32_t k = 0; k < panel->visual_count; k++)
+            dvz_visual_to_refill(panel->visuals[k]);
+
         dvz_container_iter(&iter);
     }
 }
@@ -1007,6 +1230,10 @@ static void _upload_mvp(DvzCanvas* canvas, DvzEvent ev)
             // is properly taken care of.
 
             dvz_upload_buffers(canvas, panel->br_mvp, 0, panel->br_mvp.size, &interact->mvp);
+
+            // Only draw the chunks of the large visuals that are in the view.
+            for (uint32_t k = 0; k < panel->visual_count; k++)
+                dvz_visual_cull(panel->visuals[k], &interact->mvp);
         }
         dvz_container_iter(&iter);
     }
@@ -8,11 +8,143 @@
 #endif
 
 
-VkShaderModule dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFlagBits stage)
-{
-    VkShaderModule module = {0};
+
+/*************************************************************************************************/
+/*  Globals                                                                                      */
+/*************************************************************************************************/
+
+#define SPIRV_MAGIC 0x07230203
+
+static DvzSpirvCache SPIRV_CACHE;
+static pthread_mutex_t SPIRV_CACHE_LOCK = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/*************************************************************************************************/
+/*  Cache utils                                                                                  */
+/*************************************************************************************************/
 
 #if HAS_GLSLANG
+
+static bool _spirv_cache_persistent(void)
+{
+    const char* env = getenv("DVZ_SHADER_CACHE");
+    return env == NULL || strcmp(env, "0") != 0;
+}
+
+
+
+// FNV-1a hash of the source code, the shader stage, and the cache version.
+static uint64_t _spirv_key(const char* code, VkShaderStageFlagBits stage)
+{
+    ASSERT(code != NULL);
+    uint64_t hash = 14695981039346656037ULL;
+    uint32_t header[2] = {DVZ_SPIRV_CACHE_VERSION, (uint32_t)stage};
+    const uint8_t* bytes = (const uint8_t*)header;
+    for (uint32_t i = 0; i < sizeof(header); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    for (const char* c = code; *c != 0; c++)
+        hash = (hash ^ (uint8_t)*c) * 1099511628211ULL;
+    return hash;
+}
+
+
+
+static int _spirv_path(uint64_t key, char* path, size_t size)
+{
+    char dir[1024] = {0};
+    if (dvz_cache_dir(dir, sizeof(dir)) != 0)
+        return 1;
+    snprintf(path, size, "%s/shader_%016llx.spv", dir, (unsigned long long)key);
+    return 0;
+}
+
+
+
+static bool _spirv_valid(const uint32_t* code, size_t size)
+{
+    return code != NULL && size >= 5 * sizeof(uint32_t) && size % sizeof(uint32_t) == 0 &&
+           code[0] == SPIRV_MAGIC;
+}
+
+
+
+// Return a copy of the cached code, to be freed by the caller. Must be called with the lock.
+static uint32_t* _spirv_cache_get(uint64_t key, size_t* size)
+{
+    ASSERT(size != NULL);
+    SPIRV_CACHE.clock++;
+    DvzSpirvCacheEntry* entry = NULL;
+    for (uint32_t i = 0; i < DVZ_SPIRV_CACHE_SIZE; i++)
+    {
+        entry = &SPIRV_CACHE.entries[i];
+        if (entry->used && entry->key == key)
+        {
+            entry->last_used = SPIRV_CACHE.clock;
+            *size = entry->size;
+            uint32_t* code = (uint32_t*)malloc(entry->size);
+            memcpy(code, entry->code, entry->size);
+            return code;
+        }
+    }
+    return NULL;
+}
+
+
+
+// Copy the code in the cache, evicting the least recently used entry if the cache is full. Must
+// be called with the lock.
+static void _spirv_cache_put(uint64_t key, size_t size, const uint32_t* code)
+{
+    ASSERT(code != NULL);
+    DvzSpirvCacheEntry* entry = NULL;
+    DvzSpirvCacheEntry* victim = NULL;
+    for (uint32_t i = 0; i < DVZ_SPIRV_CACHE_SIZE; i++)
+    {
+        entry = &SPIRV_CACHE.entries[i];
+        // Another thread may have compiled the same shader in the meantime.
+        if (entry->used && entry->key == key)
+            return;
+        if (victim == NULL || !entry->used ||
+            (victim->used && entry->last_used < victim->last_used))
+            victim = entry;
+    }
+    ASSERT(victim != NULL);
+    if (victim->used)
+        FREE(victim->code);
+    victim->used = true;
+    victim->last_used = SPIRV_CACHE.clock;
+    victim->key = key;
+    victim->size = size;
+    victim->code = (uint32_t*)malloc(size);
+    memcpy(victim->code, code, size);
+}
+
+
+
+/*************************************************************************************************/
+/*  Compilation                                                                                  */
+/*************************************************************************************************/
+
+static pthread_once_t GLSLANG_ONCE = PTHREAD_ONCE_INIT;
+
+// NOTE: glslang must be initialized once per process before compiling shaders from several
+// threads, each compilation then uses its own thread-local allocator.
+static void _glslang_init(void)
+{
+    log_trace("initialize glslang");
+    glslang_initialize_process();
+    atexit(glslang_finalize_process);
+}
+
+
+
+// Compile the GLSL code to SPIR-V, return a buffer to be freed by the caller.
+static uint32_t* _spirv_compile(const char* code, VkShaderStageFlagBits stage, size_t* size)
+{
+    ASSERT(code != NULL);
+    ASSERT(size != NULL);
+
     glslang_stage_t glslang_stage = GLSLANG_STAGE_VERTEX;
     switch (stage)
     {
@@ -54,26 +186,31 @@ VkShaderModule dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFl
         .resource = glslang_default_resource(),
     };
 
-    glslang_initialize_process();
+    pthread_once(&GLSLANG_ONCE, _glslang_init);
 
+    uint32_t* spirv = NULL;
     glslang_shader_t* shader = glslang_shader_create(&input);
+    glslang_program_t* program = NULL;
 
     if (!glslang_shader_preprocess(shader, &input))
     {
-        // use glslang_shader_get_info_log() and glslang_shader_get_info_debug_log()
+        log_error("shader preprocessing failed:\n%s", glslang_shader_get_info_log(shader));
+        goto end;
     }
 
     if (!glslang_shader_parse(shader, &input))
     {
-        // use glslang_shader_get_info_log() and glslang_shader_get_info_debug_log()
+        log_error("shader parsing failed:\n%s", glslang_shader_get_info_log(shader));
+        goto end;
     }
 
-    glslang_program_t* program = glslang_program_create();
+    program = glslang_program_create();
     glslang_program_add_shader(program, shader);
 
     if (!glslang_program_link(program, GLSLANG_MSG_SPV_RULES_BIT | GLSLANG_MSG_VULKAN_RULES_BIT))
     {
-        // use glslang_program_get_info_log() and glslang_program_get_info_debug_log();
+        log_error("shader linking failed:\n%s", glslang_program_get_info_log(program));
+        goto end;
     }
 
     glslang_program_SPIRV_generate(program, input.stage);
@@ -83,12 +220,88 @@ VkShaderModule dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFl
         log_debug("%s", glslang_program_SPIRV_get_messages(program));
     }
 
+    *size = glslang_program_SPIRV_get_size(program) * sizeof(unsigned int);
+    spirv = (uint32_t*)malloc(*size);
+    memcpy(spirv, glslang_program_SPIRV_get_ptr(program), *size);
+
+end:
+    if (program != NULL)
+        glslang_program_delete(program);
     glslang_shader_delete(shader);
+    return spirv;
+}
+
+#endif
+
+
+
+/*************************************************************************************************/
+/*  Functions                                                                                    */
+/*************************************************************************************************/
+
+VkShaderModule dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFlagBits stage)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(code != NULL);
+    VkShaderModule module = {0};
+
+#if HAS_GLSLANG
+    uint64_t key = _spirv_key(code, stage);
+    size_t size = 0;
+    uint32_t* spirv = NULL;
+
+    // Look for the shader in memory.
+    pthread_mutex_lock(&SPIRV_CACHE_LOCK);
+    spirv = _spirv_cache_get(key, &size);
+    if (spirv != NULL)
+        SPIRV_CACHE.hits++;
+    pthread_mutex_unlock(&SPIRV_CACHE_LOCK);
+
+    // Otherwise, look for the cache file, and compile the shader as a last resort. The lock is
+    // not held, so that several threads can compile different shaders at the same time.
+    char path[1024] = {0};
+    bool persistent = spirv == NULL && _spirv_cache_persistent() &&
+                      _spirv_path(key, path, sizeof(path)) == 0;
+    bool loaded = false;
+    FILE* f = NULL;
+    if (persistent && (f = fopen(path, "rb")) != NULL)
+    {
+        fclose(f);
+        spirv = dvz_read_file(path, &size);
+        loaded = _spirv_valid(spirv, size);
+        if (!loaded)
+        {
+            log_warn("ignore invalid shader cache file %s", path);
+            FREE(spirv);
+        }
+    }
+    bool compiled = false;
+    if (spirv == NULL)
+    {
+        log_trace("compile shader %016llx", (unsigned long long)key);
+        spirv = _spirv_compile(code, stage, &size);
+        if (spirv == NULL)
+            return module;
+        compiled = true;
+        if (persistent)
+            dvz_write_file(path, size, spirv);
+    }
+
+    if (loaded || compiled)
+    {
+        pthread_mutex_lock(&SPIRV_CACHE_LOCK);
+        _spirv_cache_put(key, size, spirv);
+        if (loaded)
+            SPIRV_CACHE.loads++;
+        else
+            SPIRV_CACHE.misses++;
+        pthread_mutex_unlock(&SPIRV_CACHE_LOCK);
+    }
 
     VkShaderModuleCreateInfo createInfo = {0};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = glslang_program_SPIRV_get_size(program) * sizeof(unsigned int);
-    createInfo.pCode = glslang_program_SPIRV_get_ptr(program);
+    createInfo.codeSize = size;
+    createInfo.pCode = spirv;
 
     VkResult res = vkCreateShaderModule(gpu->device, &createInfo, NULL, &module);
     if (res != VK_SUCCESS)
@@ -96,7 +309,7 @@ VkShaderModule dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFl
         log_error("unable to create shader module");
     }
 
-    glslang_program_delete(program);
+    FREE(spirv);
 
 #else
     log_error("unable to compile shader to SPIRV, Datoviz was not built with glslang support");
@@ -104,3 +317,31 @@ VkShaderModule dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFl
 
     return module;
 }
+
+
+
+void dvz_shader_cache_stats(uint64_t* hits, uint64_t* loads, uint64_t* misses)
+{
+    pthread_mutex_lock(&SPIRV_CACHE_LOCK);
+    if (hits != NULL)
+        *hits = SPIRV_CACHE.hits;
+    if (loads != NULL)
+        *loads = SPIRV_CACHE.loads;
+    if (misses != NULL)
+        *misses = SPIRV_CACHE.misses;
+    pthread_mutex_unlock(&SPIRV_CACHE_LOCK);
+}
+
+
+
+void dvz_shader_cache_clear(void)
+{
+    pthread_mutex_lock(&SPIRV_CACHE_LOCK);
+    for (uint32_t i = 0; i < DVZ_SPIRV_CACHE_SIZE; i++)
+    {
+        if (SPIRV_CACHE.entries[i].used)
+            FREE(SPIRV_CACHE.entries[i].code);
+    }
+    memset(&SPIRV_CACHE, 0, sizeof(DvzSpirvCache));
+    pthread_mutex_unlock(&SPIRV_CACHE_LOCK);
+}
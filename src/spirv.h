@@ -4,13 +4,94 @@
 #include "../include/datoviz/common.h"
 #include <vulkan/vulkan.h>
 
+
+
+/*************************************************************************************************/
+/*  Constants                                                                                    */
+/*************************************************************************************************/
+
+// Number of compiled shaders kept in memory.
+#define DVZ_SPIRV_CACHE_SIZE 64
+
+// Increment when the compilation options change, to invalidate the cache files.
+#define DVZ_SPIRV_CACHE_VERSION 1
+
+
+
+/*************************************************************************************************/
+/*  Typedefs                                                                                     */
+/*************************************************************************************************/
+
 typedef struct DvzGpu DvzGpu;
 
+typedef struct DvzSpirvCacheEntry DvzSpirvCacheEntry;
+typedef struct DvzSpirvCache DvzSpirvCache;
+
+
 
+/*************************************************************************************************/
+/*  Structs                                                                                      */
+/*************************************************************************************************/
 
+struct DvzSpirvCacheEntry
+{
+    bool used;
+    uint64_t last_used; // for least-recently-used eviction
+    uint64_t key;       // hash of the source code and the shader stage
+    size_t size;        // in bytes
+    uint32_t* code;     // owned by the cache
+};
+
+
+
+// Compiled SPIR-V code, shared by all GPUs of the process as it does not depend on the device.
+struct DvzSpirvCache
+{
+    uint64_t clock;
+    uint64_t hits;   // found in memory
+    uint64_t loads;  // loaded from the cache directory
+    uint64_t misses; // compiled
+    DvzSpirvCacheEntry entries[DVZ_SPIRV_CACHE_SIZE];
+};
+
+
+
+/*************************************************************************************************/
+/*  Functions                                                                                    */
+/*************************************************************************************************/
+
+/**
+ * Compile a GLSL shader to SPIR-V and create a shader module.
+ *
+ * The SPIR-V code is cached in memory and in the cache directory (see `dvz_cache_dir()`), keyed
+ * by a hash of the source code and the shader stage, so that a shader is only compiled once.
+ * Set the environment variable `DVZ_SHADER_CACHE=0` to disable the cache files. This function
+ * is thread-safe.
+ *
+ * @param gpu the GPU
+ * @param code the GLSL source code
+ * @param stage the shader stage
+ * @returns the shader module, or VK_NULL_HANDLE if the compilation failed
+ */
 DVZ_EXPORT VkShaderModule
 dvz_shader_compile(DvzGpu* gpu, const char* code, VkShaderStageFlagBits stage);
 
+/**
+ * Get the statistics of the compiled shader cache.
+ *
+ * @param[out] hits number of shaders found in memory
+ * @param[out] loads number of shaders loaded from the cache files
+ * @param[out] misses number of shaders compiled
+ */
+DVZ_EXPORT void dvz_shader_cache_stats(uint64_t* hits, uint64_t* loads, uint64_t* misses);
+
+/**
+ * Remove all compiled shaders from the memory cache, and reset its statistics.
+ *
+ * The cache files are kept.
+ */
+DVZ_EXPORT void dvz_shader_cache_clear(void);
+
 
 
 #endif
@@ -22,6 +22,7 @@ https://github.com/quantenschaum/ctplot/blob/master/ctplot/ticks.py
 #include <stdlib.h>
 
 #include "../include/datoviz/common.h"
+#include "../include/datoviz/ticks_types.h"
 
 
 
@@ -29,15 +30,16 @@ https://github.com/quantenschaum/ctplot/blob/master/ctplot/ticks.py
 /*  Constants and macros                                                                         */
 /*************************************************************************************************/
 
-#define INF                 1000000000
-#define J_MAX               10
-#define K_MAX               50
-#define Z_MAX               18
-#define PRECISION_MAX       9
-#define DIST_MIN            50
-#define MAX_GLYPHS_PER_TICK 24
-#define MAX_LABELS          256
-#define TARGET_DENSITY      .2
+#define INF                  1000000000
+#define J_MAX                10
+#define K_MAX                50
+#define Z_MAX                18
+#define PRECISION_MAX        9
+#define DIST_MIN             50
+#define MAX_GLYPHS_PER_TICK  DVZ_TICKS_MAX_GLYPHS
+#define MAX_LABELS           256
+#define TARGET_DENSITY       .2
+#define CACHE_QUANTUM_DIGITS 4 // the cache quantizes the range bounds to 1e-4 of the range
 
 
 
@@ -289,9 +291,59 @@ DVZ_INLINE void _tick_label(double x, char* tick_format, char* out)
 
 
 
+// Format a tick label, or copy it from the label cache if that value was already formatted with
+// the same format and precision.
+static void _tick_label_cached(
+    DvzTickLabelsCache* cache, double x, DvzTickFormat format, uint32_t precision,
+    char* tick_format, char* out)
+{
+    if (cache == NULL)
+    {
+        _tick_label(x, tick_format, out);
+        return;
+    }
+    ASSERT(precision < 256);
+
+    uint64_t h = 0;
+    memcpy(&h, &x, sizeof(double));
+    h ^= ((uint64_t)format << 8) | precision;
+    h *= 0x9E3779B97F4A7C15;
+    DvzTickLabelsEntry* set = cache->entries[(h >> 32) % DVZ_TICK_LABELS_CACHE_SETS];
+    cache->clock++;
+
+    DvzTickLabelsEntry* entry = NULL;
+    DvzTickLabelsEntry* victim = &set[0];
+    for (uint32_t i = 0; i < DVZ_TICK_LABELS_CACHE_WAYS; i++)
+    {
+        entry = &set[i];
+        if (entry->length > 0 && entry->value == x && entry->format == format &&
+            entry->precision == precision)
+        {
+            entry->last_used = cache->clock;
+            memcpy(out, entry->label, entry->length + 1);
+            cache->hits++;
+            return;
+        }
+        if (victim->length > 0 && (entry->length == 0 || entry->last_used < victim->last_used))
+            victim = entry;
+    }
+    cache->misses++;
+
+    _tick_label(x, tick_format, out);
+    victim->value = x;
+    victim->format = (uint8_t)format;
+    victim->precision = (uint8_t)precision;
+    victim->length = (uint8_t)strlen(out);
+    victim->last_used = cache->clock;
+    memcpy(victim->label, out, victim->length + 1);
+}
+
+
+
 static void make_labels(DvzAxesTicks* ticks, DvzAxesContext* ctx, bool extended)
 {
     ASSERT(ticks->labels != NULL);
+    ASSERT(ctx != NULL);
     char tick_format[12] = {0};
     _get_tick_format(ticks->format, ticks->precision, tick_format);
 
@@ -311,7 +363,9 @@ static void make_labels(DvzAxesTicks* ticks, DvzAxesContext* ctx, bool extended)
     {
         x = x0 + i * ticks->lstep;
         ticks->values[i] = x;
-        _tick_label(x, tick_format, &ticks->labels[i * MAX_GLYPHS_PER_TICK]);
+        _tick_label_cached(
+            ctx->labels, x, ticks->format, ticks->precision, tick_format,
+            &ticks->labels[i * MAX_GLYPHS_PER_TICK]);
     }
 }
 
@@ -337,7 +391,8 @@ static bool duplicate_labels(DvzAxesTicks* ticks, DvzAxesContext* ctx)
 
 
 
-static double legibility(DvzAxesTicks* ticks, DvzAxesContext* ctx)
+// Format part of the legibility, which does not require the labels.
+static double legibility_format(DvzAxesTicks* ticks)
 {
     uint32_t n = ticks->value_count;
     double lmin = ticks->lmin_in;
@@ -348,8 +403,6 @@ static double legibility(DvzAxesTicks* ticks, DvzAxesContext* ctx)
     ASSERT(lstep > 0);
 
     double f = 0;
-
-    // Format part.
     double x = 0;
     for (uint32_t i = 0; i < n; i++)
     {
@@ -357,7 +410,21 @@ static double legibility(DvzAxesTicks* ticks, DvzAxesContext* ctx)
         ASSERT(x <= lmax + .5 * lstep);
         f += leg(ticks->format, ticks->precision, x);
     }
-    f = .9 * f / MAX(1, n); // TODO: 0-extended?
+    return .9 * f / MAX(1, n); // TODO: 0-extended?
+}
+
+
+
+// Upper bound of the legibility for the current format: the overlap and duplicates parts are at
+// most 1.
+DVZ_INLINE double legibility_max(double f) { return (f + 2) / 3.0; }
+
+
+
+static double legibility(DvzAxesTicks* ticks, DvzAxesContext* ctx)
+{
+    // Format part.
+    double f = legibility_format(ticks);
 
     // Compute the labels.
     ticks->lmin_ex = ticks->lmin_in;
@@ -398,8 +465,11 @@ score(dvec4 weights, double simplicity, double coverage, double density, double
 
 
 
-// Optimize ticks->format|precision wrt to legibility.
-static void opt_format(DvzAxesTicks* ticks, DvzAxesContext* ctx)
+// Optimize ticks->format|precision wrt to legibility, and return the best legibility.
+// Only the legibility values above min_l matter to the caller: the labels of a format are not
+// formatted if the legibility upper bound of that format cannot beat min_l or the best
+// legibility so far.
+static double opt_format(DvzAxesTicks* ticks, DvzAxesContext* ctx, double min_l)
 {
     double l = -INF, best_l = -INF;
     DvzTickFormat best_format = DVZ_TICK_FORMAT_UNDEFINED;
@@ -407,6 +477,9 @@ static void opt_format(DvzAxesTicks* ticks, DvzAxesContext* ctx)
     for (uint32_t f = 1; f <= 2; f++)
     {
         ticks->format = (DvzTickFormat)f;
+        // NOTE: the format part of the legibility does not depend on the precision.
+        if (legibility_max(legibility_format(ticks)) <= MAX(min_l, best_l))
+            continue;
         for (uint32_t p = 1; p <= PRECISION_MAX; p++)
         {
             ticks->precision = p;
@@ -426,6 +499,7 @@ static void opt_format(DvzAxesTicks* ticks, DvzAxesContext* ctx)
         ticks->precision = best_precision;
         // log_debug("%d", duplicate_labels(ticks, ctx));
     }
+    return best_l;
 }
 
 
@@ -570,9 +644,11 @@ static DvzAxesTicks wilk_ext(double dmin, double dmax, int32_t m, DvzAxesContext
                         if (score(W, s, c, d, 1) <= best_score)
                             continue;
 
+                        // Minimum legibility required to beat the best score.
+                        l = (best_score - score(W, s, c, d, 0)) / W[3];
+
                         // The following optimized ticks.format|precision in-place.
-                        opt_format(&ticks, &ctx);
-                        l = legibility(&ticks, &ctx);
+                        l = opt_format(&ticks, &ctx, l);
 
                         scr = score(W, s, c, d, l);
                         if (scr > best_score)
@@ -700,4 +776,137 @@ static void dvz_ticks_destroy(DvzAxesTicks* ticks)
 
 
 
+/*************************************************************************************************/
+/*  Cache                                                                                        */
+/*************************************************************************************************/
+
+// Deep copy of computed ticks.
+static DvzAxesTicks _ticks_copy(DvzAxesTicks* ticks)
+{
+    ASSERT(ticks != NULL);
+    DvzAxesTicks out = *ticks;
+    uint32_t n = ticks->value_count;
+    out.values = NULL;
+    out.labels = NULL;
+
+    // A degenerate range may have no ticks.
+    if (n == 0)
+        return out;
+    ASSERT(ticks->values != NULL);
+    ASSERT(ticks->labels != NULL);
+    out.values = (double*)calloc(n, sizeof(double));
+    out.labels = (char*)calloc(n * MAX_GLYPHS_PER_TICK, sizeof(char));
+    memcpy(out.values, ticks->values, n * sizeof(double));
+    memcpy(out.labels, ticks->labels, n * MAX_GLYPHS_PER_TICK * sizeof(char));
+    return out;
+}
+
+
+
+// Quantize a tick computation request, return false if it cannot be quantized.
+static bool
+_ticks_cache_key(double dmin, double dmax, DvzAxesContext* ctx, DvzTicksCacheKey* key)
+{
+    ASSERT(ctx != NULL);
+    ASSERT(key != NULL);
+    ASSERT(dmin < dmax);
+
+    int32_t exponent = (int32_t)floor(log10(dmax - dmin)) - CACHE_QUANTUM_DIGITS;
+    double quantum = pow(10., exponent);
+    double qmin = round(dmin / quantum);
+    double qmax = round(dmax / quantum);
+    // The quantized bounds must fit in 64-bit integers.
+    if (!isfinite(qmin) || !isfinite(qmax) || fabs(qmin) > 1e17 || fabs(qmax) > 1e17)
+        return false;
+
+    memset(key, 0, sizeof(DvzTicksCacheKey));
+    key->exponent = exponent;
+    key->qmin = (int64_t)qmin;
+    key->qmax = (int64_t)qmax;
+    key->viewport = (uint32_t)round(ctx->size_viewport);
+    key->glyph = (uint32_t)round(16 * ctx->size_glyph);
+    key->coord = ctx->coord;
+    key->extensions = ctx->extensions;
+    return true;
+}
+
+
+
+static bool _ticks_cache_key_eq(DvzTicksCacheKey* a, DvzTicksCacheKey* b)
+{
+    ASSERT(a != NULL);
+    ASSERT(b != NULL);
+    return a->exponent == b->exponent && a->qmin == b->qmin && a->qmax == b->qmax &&
+           a->viewport == b->viewport && a->glyph == b->glyph && a->coord == b->coord &&
+           a->extensions == b->extensions;
+}
+
+
+
+/**
+ * Compute the ticks of a range, reusing a previous computation of a nearby request.
+ *
+ * Requests are quantized: the range bounds to 1e-4 of the range, the viewport size to 1 pixel,
+ * and the glyph size to 1/16 pixel. The least recently used entry is evicted when the cache is
+ * full. On a miss, the tick search reuses the labels formatted by the previous computations.
+ *
+ * @param cache the cache, may be NULL in which case the ticks are always computed
+ * @param dmin the start of the range
+ * @param dmax the end of the range
+ * @param ctx the axes context
+ * @returns the ticks, owned by the caller who must call `dvz_ticks_destroy()`
+ */
+static DvzAxesTicks
+dvz_ticks_cached(DvzTicksCache* cache, double dmin, double dmax, DvzAxesContext ctx)
+{
+    DvzTicksCacheKey key = {0};
+    if (cache == NULL || !_ticks_cache_key(dmin, dmax, &ctx, &key))
+        return dvz_ticks(dmin, dmax, ctx);
+    cache->clock++;
+
+    // Look for the request in the cache, and for the entry to evict in case of a miss.
+    DvzTicksCacheEntry* entry = NULL;
+    DvzTicksCacheEntry* victim = NULL;
+    for (uint32_t i = 0; i < DVZ_TICKS_CACHE_SIZE; i++)
+    {
+        entry = &cache->entries[i];
+        if (entry->used && _ticks_cache_key_eq(&entry->key, &key))
+        {
+            entry->last_used = cache->clock;
+            cache->hits++;
+            return _ticks_copy(&entry->ticks);
+        }
+        if (victim == NULL || !entry->used ||
+            (victim->used && entry->last_used < victim->last_used))
+            victim = entry;
+    }
+    ASSERT(victim != NULL);
+    cache->misses++;
+
+    ctx.labels = &cache->labels;
+    DvzAxesTicks ticks = dvz_ticks(dmin, dmax, ctx);
+    if (victim->used)
+        dvz_ticks_destroy(&victim->ticks);
+    victim->used = true;
+    victim->last_used = cache->clock;
+    victim->key = key;
+    victim->ticks = _ticks_copy(&ticks);
+    return ticks;
+}
+
+
+
+static void dvz_ticks_cache_destroy(DvzTicksCache* cache)
+{
+    ASSERT(cache != NULL);
+    for (uint32_t i = 0; i < DVZ_TICKS_CACHE_SIZE; i++)
+    {
+        if (cache->entries[i].used)
+            dvz_ticks_destroy(&cache->entries[i].ticks);
+    }
+    memset(cache, 0, sizeof(DvzTicksCache));
+}
+
+
+
 #endif
@@ -77,6 +77,59 @@ void dvz_transform_pos(DvzDataCoords coords, DvzArray* pos_in, DvzArray* pos_out
 
 
 
+void dvz_transform_pos_origin(DvzDataCoords coords, DvzArray* pos_in, DvzArray* pos_out)
+{
+    ASSERT(pos_in != NULL);
+    ASSERT(pos_out != NULL);
+    ASSERT(pos_out->item_count == pos_in->item_count);
+    ASSERT(pos_in->dtype == DVZ_DTYPE_DVEC3);
+    ASSERT(pos_out->dtype == DVZ_DTYPE_DVEC3);
+
+    double* in = (double*)pos_in->data;
+    double* out = (double*)pos_out->data;
+    double* origin = coords.origin;
+    uint32_t n = pos_in->item_count;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        out[3 * i + 0] = in[3 * i + 0] - origin[0];
+        out[3 * i + 1] = in[3 * i + 1] - origin[1];
+        out[3 * i + 2] = in[3 * i + 2] - origin[2];
+    }
+}
+
+
+
+void dvz_transform_normalization(DvzDataCoords coords, vec4 scale, vec4 offset)
+{
+    DvzBox box = coords.box;
+    _check_box(box);
+
+    // pos_ndc = -1 + 2 * (pos + origin - p0) / (p1 - p0)
+    double a = 0;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        ASSERT(box.p1[i] > box.p0[i]);
+        a = 2. / (box.p1[i] - box.p0[i]);
+        scale[i] = (float)a;
+        offset[i] = (float)(a * (coords.origin[i] - box.p0[i]) - 1);
+    }
+    // The last component enables the GPU normalization in the shaders.
+    scale[3] = 1;
+    offset[3] = 0;
+}
+
+
+
+void dvz_transform_origin_hilo(DvzDataCoords coords, vec4 hi, vec4 lo)
+{
+    for (uint32_t i = 0; i < 3; i++)
+        _double_split(coords.origin[i], &hi[i], &lo[i]);
+    hi[3] = 0;
+    lo[3] = 0;
+}
+
+
+
 void dvz_transform(DvzPanel* panel, DvzCDS source, dvec3 pos_in, DvzCDS target, dvec3 pos_out)
 {
     ASSERT(panel != NULL);
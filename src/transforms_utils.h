@@ -44,16 +44,23 @@ static DvzBox _box_bounding(DvzArray* points_in)
     ASSERT(points_in->item_count > 0);
     ASSERT(points_in->item_size > 0);
 
-    dvec3* pos = NULL;
     DvzBox box = DVZ_BOX_INF;
-    for (uint32_t i = 0; i < points_in->item_count; i++)
+    if (points_in->dtype == DVZ_DTYPE_DVEC3)
     {
-        pos = (dvec3*)dvz_array_item(points_in, i);
-        ASSERT(pos != NULL);
-        for (uint32_t j = 0; j < 3; j++)
+        dvz_array_bounds(points_in, 0, points_in->item_count, box.p0, box.p1);
+    }
+    else
+    {
+        dvec3* pos = NULL;
+        for (uint32_t i = 0; i < points_in->item_count; i++)
         {
-            box.p0[j] = MIN(box.p0[j], (*pos)[j]);
-            box.p1[j] = MAX(box.p1[j], (*pos)[j]);
+            pos = (dvec3*)dvz_array_item(points_in, i);
+            ASSERT(pos != NULL);
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                box.p0[j] = MIN(box.p0[j], (*pos)[j]);
+                box.p1[j] = MAX(box.p1[j], (*pos)[j]);
+            }
         }
     }
 
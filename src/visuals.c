@@ -1,4 +1,5 @@
 #include "../include/datoviz/visuals.h"
+#include "../include/datoviz/atlas.h"
 #include "../include/datoviz/canvas.h"
 #include "../include/datoviz/graphics.h"
 #include "visuals_utils.h"
@@ -55,6 +56,7 @@ void dvz_visual_destroy(DvzVisual* visual)
         dvz_container_iter(&iter);
     }
     dvz_container_destroy(&visual->props);
+    memset(&visual->prop_lookup, 0, sizeof(DvzVisualLookup));
 
     // Free the data sources.
     DvzSource* source = NULL;
@@ -67,10 +69,33 @@ void dvz_visual_destroy(DvzVisual* visual)
         dvz_container_iter(&iter);
     }
     dvz_container_destroy(&visual->sources);
+    memset(&visual->source_lookup, 0, sizeof(DvzVisualLookup));
 
     CONTAINER_DESTROY_ITEMS(DvzBindings, visual->bindings, dvz_bindings_destroy)
     CONTAINER_DESTROY_ITEMS(DvzBindings, visual->bindings_comp, dvz_bindings_destroy)
 
+    // NOTE: the text pool and the text labels are allocated as single blocks.
+    FREE(visual->text_pool)
+    FREE(visual->text_labels)
+    for (uint32_t pidx = 0; pidx < DVZ_MAX_GRAPHICS_PER_VISUAL; pidx++)
+        FREE(visual->chunks[pidx])
+
+    // Release the indirect draw regions to the context, the GPU buffers are only freed with the
+    // context.
+    DvzContext* ctx = visual->canvas != NULL ? visual->canvas->gpu->context : NULL;
+    for (uint32_t pidx = 0; pidx < DVZ_MAX_GRAPHICS_PER_VISUAL; pidx++)
+    {
+        if (visual->indirect[pidx].buffer == NULL)
+            continue;
+        if (ctx != NULL && ctx->indirect_pool_count < DVZ_MAX_INDIRECT_POOL)
+            ctx->indirect_pool[ctx->indirect_pool_count++] = visual->indirect[pidx];
+        memset(&visual->indirect[pidx], 0, sizeof(DvzBufferRegions));
+    }
+
+    // Free the secondary command buffers.
+    if (visual->cmds.count > 0)
+        dvz_cmd_free(&visual->cmds);
+
     dvz_obj_destroyed(&visual->obj);
 }
 
@@ -98,6 +123,7 @@ void dvz_visual_source(
     source->pipeline_idx = pipeline_idx;
     source->slot_idx = slot_idx;
     source->flags = flags;
+    _lookup_insert(&visual->source_lookup, source_type, source_idx, source);
 
     if (source->source_kind < DVZ_SOURCE_KIND_TEXTURE_1D)
         source->arr = dvz_array_struct(0, item_size);
@@ -145,6 +171,7 @@ DvzProp* dvz_visual_prop(
     prop->prop_type = prop_type;
     prop->prop_idx = prop_idx;
     prop->dtype = dtype;
+    _lookup_insert(&visual->prop_lookup, prop_type, prop_idx, prop);
     prop->dpi_scaling = 1;
     prop->source = dvz_source_get(visual, source_type, source_idx);
     if (prop->source == NULL && source_type != DVZ_SOURCE_TYPE_NONE)
@@ -156,6 +183,10 @@ DvzProp* dvz_visual_prop(
     if (prop->source == NULL || prop->source->source_kind < DVZ_SOURCE_KIND_TEXTURE_1D)
         prop->arr_orig = dvz_array(0, prop->dtype);
 
+    // The bounds of an empty prop are empty.
+    prop->bounds = DVZ_BOX_INF;
+    prop->bounds_valid = true;
+
     return prop;
 }
 
@@ -310,11 +341,18 @@ void dvz_visual_data_partial(
         count = 1;
     }
 
+    // Keep track of the bounds of the POS props.
+    bool has_bounds = _prop_has_bounds(prop);
+    if (has_bounds)
+        _prop_bounds_before(prop, first_item, item_count, count);
+
     // Make sure the array has the right size.
     dvz_array_resize(&prop->arr_orig, count);
 
     // Copy the specified array to the prop array.
     dvz_array_data(&prop->arr_orig, first_item, item_count, data_item_count, data);
+    if (has_bounds)
+        _prop_bounds_after(prop, first_item, item_count);
 
     prop->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
 
@@ -342,6 +380,102 @@ void dvz_visual_data_append(
 
 
 
+void dvz_visual_ring(DvzVisual* visual, uint32_t capacity)
+{
+    ASSERT(visual != NULL);
+    ASSERT(capacity > 0);
+
+    DvzSource* source = dvz_source_get(visual, DVZ_SOURCE_TYPE_VERTEX, 0);
+    ASSERT(source != NULL);
+
+    memset(&visual->ring, 0, sizeof(DvzVisualRing));
+    visual->ring.capacity = capacity;
+
+    // The props associated to the ring source keep a constant size equal to the capacity.
+    DvzProp* prop = NULL;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        if (prop->source == source)
+        {
+            // NOTE: repeated copies are not supported in streaming mode.
+            ASSERT(prop->reps <= 1);
+            dvz_array_resize(&prop->arr_orig, capacity);
+            // The items that are never streamed, for example the colors, take the default value.
+            if (prop->default_value != NULL)
+                dvz_array_data(&prop->arr_orig, 0, capacity, 1, prop->default_value);
+            prop->bounds_valid = false;
+        }
+        dvz_container_iter(&iter);
+    }
+
+    // The whole ring buffer will be baked and uploaded at the next update.
+    visual->ring.dirty_first = 0;
+    visual->ring.dirty_count = capacity;
+    source->origin = DVZ_SOURCE_ORIGIN_LIB;
+    _source_set_changed(source, true);
+}
+
+
+
+void dvz_visual_data_ring(
+    DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx, uint32_t count, const void* data)
+{
+    ASSERT(visual != NULL);
+    ASSERT(count > 0);
+    ASSERT(data != NULL);
+
+    DvzVisualRing* ring = &visual->ring;
+    if (ring->capacity == 0)
+    {
+        log_error("visual is not in streaming mode, call dvz_visual_ring() first");
+        return;
+    }
+
+    DvzProp* prop = dvz_prop_get(visual, prop_type, prop_idx);
+    ASSERT(prop != NULL);
+    DvzArray* arr = &prop->arr_orig;
+    ASSERT(arr->item_count == ring->capacity);
+    VkDeviceSize item_size = arr->item_size;
+
+    // Only keep the last items if there are more items than the capacity.
+    if (count > ring->capacity)
+    {
+        data = (const void*)((int64_t)data + (int64_t)((count - ring->capacity) * item_size));
+        count = ring->capacity;
+    }
+
+    // Copy the data at the ring head, in two chunks if the ring wraps around.
+    uint32_t n0 = MIN(count, ring->capacity - ring->head);
+    uint32_t n1 = count - n0;
+
+    // The bounds are invalidated if the evicted items lie on them.
+    bool has_bounds = _prop_has_bounds(prop) && prop->bounds_valid;
+    if (has_bounds &&
+        (_prop_bounds_touched(prop, ring->head, n0) || _prop_bounds_touched(prop, 0, n1)))
+        prop->bounds_valid = false;
+
+    dvz_array_data(arr, ring->head, n0, n0, data);
+    if (n1 > 0)
+        dvz_array_data(arr, 0, n1, n1, (const void*)((int64_t)data + (int64_t)(n0 * item_size)));
+    if (has_bounds)
+    {
+        _prop_bounds_after(prop, ring->head, n0);
+        _prop_bounds_after(prop, 0, n1);
+    }
+
+    ring->pending = MAX(ring->pending, count);
+    prop->obj.request = DVZ_VISUAL_REQUEST_UPLOAD;
+    if (prop->source != NULL)
+    {
+        prop->source->origin = DVZ_SOURCE_ORIGIN_LIB;
+        _source_set_changed(prop->source, true);
+    }
+}
+
+
+
 static DvzSource*
 _assert_source_exists(DvzVisual* visual, DvzSourceType source_type, uint32_t source_idx)
 {
@@ -504,6 +638,54 @@ void dvz_visual_fill_event(
 
 
 
+void dvz_visual_to_refill(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    memset(visual->cmds_recorded, 0, sizeof(visual->cmds_recorded));
+}
+
+
+
+DvzCommands* dvz_visual_fill_secondary(
+    DvzVisual* visual, VkClearColorValue clear_color, uint32_t img_idx, DvzViewport viewport)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    ASSERT(img_idx < DVZ_MAX_SWAPCHAIN_IMAGES);
+
+    // Allocate one secondary command buffer per swapchain image.
+    DvzCommands* cmds = &visual->cmds;
+    uint32_t img_count = canvas->cmds_render.count;
+    ASSERT(img_count > 0);
+    if (cmds->count != img_count)
+    {
+        if (cmds->count > 0)
+            dvz_cmd_free(cmds);
+        *cmds = dvz_commands_secondary(canvas->gpu, DVZ_DEFAULT_QUEUE_RENDER, img_count);
+        dvz_visual_to_refill(visual);
+    }
+    ASSERT(img_idx < cmds->count);
+
+    // Skip the recording if the command buffer is up to date.
+    if (visual->cmds_recorded[img_idx] &&
+        memcmp(&visual->cmds_viewport[img_idx], &viewport, sizeof(DvzViewport)) == 0)
+        return cmds;
+
+    log_trace("record secondary command buffer #%d of visual", img_idx);
+    dvz_cmd_reset(cmds, img_idx);
+    dvz_cmd_begin_secondary(cmds, img_idx, &canvas->renderpass, &canvas->framebuffers);
+    dvz_cmd_viewport(cmds, img_idx, viewport.viewport);
+    dvz_visual_fill_event(visual, clear_color, cmds, img_idx, viewport, NULL);
+    dvz_cmd_end(cmds, img_idx);
+
+    visual->cmds_recorded[img_idx] = true;
+    visual->cmds_viewport[img_idx] = viewport;
+    return cmds;
+}
+
+
+
 void dvz_visual_fill_begin(DvzCanvas* canvas, DvzCommands* cmds, uint32_t idx)
 {
     ASSERT(canvas != NULL);
@@ -529,6 +711,9 @@ void dvz_visual_fill_end(DvzCanvas* canvas, DvzCommands* cmds, uint32_t idx)
 DvzSource* dvz_source_get(DvzVisual* visual, DvzSourceType source_type, uint32_t source_idx)
 {
     ASSERT(visual != NULL);
+    if (!visual->source_lookup.overflow)
+        return _lookup_get(&visual->source_lookup, source_type, source_idx);
+
     DvzSource* source = NULL;
     DvzContainerIterator iter = dvz_container_iterator(&visual->sources);
     DvzSource* out = NULL;
@@ -560,9 +745,17 @@ DvzArray* dvz_source_array(DvzVisual* visual, DvzSourceType source_type, uint32_
 DvzProp* dvz_prop_get(DvzVisual* visual, DvzPropType prop_type, uint32_t prop_idx)
 {
     ASSERT(visual != NULL);
+    DvzProp* out = NULL;
+    if (!visual->prop_lookup.overflow)
+    {
+        out = _lookup_get(&visual->prop_lookup, prop_type, prop_idx);
+        if (out == NULL)
+            log_trace("prop with type %d #%d not found", prop_type, prop_idx);
+        return out;
+    }
+
     DvzProp* prop = NULL;
     DvzContainerIterator iter = dvz_container_iterator(&visual->props);
-    DvzProp* out = NULL;
     while (iter.item != NULL)
     {
         prop = iter.item;
@@ -590,6 +783,50 @@ DvzArray* dvz_prop_array(DvzVisual* visual, DvzPropType prop_type, uint32_t prop
 
 
 
+bool dvz_prop_bounds(DvzProp* prop, DvzBox* box)
+{
+    ASSERT(prop != NULL);
+    ASSERT(box != NULL);
+    if (!_prop_has_bounds(prop) || !prop->bounds_valid || prop->arr_orig.item_count == 0)
+        return false;
+    *box = prop->bounds;
+    return true;
+}
+
+
+
+bool dvz_visual_bounds(DvzVisual* visual, DvzBox* box)
+{
+    ASSERT(visual != NULL);
+    ASSERT(box != NULL);
+
+    DvzBox merged = DVZ_BOX_INF;
+    DvzBox prop_box = {0};
+    DvzProp* prop = NULL;
+    bool found = false;
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        prop = dvz_prop_get(visual, DVZ_PROP_POS, i);
+        if (prop == NULL)
+            break;
+        if (prop->arr_orig.item_count == 0)
+            continue;
+        if (!dvz_prop_bounds(prop, &prop_box))
+            return false;
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            merged.p0[j] = MIN(merged.p0[j], prop_box.p0[j]);
+            merged.p1[j] = MAX(merged.p1[j], prop_box.p1[j]);
+        }
+        found = true;
+    }
+    if (found)
+        *box = merged;
+    return found;
+}
+
+
+
 uint32_t dvz_prop_size(DvzProp* prop)
 {
     DvzArray* arr = _prop_array(prop);
@@ -618,6 +855,121 @@ void* dvz_prop_item(DvzProp* prop, uint32_t prop_idx)
 /*  Data update                                                                                  */
 /*************************************************************************************************/
 
+// Upload the dirty region of the ring buffer of a visual in streaming mode.
+static void _upload_ring(DvzVisual* visual, DvzSource* source)
+{
+    ASSERT(visual != NULL);
+    ASSERT(source != NULL);
+    DvzVisualRing* ring = &visual->ring;
+    DvzArray* arr = &source->arr;
+    DvzBufferRegions* br = &source->u.br;
+    ASSERT(arr->item_count == ring->capacity);
+
+    if (ring->dirty_count == 0)
+        return;
+
+    // Upload the region, in two chunks if it wraps around.
+    uint32_t first = ring->dirty_first;
+    uint32_t n0 = MIN(ring->dirty_count, ring->capacity - first);
+    uint32_t n1 = ring->dirty_count - n0;
+    VkDeviceSize item_size = arr->item_size;
+
+    log_trace("upload %d items of the ring buffer, starting at %d", ring->dirty_count, first);
+    dvz_upload_buffers(
+        visual->canvas, *br, first * item_size, n0 * item_size, dvz_array_item(arr, first));
+    if (n1 > 0)
+        dvz_upload_buffers(visual->canvas, *br, 0, n1 * item_size, arr->data);
+
+    ring->dirty_count = 0;
+}
+
+
+
+// Upload the dirty region of a source array in partial mode.
+static void _upload_partial(DvzVisual* visual, DvzSource* source)
+{
+    ASSERT(visual != NULL);
+    ASSERT(source != NULL);
+    DvzArray* arr = &source->arr;
+    ASSERT(source->dirty_first + source->dirty_count <= arr->item_count);
+
+    if (source->dirty_count == 0)
+        return;
+
+    VkDeviceSize item_size = arr->item_size;
+    log_trace(
+        "upload %d items of source %d #%d, starting at %d", //
+        source->dirty_count, source->source_type, source->source_idx, source->dirty_first);
+    dvz_upload_buffers(
+        visual->canvas, source->u.br, source->dirty_first * item_size,
+        source->dirty_count * item_size, dvz_array_item(arr, source->dirty_first));
+
+    source->dirty_count = 0;
+}
+
+
+
+// Upload the indirect draw arguments of the graphics pipelines whose vertex or index count has
+// changed.
+static void _upload_indirect(DvzVisual* visual)
+{
+    ASSERT(visual != NULL);
+    DvzCanvas* canvas = visual->canvas;
+    ASSERT(canvas != NULL);
+    DvzContext* ctx = canvas->gpu->context;
+    ASSERT(ctx != NULL);
+
+    DvzSource* source = NULL;
+    uint32_t vertex_count = 0, index_count = 0;
+    for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
+    {
+        source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_VERTEX, pidx);
+        if (source == NULL)
+            continue;
+        vertex_count = source->arr.item_count;
+        source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_INDEX, pidx);
+        index_count = source != NULL ? source->arr.item_count : 0;
+
+        // Allocate the indirect buffer region, or reuse one released by a destroyed visual.
+        DvzBufferRegions* br = &visual->indirect[pidx];
+        bool is_new = br->buffer == NULL;
+        if (is_new && ctx->indirect_pool_count > 0)
+            *br = ctx->indirect_pool[--ctx->indirect_pool_count];
+        else if (is_new)
+            *br = dvz_ctx_buffers(ctx, DVZ_BUFFER_TYPE_STORAGE, 1, DVZ_VISUAL_INDIRECT_SIZE);
+
+        VkDrawIndirectCommand* args = &visual->indirect_args[pidx];
+        VkDrawIndexedIndirectCommand* iargs = &visual->indirect_indexed_args[pidx];
+
+        // Culled pipeline: the draws are reset when the spatial index is rebuilt, and then
+        // updated by dvz_visual_cull().
+        DvzVisualChunks* chunks = visual->chunks[pidx];
+        if (chunks != NULL)
+        {
+            args->vertexCount = iargs->indexCount = 0;
+            if (!chunks->culled)
+                dvz_upload_buffers(canvas, *br, 0, sizeof(chunks->draws), chunks->draws);
+            continue;
+        }
+        if (index_count == 0 && (is_new || args->vertexCount != vertex_count))
+        {
+            log_trace("upload indirect draw args, %d vertices", vertex_count);
+            *args = (VkDrawIndirectCommand){vertex_count, 1, 0, 0};
+            iargs->indexCount = 0;
+            dvz_upload_buffers(canvas, *br, 0, sizeof(VkDrawIndirectCommand), args);
+        }
+        else if (index_count > 0 && (is_new || iargs->indexCount != index_count))
+        {
+            log_trace("upload indexed indirect draw args, %d indices", index_count);
+            *iargs = (VkDrawIndexedIndirectCommand){index_count, 1, 0, 0, 0};
+            args->vertexCount = 0;
+            dvz_upload_buffers(canvas, *br, 0, sizeof(VkDrawIndexedIndirectCommand), iargs);
+        }
+    }
+}
+
+
+
 void dvz_visual_update(
     DvzVisual* visual, DvzViewport viewport, DvzDataCoords coords, const void* user_data)
 {
@@ -643,6 +995,13 @@ void dvz_visual_update(
     // NOTE: we bake the UNIFORM sources here.
     _bake_uniforms(visual);
 
+    // Upload the glyphs that may have been rasterized on demand by the baking function.
+    dvz_font_atlas_upload(&visual->canvas->gpu->context->font_atlas);
+
+    // Rebuild the spatial index of the baked vertex buffers, before they are uploaded.
+    for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
+        _visual_chunks(visual, pidx);
+
     // Here, we assume that all sources are correctly allocated, which includes VERTEX and INDEX
     // arrays, and that they have their data ready for upload.
 
@@ -765,7 +1124,7 @@ void dvz_visual_update(
             ASSERT(arr->item_size > 0);
 
             // Make sure the GPU buffer exists and is allocated with the right size.
-            _source_buffer(visual, source);
+            bool reallocated = _source_buffer(visual, source);
 
             ASSERT(br->size > 0);
             VkDeviceSize size = arr->item_count * arr->item_size;
@@ -774,12 +1133,31 @@ void dvz_visual_update(
 
             ASSERT(br->buffer != VK_NULL_HANDLE);
 
+            // Streaming mode: only upload the region of the ring buffer that has been written.
+            if (_source_is_ring(visual, source))
+            {
+                _upload_ring(visual, source);
+                _source_set(source);
+                dvz_container_iter(&iter);
+                continue;
+            }
+
+            // Partial mode: only upload the region of the array modified by the baking function.
+            if (source->partial && !reallocated)
+            {
+                _upload_partial(visual, source);
+                _source_set(source);
+                dvz_container_iter(&iter);
+                continue;
+            }
+
             log_trace(
                 "upload buffer (%d items, buffer size %d bytes) for automatically-handled source "
                 "%d #%d", //
                 arr->item_count, br->size, source->source_type, source->source_idx);
 
             dvz_upload_buffers(canvas, *br, 0, size, arr->data);
+            source->dirty_count = 0;
             _source_set(source);
             // source->obj.status = DVZ_OBJECT_STATUS_CREATED;
             // visual->obj.status = DVZ_OBJECT_STATUS_CREATED;
@@ -815,13 +1193,20 @@ void dvz_visual_update(
         dvz_container_iter(&iter);
     }
 
-    // Update the bindings that need to be updated.
+    // Update the indirect draw arguments if the number of vertices or indices has changed.
+    _upload_indirect(visual);
+
+    // Update the bindings that need to be updated. The descriptor sets are bound in the
+    // recorded command buffers, which will need to be re-recorded.
     for (uint32_t i = 0; i < visual->graphics_count; i++)
     {
         bindings = dvz_container_get(&visual->bindings, i);
         ASSERT(bindings != NULL);
         if (bindings->obj.status == DVZ_OBJECT_STATUS_NEED_UPDATE)
+        {
             dvz_bindings_update(bindings);
+            dvz_visual_to_refill(visual);
+        }
     }
     for (uint32_t i = 0; i < visual->compute_count; i++)
     {
@@ -831,3 +1216,39 @@ void dvz_visual_update(
             dvz_bindings_update(bindings);
     }
 }
+
+
+
+void dvz_visual_cull(DvzVisual* visual, DvzMVP* mvp)
+{
+    ASSERT(visual != NULL);
+    ASSERT(mvp != NULL);
+
+    DvzVisualChunks* chunks = NULL;
+    mat4 m = {0};
+    float bounds[6] = {0};
+    bool cullable = false;
+    for (uint32_t pidx = 0; pidx < visual->graphics_count; pidx++)
+    {
+        chunks = visual->chunks[pidx];
+        if (chunks == NULL)
+            continue;
+
+        // Skip if neither the transformation nor the viewport have changed.
+        cullable = _chunks_transform(visual, pidx, mvp, m, bounds);
+        if (chunks->culled && memcmp(chunks->mvp, m, sizeof(mat4)) == 0 &&
+            memcmp(chunks->bounds, bounds, sizeof(bounds)) == 0)
+            continue;
+        glm_mat4_copy(m, chunks->mvp);
+        memcpy(chunks->bounds, bounds, sizeof(bounds));
+        chunks->culled = true;
+
+        if (_chunks_draws(chunks, cullable ? m : NULL, bounds))
+        {
+            log_trace("upload the draws of the chunks in the view");
+            ASSERT(visual->indirect[pidx].buffer != NULL);
+            dvz_upload_buffers(
+                visual->canvas, visual->indirect[pidx], 0, sizeof(chunks->draws), chunks->draws);
+        }
+    }
+}
@@ -5,6 +5,74 @@
 
 
 
+/*************************************************************************************************/
+/*  Prop and source lookup                                                                       */
+/*************************************************************************************************/
+
+static inline uint32_t _lookup_key(uint32_t type, uint32_t idx)
+{
+    ASSERT(type <= 0xFFFF);
+    ASSERT(idx <= 0xFFFF);
+    return (type << 16) | idx;
+}
+
+
+
+static inline uint32_t _lookup_slot(uint32_t key)
+{
+    // Fibonacci hashing, the table size is a power of 2.
+    return ((key * 2654435769u) >> 16) & (DVZ_MAX_VISUAL_LOOKUP - 1);
+}
+
+
+
+// Register a prop or a source in a lookup table.
+static void _lookup_insert(DvzVisualLookup* lookup, uint32_t type, uint32_t idx, void* item)
+{
+    ASSERT(lookup != NULL);
+    ASSERT(item != NULL);
+    // Keep the load factor below 1/2 so that the probe sequences remain short.
+    if (type > 0xFFFF || idx > 0xFFFF || 2 * (lookup->count + 1) > DVZ_MAX_VISUAL_LOOKUP)
+    {
+        log_debug("visual lookup table full, falling back to linear scans");
+        lookup->overflow = true;
+        return;
+    }
+    uint32_t key = _lookup_key(type, idx);
+    uint32_t slot = _lookup_slot(key);
+    while (lookup->items[slot] != NULL)
+    {
+        // Check there is only 1 item with a given type and idx.
+        ASSERT(lookup->keys[slot] != key);
+        slot = (slot + 1) & (DVZ_MAX_VISUAL_LOOKUP - 1);
+    }
+    lookup->keys[slot] = key;
+    lookup->items[slot] = item;
+    lookup->count++;
+}
+
+
+
+// Find a prop or a source in a lookup table, return NULL if not found.
+static void* _lookup_get(DvzVisualLookup* lookup, uint32_t type, uint32_t idx)
+{
+    ASSERT(lookup != NULL);
+    ASSERT(!lookup->overflow);
+    if (type > 0xFFFF || idx > 0xFFFF)
+        return NULL;
+    uint32_t key = _lookup_key(type, idx);
+    uint32_t slot = _lookup_slot(key);
+    while (lookup->items[slot] != NULL)
+    {
+        if (lookup->keys[slot] == key)
+            return lookup->items[slot];
+        slot = (slot + 1) & (DVZ_MAX_VISUAL_LOOKUP - 1);
+    }
+    return NULL;
+}
+
+
+
 /*************************************************************************************************/
 /*  Visual utils                                                                                 */
 /*************************************************************************************************/
@@ -34,6 +102,18 @@ static bool _source_needs_binding(DvzSourceKind source_kind)
 
 
 
+// Whether the source is the ring buffer of a visual in streaming mode.
+static bool _source_is_ring(DvzVisual* visual, DvzSource* source)
+{
+    ASSERT(visual != NULL);
+    ASSERT(source != NULL);
+    return visual->ring.capacity > 0 &&                   //
+           source->source_type == DVZ_SOURCE_TYPE_VERTEX && //
+           source->source_idx == 0;
+}
+
+
+
 // Return the source array.
 static DvzArray* _source_array(DvzSource* source)
 {
@@ -88,6 +168,25 @@ static void _source_set_changed(DvzSource* source, bool value)
 
 
 
+// Add a region of the source array to the region to upload at the next update in partial mode.
+static void _source_dirty(DvzSource* source, uint32_t first, uint32_t count)
+{
+    ASSERT(source != NULL);
+    if (count == 0)
+        return;
+    if (source->dirty_count == 0)
+    {
+        source->dirty_first = first;
+        source->dirty_count = count;
+        return;
+    }
+    uint32_t end = MAX(source->dirty_first + source->dirty_count, first + count);
+    source->dirty_first = MIN(source->dirty_first, first);
+    source->dirty_count = end - source->dirty_first;
+}
+
+
+
 static void _source_set(DvzSource* source)
 {
     ASSERT(source != NULL);
@@ -240,6 +339,111 @@ static DvzArray* _prop_array(DvzProp* prop)
 
 
 
+/*************************************************************************************************/
+/*  Prop bounds                                                                                  */
+/*************************************************************************************************/
+
+// Whether the running bounds are maintained for a prop.
+static inline bool _prop_has_bounds(DvzProp* prop)
+{
+    ASSERT(prop != NULL);
+    return prop->prop_type == DVZ_PROP_POS && prop->arr_orig.dtype == DVZ_DTYPE_DVEC3;
+}
+
+
+
+// Whether some existing items, about to be overwritten or removed, lie on the current bounds, in
+// which case the bounds may shrink and require a full scan.
+static bool _prop_bounds_touched(DvzProp* prop, uint32_t first_item, uint32_t item_count)
+{
+    ASSERT(prop != NULL);
+    DvzArray* arr = &prop->arr_orig;
+    if (first_item >= arr->item_count)
+        return false;
+    item_count = MIN(item_count, arr->item_count - first_item);
+
+    const double* x = (const double*)arr->data + 3 * (uint64_t)first_item;
+    for (uint32_t i = 0; i < 3 * item_count; i++)
+    {
+        if (x[i] <= prop->bounds.p0[i % 3] || x[i] >= prop->bounds.p1[i % 3])
+            return true;
+    }
+    return false;
+}
+
+
+
+// Called before writing items [first_item, first_item + item_count) in a prop array that will
+// have `count` items: reset the bounds on a full replacement, or invalidate them if they may
+// shrink.
+static void _prop_bounds_before(
+    DvzProp* prop, uint32_t first_item, uint32_t item_count, uint32_t count)
+{
+    ASSERT(prop != NULL);
+    uint32_t n = prop->arr_orig.item_count;
+    if (first_item == 0 && item_count == count)
+    {
+        prop->bounds = DVZ_BOX_INF;
+        prop->bounds_valid = true;
+        return;
+    }
+    // The items beyond the current end are unknown until written.
+    if (first_item > n)
+    {
+        prop->bounds_valid = false;
+        return;
+    }
+    if (!prop->bounds_valid)
+        return;
+
+    // The overwritten items.
+    ASSERT(first_item <= count);
+    bool touched = _prop_bounds_touched(prop, first_item, MIN(count, n) - first_item);
+
+    // The items removed by the resize. When they outnumber the remaining items, the full scan of
+    // the latter is cheaper than checking them.
+    if (!touched && count < n)
+        touched = n - count > count || _prop_bounds_touched(prop, count, n - count);
+
+    if (touched)
+        prop->bounds_valid = false;
+}
+
+
+
+// Called after writing items: extend the bounds in O(item_count).
+static void _prop_bounds_after(DvzProp* prop, uint32_t first_item, uint32_t item_count)
+{
+    ASSERT(prop != NULL);
+    if (prop->bounds_valid)
+        dvz_array_bounds(
+            &prop->arr_orig, first_item, item_count, prop->bounds.p0, prop->bounds.p1);
+}
+
+
+
+// Return the bounds of a prop, with a full scan if they are stale.
+static DvzBox _prop_bounds(DvzProp* prop)
+{
+    ASSERT(prop != NULL);
+    ASSERT(_prop_has_bounds(prop));
+    if (!prop->bounds_valid)
+    {
+        log_trace("full scan of the bounds of prop %d", prop->prop_type);
+        prop->bounds = DVZ_BOX_INF;
+        dvz_array_bounds(
+            &prop->arr_orig, 0, prop->arr_orig.item_count, prop->bounds.p0, prop->bounds.p1);
+        prop->bounds_valid = true;
+    }
+    return prop->bounds;
+}
+
+
+
+/*************************************************************************************************/
+/*  Source utils                                                                                 */
+/*************************************************************************************************/
+
 static uint32_t _source_size(DvzVisual* visual, DvzSource* source)
 {
     ASSERT(visual != NULL);
@@ -268,8 +472,10 @@ static uint32_t _source_size(DvzVisual* visual, DvzSource* source)
 
 static void _set_source_bindings(DvzVisual* visual, DvzSource* source)
 {
-    // Set bindings except for VERTEX and INDEX sources.
-    if (_source_needs_binding(source->source_kind))
+    // Set bindings except for VERTEX and INDEX sources, unless the VERTEX source is also
+    // accessed as a storage buffer by the shaders (vertex pulling).
+    if (_source_needs_binding(source->source_kind) ||
+        (source->flags & DVZ_SOURCE_FLAG_STORAGE) != 0)
     {
         DvzBindings* bindings = _get_bindings(visual, source);
         // NOTE: the graphics must be created before.
@@ -323,7 +529,9 @@ static void _create_source_buffer(DvzCanvas* canvas, DvzSource* source, VkDevice
 
 
 
-static void _source_buffer(DvzVisual* visual, DvzSource* source)
+// Return whether the GPU buffer has been (re)allocated, in which case the whole array must be
+// uploaded.
+static bool _source_buffer(DvzVisual* visual, DvzSource* source)
 {
     ASSERT(visual != NULL);
     ASSERT(source != NULL);
@@ -346,8 +554,11 @@ static void _source_buffer(DvzVisual* visual, DvzSource* source)
         _create_source_buffer(canvas, source, size);
         // Set the pipeline bindings with the source buffer.
         _set_source_bindings(visual, source);
+        ASSERT(source->u.br.buffer != VK_NULL_HANDLE);
+        return true;
     }
     ASSERT(source->u.br.buffer != VK_NULL_HANDLE);
+    return false;
 }
 
 
@@ -503,6 +714,69 @@ _get_pipeline_source(DvzVisual* visual, DvzSourceType source_type, uint32_t pipe
 
 
 
+// Copy the newly-written items of the ring props to the ring source array.
+static void _bake_ring(DvzVisual* visual, DvzSource* source)
+{
+    ASSERT(visual != NULL);
+    ASSERT(source != NULL);
+    DvzVisualRing* ring = &visual->ring;
+    ASSERT(ring->capacity > 0);
+
+    // The ring source array has a constant size.
+    if (source->arr.item_count != ring->capacity)
+    {
+        _source_alloc(visual, source, ring->capacity);
+        ring->dirty_first = 0;
+        ring->dirty_count = ring->capacity;
+    }
+
+    // Region to bake: the region not uploaded yet, extended with the items written since the
+    // last bake (the dirty region always ends at the ring head).
+    uint32_t first = ring->dirty_count > 0 ? ring->dirty_first : ring->head;
+    uint32_t count = MIN(ring->dirty_count + ring->pending, ring->capacity);
+    if (count == 0)
+        return;
+
+    // Copy the region, in two chunks if it wraps around.
+    uint32_t chunk_first[2] = {first, 0};
+    uint32_t chunk_count[2] = {MIN(count, ring->capacity - first), 0};
+    chunk_count[1] = count - chunk_count[0];
+
+    DvzProp* prop = NULL;
+    DvzArray* arr = NULL;
+    VkDeviceSize col_size = 0;
+    DvzContainerIterator iter = dvz_container_iterator(&visual->props);
+    while (iter.item != NULL)
+    {
+        prop = iter.item;
+        arr = &prop->arr_orig;
+        if (prop->source == source && prop->copy_type != DVZ_ARRAY_COPY_NONE &&
+            arr->item_count == ring->capacity)
+        {
+            col_size = _get_dtype_size(prop->dtype);
+            for (uint32_t k = 0; k < 2; k++)
+            {
+                if (chunk_count[k] == 0)
+                    continue;
+                dvz_array_column(
+                    &source->arr, prop->offset, col_size, chunk_first[k], chunk_count[k], //
+                    chunk_count[k], dvz_array_item(arr, chunk_first[k]),                 //
+                    arr->dtype, prop->target_dtype, prop->copy_type, 1);
+            }
+        }
+        dvz_container_iter(&iter);
+    }
+
+    // Advance the ring head, and keep track of the region to upload.
+    ring->dirty_first = first;
+    ring->dirty_count = count;
+    ring->head = (ring->head + ring->pending) % ring->capacity;
+    ring->count = MIN(ring->count + ring->pending, ring->capacity);
+    ring->pending = 0;
+}
+
+
+
 static void _bake_source(DvzVisual* visual, DvzSource* source)
 {
     ASSERT(visual != NULL);
@@ -519,6 +793,13 @@ static void _bake_source(DvzVisual* visual, DvzSource* source)
         return;
     }
 
+    // Streaming mode: only bake the items written since the last bake.
+    if (_source_is_ring(visual, source))
+    {
+        _bake_ring(visual, source);
+        return;
+    }
+
     // The number of vertices corresponds to the largest prop.
     uint32_t count = _source_size(visual, source);
     if (count == 0)
@@ -570,6 +851,345 @@ static void _bake_uniforms(DvzVisual* visual)
 
 
 
+/*************************************************************************************************/
+/*  Spatial index                                                                                */
+/*************************************************************************************************/
+
+// Whether the vertex buffer of a graphics pipeline may be split into chunks culled independently:
+// large non-indexed lists of primitives, with float positions transformed by the MVP.
+static bool _chunks_supported(DvzVisual* visual, uint32_t pidx, DvzSource* source)
+{
+    ASSERT(visual != NULL);
+    ASSERT(source != NULL);
+    DvzGraphics* graphics = visual->graphics[pidx];
+    ASSERT(graphics != NULL);
+
+    if (source->arr.item_count < 2 * DVZ_VISUAL_CHUNK_MIN_SIZE || _source_is_ring(visual, source))
+        return false;
+    DvzSource* index_source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_INDEX, pidx);
+    if (index_source != NULL && index_source->arr.item_count > 0)
+        return false;
+    if (graphics->topology != VK_PRIMITIVE_TOPOLOGY_POINT_LIST &&
+        graphics->topology != VK_PRIMITIVE_TOPOLOGY_LINE_LIST &&
+        graphics->topology != VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+        return false;
+    if (graphics->vertex_attr_count == 0 ||
+        graphics->vertex_attrs[0].format != VK_FORMAT_R32G32B32_SFLOAT)
+        return false;
+
+    // Items with their own transform mode, such as fixed markers, are not culled.
+    DvzProp* prop = dvz_prop_get(visual, DVZ_PROP_TRANSFORM, 0);
+    if (prop != NULL && prop->dtype == DVZ_DTYPE_CHAR)
+    {
+        DvzArray* arr = _prop_array(prop);
+        const char* transform = (const char*)arr->data;
+        for (uint32_t i = 0; i < arr->item_count; i++)
+            if (transform[i] != 0)
+                return false;
+    }
+    return true;
+}
+
+
+
+// Spread the 10 lowest bits of an integer, with two zero bits between consecutive bits.
+static inline uint32_t _morton_spread(uint32_t x)
+{
+    x &= 0x3FF;
+    x = (x | (x << 16)) & 0x030000FF;
+    x = (x | (x << 8)) & 0x0300F00F;
+    x = (x | (x << 4)) & 0x030C30C3;
+    x = (x | (x << 2)) & 0x09249249;
+    return x;
+}
+
+
+
+// Reorder the vertices along the Morton curve of their positions, so that the chunks of
+// consecutive vertices are spatially compact.
+static void _chunks_sort(DvzArray* arr, VkDeviceSize offset)
+{
+    ASSERT(arr != NULL);
+    uint32_t n = arr->item_count;
+    VkDeviceSize item_size = arr->item_size;
+    ASSERT(offset + 3 * sizeof(float) <= item_size);
+
+    DvzBox box = DVZ_BOX_INF;
+    const float* pos = NULL;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        pos = (const float*)((const uint8_t*)dvz_array_item(arr, i) + offset);
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            box.p0[k] = MIN(pos[k], box.p0[k]); // skip NaN values
+            box.p1[k] = MAX(pos[k], box.p1[k]);
+        }
+    }
+
+    // Morton keys of the positions quantized on 10 bits per axis.
+    double scale[3] = {0};
+    for (uint32_t k = 0; k < 3; k++)
+        if (box.p1[k] > box.p0[k])
+            scale[k] = 1023 / (box.p1[k] - box.p0[k]);
+    uint32_t* buf = (uint32_t*)calloc(4 * (uint64_t)n, sizeof(uint32_t));
+    uint32_t *keys = buf, *idx = buf + n, *keys_tmp = buf + 2 * n, *idx_tmp = buf + 3 * n;
+    uint32_t q[3] = {0};
+    double u = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        pos = (const float*)((const uint8_t*)dvz_array_item(arr, i) + offset);
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            u = (pos[k] - box.p0[k]) * scale[k];
+            q[k] = u > 0 ? (uint32_t)MIN(u, 1023) : 0;
+        }
+        keys[i] = _morton_spread(q[0]) | (_morton_spread(q[1]) << 1) |
+                  (_morton_spread(q[2]) << 2);
+        idx[i] = i;
+    }
+
+    // Radix sort of the keys, 8 bits per pass. The sorted keys end up in the first buffer after
+    // an even number of passes.
+    uint32_t hist[256] = {0};
+    uint32_t *swap = NULL, sum = 0, count = 0, j = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+        memset(hist, 0, sizeof(hist));
+        for (uint32_t i = 0; i < n; i++)
+            hist[(keys[i] >> shift) & 0xFF]++;
+        sum = 0;
+        for (uint32_t b = 0; b < 256; b++)
+        {
+            count = hist[b];
+            hist[b] = sum;
+            sum += count;
+        }
+        for (uint32_t i = 0; i < n; i++)
+        {
+            j = hist[(keys[i] >> shift) & 0xFF]++;
+            keys_tmp[j] = keys[i];
+            idx_tmp[j] = idx[i];
+        }
+        swap = keys, keys = keys_tmp, keys_tmp = swap;
+        swap = idx, idx = idx_tmp, idx_tmp = swap;
+    }
+    ASSERT(keys == buf);
+
+    // Permute the vertices.
+    uint8_t* data = (uint8_t*)malloc(n * item_size);
+    for (uint32_t i = 0; i < n; i++)
+        memcpy(&data[i * item_size], dvz_array_item(arr, idx[i]), item_size);
+    memcpy(arr->data, data, n * item_size);
+    FREE(data);
+    FREE(buf);
+}
+
+
+
+// Whether a bounding box may intersect the view, with the transformation and the bounds of the
+// shaders (see transform() in common.glsl).
+static bool _chunk_visible(vec4* m, float* bounds, DvzBox* box)
+{
+    ASSERT(m != NULL);
+    ASSERT(bounds != NULL);
+    ASSERT(box != NULL);
+
+    // The box is culled if its 8 corners are outside of the same plane.
+    int outside = 0x3F;
+    float p[3] = {0};
+    vec4 c = {0};
+    float x = 0, y = 0, tx = 1 + bounds[2], ty = 1 + bounds[5];
+    for (uint32_t i = 0; i < 8 && outside != 0; i++)
+    {
+        p[0] = (float)((i & 1) ? box->p1[0] : box->p0[0]);
+        p[1] = (float)((i & 2) ? box->p1[1] : box->p0[1]);
+        p[2] = (float)((i & 4) ? box->p1[2] : box->p0[2]);
+        for (uint32_t r = 0; r < 4; r++)
+            c[r] = m[0][r] * p[0] + m[1][r] * p[1] + m[2][r] * p[2] + m[3][r];
+        x = bounds[0] * c[0] + bounds[1];
+        y = bounds[3] * c[1] + bounds[4];
+        outside &= (x < -tx * c[3]) | (x > tx * c[3]) << 1 |     //
+                   (y < -ty * c[3]) << 2 | (y > ty * c[3]) << 3 | //
+                   (c[2] < -c[3]) << 4 | (c[2] > c[3]) << 5;
+    }
+    return outside == 0;
+}
+
+
+
+// Draw all the vertices, or only the runs of chunks whose bounding box intersects the view if
+// a transformation is given. Return whether the indirect draws have changed.
+static bool _chunks_draws(DvzVisualChunks* chunks, vec4* m, float* bounds)
+{
+    ASSERT(chunks != NULL);
+    VkDrawIndirectCommand draws[DVZ_VISUAL_CULL_DRAWS] = {0};
+    VkDrawIndirectCommand* draw = NULL;
+    uint32_t count = 0, first = 0, last = 0;
+    for (uint32_t i = 0; i < chunks->chunk_count; i++)
+    {
+        if (m != NULL && !_chunk_visible(m, bounds, &chunks->boxes[i]))
+            continue;
+        first = i * chunks->chunk_size;
+        last = MIN(first + chunks->chunk_size, chunks->vertex_count);
+
+        // Extend the last draw with contiguous chunks, or when there are no more draws.
+        draw = count > 0 ? &draws[count - 1] : NULL;
+        if (draw != NULL &&
+            (draw->firstVertex + draw->vertexCount == first || count == DVZ_VISUAL_CULL_DRAWS))
+            draw->vertexCount = last - draw->firstVertex;
+        else
+            draws[count++] = (VkDrawIndirectCommand){last - first, 1, first, 0};
+    }
+
+    if (memcmp(draws, chunks->draws, sizeof(draws)) == 0)
+        return false;
+    memcpy(chunks->draws, draws, sizeof(draws));
+    return true;
+}
+
+
+
+// Return the interact axis a graphics pipeline was specialized on, or -1 if it was not.
+static int32_t _chunks_specialized_axis(DvzGraphics* graphics)
+{
+    if (graphics == NULL)
+        return -1;
+    DvzSpecialization* specialization = &graphics->specialization;
+    for (uint32_t i = 0; i < specialization->count; i++)
+    {
+        if (specialization->entries[i].constantID != DVZ_SPECIALIZATION_INTERACT_AXIS)
+            continue;
+        int32_t value = 0;
+        memcpy(&value, &specialization->data[i], sizeof(int32_t));
+        // NOTE: -1 is the shader default, the other values are DvzInteractAxis >> 12.
+        return value < 0 ? -1 : value << 12;
+    }
+    return -1;
+}
+
+
+
+// Compute the transformation and the bounds used by the shaders of a graphics pipeline. Return
+// false if the vertices cannot be culled.
+static bool
+_chunks_transform(DvzVisual* visual, uint32_t pidx, DvzMVP* mvp, mat4 m, float* bounds)
+{
+    ASSERT(visual != NULL);
+    ASSERT(mvp != NULL);
+    ASSERT(bounds != NULL);
+    DvzViewport* viewport = &visual->viewport;
+
+    glm_mat4_zero(m);
+    memset(bounds, 0, 6 * sizeof(float));
+    // NOTE: a specialized pipeline ignores the viewport value, see transform() in common.glsl.
+    int32_t axis = _chunks_specialized_axis(visual->graphics[pidx]);
+    if (axis < 0)
+        axis = (int32_t)visual->interact_axis[pidx];
+    if (axis != DVZ_INTERACT_FIXED_AXIS_DEFAULT && axis != DVZ_INTERACT_FIXED_AXIS_NONE)
+        return false;
+    // NOTE: the emulated double positions are not culled.
+    if (viewport->data_scale[3] == 2)
+        return false;
+
+    mat4 pv = GLM_MAT4_IDENTITY_INIT;
+    glm_mat4_mul(mvp->proj, mvp->view, pv);
+    glm_mat4_mul(pv, mvp->model, m);
+
+    // Data normalization on the GPU.
+    if (viewport->data_scale[3] == 1)
+    {
+        mat4 pvm = GLM_MAT4_IDENTITY_INIT;
+        mat4 norm = GLM_MAT4_IDENTITY_INIT;
+        glm_mat4_copy(m, pvm);
+        for (uint32_t k = 0; k < 3; k++)
+        {
+            norm[k][k] = viewport->data_scale[k];
+            norm[3][k] = viewport->data_offset[k];
+        }
+        glm_mat4_mul(pvm, norm, m);
+    }
+
+    // Margins, and tolerance for the primitives larger than their vertices (markers, thick lines).
+    float w = viewport->size_framebuffer[0], h = viewport->size_framebuffer[1];
+    float mt = viewport->margins[0], mr = viewport->margins[1];
+    float mb = viewport->margins[2], ml = viewport->margins[3];
+    bounds[0] = w > 0 ? 1 - (ml + mr) / w : 1;
+    bounds[1] = w > 0 ? (ml - mr) / w : 0;
+    bounds[2] = w > 0 ? 2 * DVZ_VISUAL_CULL_MARGIN / w : 0;
+    bounds[3] = h > 0 ? 1 - (mb + mt) / h : 1;
+    bounds[4] = h > 0 ? (mb - mt) / h : 0;
+    bounds[5] = h > 0 ? 2 * DVZ_VISUAL_CULL_MARGIN / h : 0;
+    return true;
+}
+
+
+
+// (Re)build the spatial index of a graphics pipeline after its vertex buffer has been baked.
+static void _visual_chunks(DvzVisual* visual, uint32_t pidx)
+{
+    ASSERT(visual != NULL);
+    DvzSource* source = _get_pipeline_source(visual, DVZ_SOURCE_TYPE_VERTEX, pidx);
+    if (source == NULL || !_source_is_set(source) || !_source_has_changed(source))
+        return;
+    DvzGraphics* graphics = visual->graphics[pidx];
+    ASSERT(graphics != NULL);
+
+    // The draw commands depend on whether the pipeline is culled.
+    bool supported = _chunks_supported(visual, pidx, source);
+    if (supported != (visual->chunks[pidx] != NULL))
+        dvz_visual_to_refill(visual);
+    if (!supported)
+    {
+        FREE(visual->chunks[pidx]);
+        return;
+    }
+    if (visual->chunks[pidx] == NULL)
+        visual->chunks[pidx] = (DvzVisualChunks*)calloc(1, sizeof(DvzVisualChunks));
+    DvzVisualChunks* chunks = visual->chunks[pidx];
+
+    // NOTE: the point lists are sorted only when the vertex buffer is entirely baked by datoviz,
+    // as the order of the vertices changes.
+    DvzArray* arr = &source->arr;
+    VkDeviceSize offset = graphics->vertex_attrs[0].offset;
+    if (graphics->topology == VK_PRIMITIVE_TOPOLOGY_POINT_LIST &&
+        graphics->vertex_binding_count == 1 && source->origin == DVZ_SOURCE_ORIGIN_LIB &&
+        !source->partial)
+        _chunks_sort(arr, offset);
+
+    // The chunk size is a multiple of the number of vertices per primitive.
+    uint32_t n = arr->item_count;
+    uint32_t size = (n + DVZ_MAX_VISUAL_CHUNKS - 1) / DVZ_MAX_VISUAL_CHUNKS;
+    size = MAX(DVZ_VISUAL_CHUNK_MIN_SIZE, 6 * ((size + 5) / 6));
+    chunks->vertex_count = n;
+    chunks->chunk_size = size;
+    chunks->chunk_count = (n + size - 1) / size;
+    ASSERT(chunks->chunk_count <= DVZ_MAX_VISUAL_CHUNKS);
+    log_debug("spatial index of %d vertices with %d chunks", n, chunks->chunk_count);
+
+    const float* pos = NULL;
+    DvzBox* box = NULL;
+    for (uint32_t c = 0; c < chunks->chunk_count; c++)
+    {
+        box = &chunks->boxes[c];
+        *box = DVZ_BOX_INF;
+        for (uint32_t i = c * size; i < MIN((c + 1) * size, n); i++)
+        {
+            pos = (const float*)((const uint8_t*)dvz_array_item(arr, i) + offset);
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                box->p0[k] = MIN(pos[k], box->p0[k]);
+                box->p1[k] = MAX(pos[k], box->p1[k]);
+            }
+        }
+    }
+
+    // Draw everything until the next culling.
+    chunks->culled = false;
+    _chunks_draws(chunks, NULL, NULL);
+}
+
+
+
 /*************************************************************************************************/
 /*  Visual default callbacks                                                                     */
 /*************************************************************************************************/
@@ -645,22 +1265,32 @@ static void _default_visual_fill(DvzVisual* visual, DvzVisualFillEvent ev)
             }
         }
 
-        // Draw command.
+        // Bind the pipeline.
         dvz_cmd_bind_graphics(cmds, idx, visual->graphics[pipeline_idx], bindings, 0);
 
+        // Draw command, with the indirect draw arguments if they have been uploaded.
+        DvzBufferRegions* indirect = &visual->indirect[pipeline_idx];
         if (index_count == 0)
         {
             log_debug("draw %d vertices", vertex_count);
             // Make sure the bound vertex buffer is large enough.
             ASSERT(vertex_buf->size >= vertex_count * vertex_source->arr.item_size);
-            dvz_cmd_draw(cmds, idx, 0, vertex_count);
+            if (visual->chunks[pipeline_idx] != NULL)
+                dvz_cmd_draw_indirect_multi(cmds, idx, *indirect, DVZ_VISUAL_CULL_DRAWS);
+            else if (indirect->buffer != NULL)
+                dvz_cmd_draw_indirect(cmds, idx, *indirect);
+            else
+                dvz_cmd_draw(cmds, idx, 0, vertex_count);
         }
         else
         {
             log_debug("draw %d indices", index_count);
             // Make sure the bound index buffer is large enough.
             ASSERT(index_buf->size >= index_count * sizeof(DvzIndex));
-            dvz_cmd_draw_indexed(cmds, idx, 0, 0, index_count);
+            if (indirect->buffer != NULL)
+                dvz_cmd_draw_indexed_indirect(cmds, idx, *indirect);
+            else
+                dvz_cmd_draw_indexed(cmds, idx, 0, 0, index_count);
         }
     }
 }
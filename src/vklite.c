@@ -180,6 +180,9 @@ void dvz_gpu_create(DvzGpu* gpu, VkSurfaceKHR surface)
     // Create descriptor pool.
     create_descriptor_pool(gpu->device, &gpu->dset_pool);
 
+    // Create the pipeline cache, with the pipelines of the previous runs.
+    create_pipeline_cache(gpu);
+
     dvz_obj_created(&gpu->obj);
     log_trace("GPU #%d created", gpu->idx);
 }
@@ -254,6 +257,9 @@ void dvz_gpu_destroy(DvzGpu* gpu)
     }
 
 
+    // Save the pipeline cache file.
+    destroy_pipeline_cache(gpu);
+
     if (gpu->dset_pool != VK_NULL_HANDLE)
     {
         log_trace("destroy descriptor pool");
@@ -617,7 +623,37 @@ DvzCommands dvz_commands(DvzGpu* gpu, uint32_t queue, uint32_t count)
     commands.gpu = gpu;
     commands.queue_idx = queue;
     commands.count = count;
-    allocate_command_buffers(gpu->device, gpu->queues.cmd_pools[qf], count, commands.cmds);
+    allocate_command_buffers(
+        gpu->device, gpu->queues.cmd_pools[qf], VK_COMMAND_BUFFER_LEVEL_PRIMARY, count,
+        commands.cmds);
+
+    dvz_obj_init(&commands.obj);
+
+    return commands;
+}
+
+
+
+DvzCommands dvz_commands_secondary(DvzGpu* gpu, uint32_t queue, uint32_t count)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(dvz_obj_is_created(&gpu->obj));
+
+    ASSERT(count <= DVZ_MAX_COMMAND_BUFFERS_PER_SET);
+    ASSERT(queue < gpu->queues.queue_count);
+    ASSERT(count > 0);
+    uint32_t qf = gpu->queues.queue_families[queue];
+    ASSERT(qf < gpu->queues.queue_family_count);
+    ASSERT(gpu->queues.cmd_pools[qf] != VK_NULL_HANDLE);
+    log_trace("creating secondary commands on queue #%d, queue family #%d", queue, qf);
+
+    DvzCommands commands = {0};
+    commands.gpu = gpu;
+    commands.queue_idx = queue;
+    commands.count = count;
+    allocate_command_buffers(
+        gpu->device, gpu->queues.cmd_pools[qf], VK_COMMAND_BUFFER_LEVEL_SECONDARY, count,
+        commands.cmds);
 
     dvz_obj_init(&commands.obj);
 
@@ -638,6 +674,36 @@ void dvz_cmd_begin(DvzCommands* cmds, uint32_t idx)
 
 
 
+void dvz_cmd_begin_secondary(
+    DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass, DvzFramebuffers* framebuffers)
+{
+    ASSERT(cmds != NULL);
+    ASSERT(cmds->count > 0);
+    ASSERT(renderpass != NULL);
+    ASSERT(framebuffers != NULL);
+    ASSERT(dvz_obj_is_created(&renderpass->obj));
+    ASSERT(dvz_obj_is_created(&framebuffers->obj));
+
+    // The secondary command buffer will be executed within the first subpass of the render
+    // pass, on the framebuffer of the corresponding swapchain image.
+    ASSERT(framebuffers->framebuffer_count > 0);
+    uint32_t iclip = MIN(idx, framebuffers->framebuffer_count - 1);
+
+    VkCommandBufferInheritanceInfo inheritance = {0};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = renderpass->renderpass;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = framebuffers->framebuffers[iclip];
+
+    VkCommandBufferBeginInfo begin_info = {0};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(cmds->cmds[idx], &begin_info));
+}
+
+
+
 void dvz_cmd_end(DvzCommands* cmds, uint32_t idx)
 {
     ASSERT(cmds != NULL);
@@ -671,9 +737,9 @@ void dvz_cmd_free(DvzCommands* cmds)
     ASSERT(cmds->gpu->device != VK_NULL_HANDLE);
 
     log_trace("free %d command buffer(s)", cmds->count);
+    uint32_t qf = cmds->gpu->queues.queue_families[cmds->queue_idx];
     vkFreeCommandBuffers(
-        cmds->gpu->device, cmds->gpu->queues.cmd_pools[cmds->queue_idx], //
-        cmds->count, cmds->cmds);
+        cmds->gpu->device, cmds->gpu->queues.cmd_pools[qf], cmds->count, cmds->cmds);
 
     dvz_obj_init(&cmds->obj);
 }
@@ -1732,6 +1798,18 @@ void dvz_compute_code(DvzCompute* compute, const char* code)
 
 
 
+void dvz_compute_spirv(DvzCompute* compute, VkDeviceSize size, const uint32_t* buffer)
+{
+    ASSERT(compute != NULL);
+    ASSERT(compute->gpu != NULL);
+    ASSERT(compute->gpu->device != VK_NULL_HANDLE);
+    ASSERT(size > 0);
+    ASSERT(buffer != NULL);
+    compute->shader_module = create_shader_module(compute->gpu->device, size, buffer);
+}
+
+
+
 void dvz_compute_slot(DvzCompute* compute, uint32_t idx, VkDescriptorType type)
 {
     ASSERT(compute != NULL);
@@ -1775,7 +1853,12 @@ void dvz_compute_create(DvzCompute* compute)
 
     log_trace("starting creation of compute...");
 
-    if (compute->shader_code != NULL)
+    // NOTE: the shader module already exists if the SPIRV code was set with dvz_compute_spirv().
+    if (compute->shader_module != VK_NULL_HANDLE)
+    {
+        log_trace("use the compute shader module created from the SPIRV code");
+    }
+    else if (compute->shader_code != NULL)
     {
         compute->shader_module =
             dvz_shader_compile(compute->gpu, compute->shader_code, VK_SHADER_STAGE_COMPUTE_BIT);
@@ -1787,7 +1870,7 @@ void dvz_compute_create(DvzCompute* compute)
     }
 
     create_compute_pipeline(
-        compute->gpu->device, compute->shader_module, //
+        compute->gpu->device, compute->gpu->pipeline_cache, compute->shader_module, //
         compute->slots.pipeline_layout, &compute->pipeline);
 
     dvz_obj_created(&compute->obj);
@@ -1975,6 +2058,57 @@ void dvz_graphics_front_face(DvzGraphics* graphics, VkFrontFace front_face)
 
 
 
+void dvz_specialization_constant(
+    DvzSpecialization* specialization, uint32_t constant_id, VkDeviceSize size, const void* value)
+{
+    ASSERT(specialization != NULL);
+    ASSERT(value != NULL);
+    if (size == 0 || size > sizeof(uint64_t))
+    {
+        log_error("invalid specialization constant size %d", (int)size);
+        return;
+    }
+
+    // Find the constant, or the position where to insert it so that the IDs remain sorted.
+    uint32_t n = specialization->count;
+    uint32_t i = 0;
+    while (i < n && specialization->entries[i].constantID < constant_id)
+        i++;
+    if (i == n || specialization->entries[i].constantID != constant_id)
+    {
+        if (n >= DVZ_MAX_SPECIALIZATION_CONSTANTS)
+        {
+            log_error("maximum number of specialization constants reached");
+            return;
+        }
+        memmove(
+            &specialization->entries[i + 1], &specialization->entries[i],
+            (n - i) * sizeof(VkSpecializationMapEntry));
+        memmove(
+            &specialization->data[i + 1], &specialization->data[i], (n - i) * sizeof(uint64_t));
+        specialization->count++;
+    }
+
+    // NOTE: the offsets are updated as the values may have moved.
+    for (uint32_t j = 0; j < specialization->count; j++)
+        specialization->entries[j].offset = j * sizeof(uint64_t);
+    specialization->entries[i].constantID = constant_id;
+    specialization->entries[i].size = (size_t)size;
+    specialization->data[i] = 0;
+    memcpy(&specialization->data[i], value, (size_t)size);
+}
+
+
+
+void dvz_graphics_specialization(
+    DvzGraphics* graphics, uint32_t constant_id, VkDeviceSize size, const void* value)
+{
+    ASSERT(graphics != NULL);
+    dvz_specialization_constant(&graphics->specialization, constant_id, size, value);
+}
+
+
+
 void dvz_graphics_slot(DvzGraphics* graphics, uint32_t idx, VkDescriptorType type)
 {
     ASSERT(graphics != NULL);
@@ -2029,6 +2163,13 @@ void dvz_graphics_create(DvzGraphics* graphics)
     vertex_input_info.vertexAttributeDescriptionCount = graphics->vertex_attr_count;
     vertex_input_info.pVertexAttributeDescriptions = attrs_info;
 
+    // Specialization constants.
+    VkSpecializationInfo specialization_info = {0};
+    specialization_info.mapEntryCount = graphics->specialization.count;
+    specialization_info.pMapEntries = graphics->specialization.entries;
+    specialization_info.dataSize = graphics->specialization.count * sizeof(uint64_t);
+    specialization_info.pData = graphics->specialization.data;
+
     // Shaders.
     VkPipelineShaderStageCreateInfo shader_stages[DVZ_MAX_SHADERS_PER_GRAPHICS] = {0};
     for (uint32_t i = 0; i < graphics->shader_count; i++)
@@ -2039,6 +2180,8 @@ void dvz_graphics_create(DvzGraphics* graphics)
         ASSERT(graphics->shader_stages[i] != VK_NULL_HANDLE);
         ASSERT(graphics->shader_modules[i] != NULL);
         shader_stages[i].pName = "main";
+        if (graphics->specialization.count > 0)
+            shader_stages[i].pSpecializationInfo = &specialization_info;
     }
 
     // Pipeline.
@@ -2077,7 +2220,8 @@ void dvz_graphics_create(DvzGraphics* graphics)
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
     VK_CHECK_RESULT(vkCreateGraphicsPipelines(
-        graphics->gpu->device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, &graphics->pipeline));
+        graphics->gpu->device, graphics->gpu->pipeline_cache, 1, &pipelineInfo, NULL,
+        &graphics->pipeline));
     if (graphics->pipeline != VK_NULL_HANDLE)
     {
         log_trace("graphics pipeline created");
@@ -2909,8 +3053,9 @@ void dvz_submit_reset(DvzSubmit* submit)
 /*  Command buffer filling                                                                       */
 /*************************************************************************************************/
 
-void dvz_cmd_begin_renderpass(
-    DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass, DvzFramebuffers* framebuffers)
+static void _begin_renderpass(
+    DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass, DvzFramebuffers* framebuffers,
+    VkSubpassContents contents)
 {
     ASSERT(renderpass != NULL);
     ASSERT(framebuffers != NULL);
@@ -2929,12 +3074,29 @@ void dvz_cmd_begin_renderpass(
     ASSERT(framebuffers->framebuffers[iclip] != VK_NULL_HANDLE);
     begin_render_pass(
         renderpass->renderpass, cb, framebuffers->framebuffers[iclip], //
-        width, height, renderpass->clear_count, renderpass->clear_values);
+        width, height, renderpass->clear_count, renderpass->clear_values, contents);
     CMD_END
 }
 
 
 
+void dvz_cmd_begin_renderpass(
+    DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass, DvzFramebuffers* framebuffers)
+{
+    _begin_renderpass(cmds, idx, renderpass, framebuffers, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+
+
+void dvz_cmd_begin_renderpass_secondary(
+    DvzCommands* cmds, uint32_t idx, DvzRenderpass* renderpass, DvzFramebuffers* framebuffers)
+{
+    _begin_renderpass(
+        cmds, idx, renderpass, framebuffers, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+}
+
+
+
 void dvz_cmd_end_renderpass(DvzCommands* cmds, uint32_t idx)
 {
     CMD_START
@@ -2944,6 +3106,19 @@ void dvz_cmd_end_renderpass(DvzCommands* cmds, uint32_t idx)
 
 
 
+void dvz_cmd_execute(DvzCommands* cmds, uint32_t idx, DvzCommands* secondary)
+{
+    ASSERT(secondary != NULL);
+    ASSERT(idx < secondary->count);
+    ASSERT(secondary->cmds[idx] != VK_NULL_HANDLE);
+
+    CMD_START
+    vkCmdExecuteCommands(cb, 1, &secondary->cmds[idx]);
+    CMD_END
+}
+
+
+
 void dvz_cmd_compute(DvzCommands* cmds, uint32_t idx, DvzCompute* compute, uvec3 size)
 {
     ASSERT(compute->bindings != NULL);
@@ -2979,7 +3154,7 @@ void dvz_cmd_barrier(DvzCommands* cmds, uint32_t idx, DvzBarrier* barrier)
         buffer_barrier = &buffer_barriers[j];
         buffer_info = &barrier->buffer_barriers[j];
 
-        buffer_barrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        buffer_barrier->sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
         buffer_barrier->buffer = buffer_info->br.buffer->buffer;
         buffer_barrier->size = buffer_info->br.size;
         ASSERT(i < buffer_info->br.count);
@@ -3049,6 +3224,21 @@ void dvz_cmd_barrier(DvzCommands* cmds, uint32_t idx, DvzBarrier* barrier)
 void dvz_cmd_copy_buffer_to_image(
     DvzCommands* cmds, uint32_t idx, DvzBuffer* buffer, DvzImages* images)
 {
+    dvz_cmd_copy_buffer_to_image_region(
+        cmds, idx, buffer, images, (uvec3){0, 0, 0},
+        (uvec3){images->width, images->height, images->depth});
+}
+
+
+
+void dvz_cmd_copy_buffer_to_image_region(
+    DvzCommands* cmds, uint32_t idx, DvzBuffer* buffer, DvzImages* images, uvec3 offset,
+    uvec3 shape)
+{
+    ASSERT(offset[0] + shape[0] <= images->width);
+    ASSERT(offset[1] + shape[1] <= images->height);
+    ASSERT(offset[2] + shape[2] <= images->depth);
+
     CMD_START_CLIP(images->count)
 
     VkBufferImageCopy region = {0};
@@ -3061,13 +3251,13 @@ void dvz_cmd_copy_buffer_to_image(
     region.imageSubresource.baseArrayLayer = 0;
     region.imageSubresource.layerCount = 1;
 
-    region.imageOffset.x = 0;
-    region.imageOffset.y = 0;
-    region.imageOffset.z = 0;
+    region.imageOffset.x = (int32_t)offset[0];
+    region.imageOffset.y = (int32_t)offset[1];
+    region.imageOffset.z = (int32_t)offset[2];
 
-    region.imageExtent.width = images->width;
-    region.imageExtent.height = images->height;
-    region.imageExtent.depth = images->depth;
+    region.imageExtent.width = shape[0];
+    region.imageExtent.height = shape[1];
+    region.imageExtent.depth = shape[2];
 
     vkCmdCopyBufferToImage(
         cb, buffer->buffer, images->images[iclip], //
@@ -3159,7 +3349,20 @@ void dvz_cmd_viewport(DvzCommands* cmds, uint32_t idx, VkViewport viewport)
 
 
 
-void dvz_cmd_bind_graphics(
+void dvz_cmd_bind_pipeline(DvzCommands* cmds, uint32_t idx, DvzGraphics* graphics)
+{
+    ASSERT(graphics != NULL);
+    if (!dvz_obj_is_created(&graphics->obj))
+        return;
+
+    CMD_START
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics->pipeline);
+    CMD_END
+}
+
+
+
+void dvz_cmd_bind_descriptors(
     DvzCommands* cmds, uint32_t idx, DvzGraphics* graphics, //
     DvzBindings* bindings, uint32_t dynamic_idx)
 {
@@ -3182,8 +3385,6 @@ void dvz_cmd_bind_graphics(
     }
 
     CMD_START_CLIP(bindings->dset_count)
-    if (dvz_obj_is_created(&graphics->obj))
-        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics->pipeline);
     vkCmdBindDescriptorSets(
         cb, VK_PIPELINE_BIND_POINT_GRAPHICS, slots->pipeline_layout, //
         0, 1, &bindings->dsets[iclip], dyn_count, dyn_offsets);
@@ -3192,6 +3393,16 @@ void dvz_cmd_bind_graphics(
 
 
 
+void dvz_cmd_bind_graphics(
+    DvzCommands* cmds, uint32_t idx, DvzGraphics* graphics, //
+    DvzBindings* bindings, uint32_t dynamic_idx)
+{
+    dvz_cmd_bind_pipeline(cmds, idx, graphics);
+    dvz_cmd_bind_descriptors(cmds, idx, graphics, bindings, dynamic_idx);
+}
+
+
+
 void dvz_cmd_bind_vertex_buffer(
     DvzCommands* cmds, uint32_t idx, DvzBufferRegions br, VkDeviceSize offset)
 {
@@ -3244,6 +3455,25 @@ void dvz_cmd_draw_indirect(DvzCommands* cmds, uint32_t idx, DvzBufferRegions ind
 
 
 
+void dvz_cmd_draw_indirect_multi(
+    DvzCommands* cmds, uint32_t idx, DvzBufferRegions indirect, uint32_t draw_count)
+{
+    ASSERT(draw_count > 0);
+    ASSERT(indirect.size >= draw_count * sizeof(VkDrawIndirectCommand));
+    CMD_START_CLIP(indirect.count)
+    VkDeviceSize stride = sizeof(VkDrawIndirectCommand);
+    if (cmds->gpu->requested_features.multiDrawIndirect)
+        vkCmdDrawIndirect(
+            cb, indirect.buffer->buffer, indirect.offsets[iclip], draw_count, (uint32_t)stride);
+    else
+        for (uint32_t k = 0; k < draw_count; k++)
+            vkCmdDrawIndirect(
+                cb, indirect.buffer->buffer, indirect.offsets[iclip] + k * stride, 1, 0);
+    CMD_END
+}
+
+
+
 void dvz_cmd_draw_indexed_indirect(DvzCommands* cmds, uint32_t idx, DvzBufferRegions indirect)
 {
     CMD_START_CLIP(indirect.count)
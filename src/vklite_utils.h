@@ -979,7 +979,8 @@ static void create_swapchain(
 /*************************************************************************************************/
 
 static void allocate_command_buffers(
-    VkDevice device, VkCommandPool command_pool, uint32_t count, VkCommandBuffer* cmd_bufs)
+    VkDevice device, VkCommandPool command_pool, VkCommandBufferLevel level, uint32_t count,
+    VkCommandBuffer* cmd_bufs)
 {
     ASSERT(count > 0);
     log_trace("allocate %d command buffer(s)", count);
@@ -989,7 +990,7 @@ static void allocate_command_buffers(
     VkCommandBufferAllocateInfo alloc_info = {0};
     alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     alloc_info.commandPool = command_pool;
-    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.level = level;
     alloc_info.commandBufferCount = count;
     VK_CHECK_RESULT(vkAllocateCommandBuffers(device, &alloc_info, cmd_bufs));
 }
@@ -1242,6 +1243,120 @@ static void create_texture_sampler2(
 
 
 
+/*************************************************************************************************/
+/*  Pipeline cache                                                                               */
+/*************************************************************************************************/
+
+static bool pipeline_cache_persistent(void)
+{
+    const char* env = getenv("DVZ_PIPELINE_CACHE");
+    return env == NULL || strcmp(env, "0") != 0;
+}
+
+
+
+// Path of the pipeline cache file, specific to the device and the driver version.
+static int pipeline_cache_path(DvzGpu* gpu, char* path, size_t size)
+{
+    ASSERT(gpu != NULL);
+    char dir[1024] = {0};
+    if (dvz_cache_dir(dir, sizeof(dir)) != 0)
+        return 1;
+
+    VkPhysicalDeviceProperties* props = &gpu->device_properties;
+    char uuid[2 * VK_UUID_SIZE + 1] = {0};
+    for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+        snprintf(&uuid[2 * i], 3, "%02x", props->pipelineCacheUUID[i]);
+    snprintf(
+        path, size, "%s/pipelines_%04x_%04x_%08x_%s.bin", dir, props->vendorID, props->deviceID,
+        props->driverVersion, uuid);
+    return 0;
+}
+
+
+
+// Check the header of the pipeline cache data, as some drivers crash on invalid data.
+static bool pipeline_cache_valid(DvzGpu* gpu, const uint8_t* data, size_t size)
+{
+    ASSERT(gpu != NULL);
+    uint32_t header[4] = {0}; // header size, header version, vendor ID, device ID
+    if (data == NULL || size < sizeof(header) + VK_UUID_SIZE)
+        return false;
+    memcpy(header, data, sizeof(header));
+
+    VkPhysicalDeviceProperties* props = &gpu->device_properties;
+    return header[0] >= sizeof(header) + VK_UUID_SIZE &&
+           header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && header[2] == props->vendorID &&
+           header[3] == props->deviceID &&
+           memcmp(data + sizeof(header), props->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+
+
+static void create_pipeline_cache(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    ASSERT(gpu->device != VK_NULL_HANDLE);
+
+    // Load the cache file if it exists.
+    char path[1024] = {0};
+    uint32_t* data = NULL;
+    size_t size = 0;
+    FILE* f = NULL;
+    if (pipeline_cache_persistent() && pipeline_cache_path(gpu, path, sizeof(path)) == 0 &&
+        (f = fopen(path, "rb")) != NULL)
+    {
+        fclose(f);
+        data = dvz_read_file(path, &size);
+        if (!pipeline_cache_valid(gpu, (const uint8_t*)data, size))
+        {
+            log_warn("ignore invalid pipeline cache file %s", path);
+            FREE(data);
+            size = 0;
+        }
+    }
+
+    VkPipelineCacheCreateInfo info = {0};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    info.initialDataSize = size;
+    info.pInitialData = data;
+    log_trace("create pipeline cache with %d bytes of initial data", (int)size);
+    VK_CHECK_RESULT(vkCreatePipelineCache(gpu->device, &info, NULL, &gpu->pipeline_cache));
+    gpu->pipeline_cache_size = size;
+    FREE(data);
+}
+
+
+
+static void destroy_pipeline_cache(DvzGpu* gpu)
+{
+    ASSERT(gpu != NULL);
+    if (gpu->pipeline_cache == VK_NULL_HANDLE)
+        return;
+
+    // Only save the cache file if pipelines have been added to the cache.
+    char path[1024] = {0};
+    size_t size = 0;
+    vkGetPipelineCacheData(gpu->device, gpu->pipeline_cache, &size, NULL);
+    if (size > 0 && size != gpu->pipeline_cache_size && pipeline_cache_persistent() &&
+        pipeline_cache_path(gpu, path, sizeof(path)) == 0)
+    {
+        void* data = malloc(size);
+        if (vkGetPipelineCacheData(gpu->device, gpu->pipeline_cache, &size, data) == VK_SUCCESS)
+        {
+            log_debug("save pipeline cache file %s (%d bytes)", path, (int)size);
+            dvz_write_file(path, size, data);
+        }
+        FREE(data);
+    }
+
+    log_trace("destroy pipeline cache");
+    vkDestroyPipelineCache(gpu->device, gpu->pipeline_cache, NULL);
+    gpu->pipeline_cache = VK_NULL_HANDLE;
+}
+
+
+
 /*************************************************************************************************/
 /*  Bindings                                                                                     */
 /*************************************************************************************************/
@@ -1475,8 +1590,8 @@ static VkShaderModule create_shader_module_from_file(VkDevice device, const char
 /*************************************************************************************************/
 
 static void create_compute_pipeline(
-    VkDevice device, VkShaderModule shader_module, VkPipelineLayout pipeline_layout,
-    VkPipeline* pipeline)
+    VkDevice device, VkPipelineCache pipeline_cache, VkShaderModule shader_module,
+    VkPipelineLayout pipeline_layout, VkPipeline* pipeline)
 {
     // Create the shader and pipeline.
     VkComputePipelineCreateInfo pipelineInfo = {0};
@@ -1488,7 +1603,7 @@ static void create_compute_pipeline(
     pipelineInfo.stage.module = shader_module;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     VK_CHECK_RESULT(
-        vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, pipeline));
+        vkCreateComputePipelines(device, pipeline_cache, 1, &pipelineInfo, NULL, pipeline));
 }
 
 
@@ -1642,7 +1757,8 @@ static VkAttachmentReference create_attachment_ref(uint32_t attachment, VkImageL
 
 static void begin_render_pass(
     VkRenderPass renderpass, VkCommandBuffer cmd_buf, VkFramebuffer framebuffer, //
-    uint32_t width, uint32_t height, uint32_t clear_count, VkClearValue* clear_colors)
+    uint32_t width, uint32_t height, uint32_t clear_count, VkClearValue* clear_colors,
+    VkSubpassContents contents)
 {
     ASSERT(renderpass != VK_NULL_HANDLE);
     ASSERT(framebuffer != VK_NULL_HANDLE);
@@ -1657,7 +1773,7 @@ static void begin_render_pass(
     render_pass_info.renderArea = renderArea;
     render_pass_info.clearValueCount = clear_count;
     render_pass_info.pClearValues = clear_colors;
-    vkCmdBeginRenderPass(cmd_buf, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(cmd_buf, &render_pass_info, contents);
 }
 
 #endif